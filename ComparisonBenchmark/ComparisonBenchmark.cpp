@@ -0,0 +1,500 @@
+#include "ComparisonBenchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <source_location>
+#include <sstream>
+#include <streambuf>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <link.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <QDebug>
+#include <QString>
+#include <QTest>
+
+#include "../LogDecoder/SymbolIndex.h"
+#include "../Logger/Logger.h"
+#include "../Logger/MirroredLogger.h"
+
+namespace
+{
+constexpr int s_callsPerThread = 10'000;
+constexpr std::string_view s_text = "0123456789abcdef";
+
+/// The programs in ExistingApproaches, and Baseline for the cost of the measurement itself
+enum class Approach
+{
+    QtLogging,
+    Iostream,
+    SourceLocation,
+    Logger,
+    MirroredLogger,
+    Baseline,
+};
+constexpr std::array<const char *, 5> s_approachNames{"qDebug", "iostream", "source_location", "Logger", "MirroredLogger"};
+
+/// The loggers of Approach::Logger and Approach::MirroredLogger
+template <std::size_t sizeLog2>
+struct Loggers
+{
+    Logger<sizeLog2> plain;
+    MirroredLogger<sizeLog2> mirrored;
+};
+using BenchmarkLoggers = Loggers<24u>;
+
+/// As in ExistingApproaches/03-SourceLocation, with arguments
+template <typename... Ts>
+void log(const std::source_location location, const Ts... args)
+{
+    std::cout << location.file_name() << "(" << location.line() << ") " << location.function_name() << ": message";
+    ((std::cout << ' ' << args), ...);
+    std::cout << '\n';
+}
+
+template <typename T>
+auto printable(const T t)
+{
+    if constexpr (std::is_same_v<T, std::string_view>)
+    {
+        return QLatin1String(t.data(), static_cast<qsizetype>(t.size()));
+    }
+    else
+    {
+        return t;
+    }
+}
+
+/// One call of the approach with the arguments
+template <Approach approach, std::size_t sizeLog2, typename... Ts>
+inline void call(Loggers<sizeLog2> &loggers, const Ts... args) __attribute__((always_inline))
+{
+    if constexpr (approach == Approach::QtLogging)
+    {
+        ((qDebug() << "message") << ... << printable(args));
+    }
+    else if constexpr (approach == Approach::Iostream)
+    {
+        // NOTE: the LOG macro of ExistingApproaches/02-iostream
+        std::cout << __FILE__ << "(" << __LINE__ << ") " << __FUNCTION__ << ": message";
+        ((std::cout << ' ' << args), ...);
+        std::cout << "\n";
+    }
+    else if constexpr (approach == Approach::SourceLocation)
+    {
+        log(std::source_location::current(), args...);
+    }
+    else if constexpr (approach == Approach::Logger)
+    {
+        loggers.plain.trace(args...);
+    }
+    else if constexpr (approach == Approach::MirroredLogger)
+    {
+        loggers.mirrored.trace(args...);
+    }
+}
+
+/// The first argumentCount of an int, a double, a std::uint64_t and a std::string_view
+template <std::size_t argumentCount>
+inline auto arguments(const int i) __attribute__((always_inline))
+{
+    const auto all = std::make_tuple(i, 0.5 * i, std::uint64_t{0xC0FFEE}, s_text);
+    return [&all]<std::size_t... Is>(std::index_sequence<Is...>) { return std::make_tuple(std::get<Is>(all)...); }(std::make_index_sequence<argumentCount>());
+}
+
+/// Calls f.template operator()<approach, argumentCount>() for the run-time values
+template <typename F>
+void dispatch(const Approach approach, const int argumentCount, F &&f)
+{
+    const auto withArguments = [&]<Approach a>() {
+        switch (argumentCount)
+        {
+        case 0:
+            f.template operator()<a, 0u>();
+            break;
+        case 1:
+            f.template operator()<a, 1u>();
+            break;
+        case 2:
+            f.template operator()<a, 2u>();
+            break;
+        case 3:
+            f.template operator()<a, 3u>();
+            break;
+        case 4:
+            f.template operator()<a, 4u>();
+            break;
+        }
+    };
+    switch (approach)
+    {
+    case Approach::QtLogging:
+        withArguments.template operator()<Approach::QtLogging>();
+        break;
+    case Approach::Iostream:
+        withArguments.template operator()<Approach::Iostream>();
+        break;
+    case Approach::SourceLocation:
+        withArguments.template operator()<Approach::SourceLocation>();
+        break;
+    case Approach::Logger:
+        withArguments.template operator()<Approach::Logger>();
+        break;
+    case Approach::MirroredLogger:
+        withArguments.template operator()<Approach::MirroredLogger>();
+        break;
+    case Approach::Baseline:
+        withArguments.template operator()<Approach::Baseline>();
+        break;
+    }
+}
+
+/// Instructions and cache misses of the calling thread, if the kernel allows perf_event_open
+class PerfCounters
+{
+public:
+    PerfCounters()
+        : m_instructions(open(PERF_COUNT_HW_INSTRUCTIONS, -1))
+        , m_cacheMisses(m_instructions >= 0 ? open(PERF_COUNT_HW_CACHE_MISSES, m_instructions) : -1)
+    {
+    }
+    ~PerfCounters()
+    {
+        for (const int fd : {m_cacheMisses, m_instructions})
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+    }
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    bool available() const
+    {
+        return m_cacheMisses >= 0;
+    }
+    void start()
+    {
+        if (available())
+        {
+            ::ioctl(m_instructions, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ::ioctl(m_instructions, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+    /// Instructions and cache misses since start
+    std::pair<std::uint64_t, std::uint64_t> stop()
+    {
+        // NOTE: PERF_FORMAT_GROUP, the number of counters followed by their values
+        std::array<std::uint64_t, 3> values{};
+        if (!available() || ::ioctl(m_instructions, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP) != 0 || ::read(m_instructions, values.data(), sizeof(values)) != sizeof(values))
+        {
+            return {0u, 0u};
+        }
+        return {values[1], values[2]};
+    }
+
+private:
+    static int open(const std::uint64_t config, const int group)
+    {
+        perf_event_attr attributes{};
+        attributes.size = sizeof(attributes);
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = config;
+        attributes.disabled = group < 0 ? 1 : 0;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        attributes.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, group, PERF_FLAG_FD_CLOEXEC));
+    }
+
+    int m_instructions;
+    int m_cacheMisses;
+};
+
+/// Discards the output of std::cout, counting the bytes
+class CountingBuffer : public std::streambuf
+{
+public:
+    std::size_t bytes() const
+    {
+        return m_bytes;
+    }
+
+protected:
+    std::streamsize xsputn(const char *, const std::streamsize count) override
+    {
+        m_bytes += static_cast<std::size_t>(count);
+        return count;
+    }
+    int_type overflow(const int_type c) override
+    {
+        ++m_bytes;
+        return traits_type::not_eof(c);
+    }
+
+private:
+    std::size_t m_bytes = 0u;
+};
+
+std::atomic<std::size_t> s_qtBytes{0u};
+
+/// Formats and writes the messages into stderr like the default handler does, counting the bytes
+void writeQtMessage(const QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    const QByteArray line = qFormatLogMessage(type, context, message).toLocal8Bit() + '\n';
+    s_qtBytes.fetch_add(static_cast<std::size_t>(line.size()), std::memory_order_relaxed);
+    std::fwrite(line.constData(), 1u, static_cast<std::size_t>(line.size()), stderr);
+}
+
+/// Routes qDebug as in ExistingApproaches/01-QtLogging, instead of into the test log
+class QtOutput
+{
+public:
+    QtOutput()
+        : m_previous(qInstallMessageHandler(&writeQtMessage))
+    {
+        qSetMessagePattern("%{time} file: %{file}(%{line}) `%{function}`:%{message}");
+    }
+    ~QtOutput()
+    {
+        qSetMessagePattern(QString());
+        qInstallMessageHandler(m_previous);
+    }
+    QtOutput(const QtOutput &) = delete;
+    QtOutput &operator=(const QtOutput &) = delete;
+
+private:
+    QtMessageHandler m_previous;
+};
+
+/// Sends stdout and stderr to /dev/null while it lives, such that the terminal does not dominate
+class NullOutput
+{
+public:
+    NullOutput()
+        : m_stdout(::dup(STDOUT_FILENO))
+        , m_stderr(::dup(STDERR_FILENO))
+    {
+        std::cout.flush();
+        std::fflush(nullptr);
+        const int null = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+        ::dup2(null, STDOUT_FILENO);
+        ::dup2(null, STDERR_FILENO);
+        ::close(null);
+    }
+    ~NullOutput()
+    {
+        std::cout.flush();
+        std::fflush(nullptr);
+        ::dup2(m_stdout, STDOUT_FILENO);
+        ::dup2(m_stderr, STDERR_FILENO);
+        ::close(m_stdout);
+        ::close(m_stderr);
+    }
+    NullOutput(const NullOutput &) = delete;
+    NullOutput &operator=(const NullOutput &) = delete;
+
+private:
+    int m_stdout;
+    int m_stderr;
+};
+
+struct Measurement
+{
+    std::vector<std::int64_t> ticks; /// of the cycle counter, per call
+    std::uint64_t instructions = 0u;
+    std::uint64_t cacheMisses = 0u;
+    bool counted = true; /// whether perf_event was available in every thread
+};
+
+/// Times every call of every thread on its own
+template <Approach approach, std::size_t argumentCount>
+Measurement measure(BenchmarkLoggers &loggers, const int threadCount)
+{
+    std::vector<Measurement> perThread(static_cast<std::size_t>(threadCount));
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(perThread.size());
+        for (Measurement &measurement : perThread)
+        {
+            threads.emplace_back([&loggers, &measurement] {
+                PerfCounters counters;
+                measurement.ticks.resize(s_callsPerThread);
+                counters.start();
+                for (int i = 0; i < s_callsPerThread; ++i)
+                {
+                    const auto begin = Clocks::CycleCounter::now();
+                    std::apply([&loggers](const auto... args) { call<approach>(loggers, args...); }, arguments<argumentCount>(i));
+                    measurement.ticks[static_cast<std::size_t>(i)] = Clocks::CycleCounter::now() - begin;
+                }
+                std::tie(measurement.instructions, measurement.cacheMisses) = counters.stop();
+                measurement.counted = counters.available();
+            });
+        }
+    }
+    Measurement total;
+    for (const Measurement &measurement : perThread)
+    {
+        total.ticks.insert(total.ticks.end(), measurement.ticks.begin(), measurement.ticks.end());
+        total.instructions += measurement.instructions;
+        total.cacheMisses += measurement.cacheMisses;
+        total.counted = total.counted && measurement.counted;
+    }
+    return total;
+}
+
+/// Bytes that reach the output per call: the file for the streams, the buffers for the loggers
+template <Approach approach, std::size_t argumentCount>
+double bytesPerCall()
+{
+    constexpr int callCount = 100;
+    const auto loggers = std::make_unique<Loggers<16u>>();
+    // NOTE: the difference between two dumps leaves out what writeTo adds once
+    const auto dumpSize = [&loggers] {
+        std::ostringstream s;
+        loggers->plain.writeTo(s);
+        loggers->mirrored.writeTo(s);
+        return s.view().size();
+    };
+    const std::size_t dumpBefore = dumpSize();
+    const std::size_t qtBefore = s_qtBytes.load();
+    CountingBuffer counting;
+    std::streambuf *const previous = std::cout.rdbuf(&counting);
+    for (int i = 0; i < callCount; ++i)
+    {
+        std::apply([&loggers](const auto... args) { call<approach>(*loggers, args...); }, arguments<argumentCount>(i));
+    }
+    std::cout.rdbuf(previous);
+    return static_cast<double>(dumpSize() - dumpBefore + s_qtBytes.load() - qtBefore + counting.bytes()) / callCount;
+}
+
+double percentile(std::vector<std::int64_t> &ticks, const double fraction)
+{
+    const auto nth = ticks.begin() + static_cast<std::ptrdiff_t>(fraction * static_cast<double>(ticks.size() - 1u));
+    std::nth_element(ticks.begin(), nth, ticks.end());
+    return static_cast<double>(*nth);
+}
+
+double ticksPerNanosecond()
+{
+    static const double s_ticksPerNanosecond = Clocks::CycleCounter::calibration().ticksPerSecond / 1e9;
+    return s_ticksPerNanosecond;
+}
+
+/// One call, such that the size of the function is the code of the call site
+template <Approach approach, std::size_t argumentCount>
+void callSite(BenchmarkLoggers &loggers, const int i) __attribute__((noinline))
+{
+    std::apply([&loggers](const auto... args) { call<approach>(loggers, args...); }, arguments<argumentCount>(i));
+}
+
+std::size_t functionSize(const std::uintptr_t address)
+{
+    static LogDecoder::SymbolIndex s_symbols("/proc/self/exe");
+    // NOTE: the executable is the first object
+    std::intptr_t loadBias = 0;
+    dl_iterate_phdr([](dl_phdr_info *info, std::size_t, void *data) {
+        *static_cast<std::intptr_t *>(data) = static_cast<std::intptr_t>(info->dlpi_addr);
+        return 1;
+    }, &loadBias);
+    s_symbols.setLoadBias(loadBias);
+    const LogDecoder::SymbolIndex::Symbol *symbol = s_symbols.resolve(address);
+    return symbol != nullptr ? symbol->end - symbol->begin : 0u;
+}
+} // namespace
+
+// NOTE: the cycle counter around every call, minus the median of an empty call
+void ComparisonBenchmark::callCost_data()
+{
+    QTest::addColumn<int>("approach");
+    QTest::addColumn<int>("argumentCount");
+    QTest::addColumn<int>("threadCount");
+    const int maxThreadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int approach = 0; approach < static_cast<int>(s_approachNames.size()); ++approach)
+    {
+        for (int argumentCount = 0; argumentCount <= 4; ++argumentCount)
+        {
+            for (int threadCount = 1; threadCount < maxThreadCount; threadCount *= 2)
+            {
+                QTest::addRow("%s, %d arguments, %d threads", s_approachNames[static_cast<std::size_t>(approach)], argumentCount, threadCount) << approach << argumentCount << threadCount;
+            }
+            QTest::addRow("%s, %d arguments, %d threads", s_approachNames[static_cast<std::size_t>(approach)], argumentCount, maxThreadCount) << approach << argumentCount << maxThreadCount;
+        }
+    }
+}
+
+void ComparisonBenchmark::callCost()
+{
+    QFETCH(int, approach);
+    QFETCH(int, argumentCount);
+    QFETCH(int, threadCount);
+    const auto loggers = std::make_unique<BenchmarkLoggers>();
+    Measurement baseline;
+    Measurement measurement;
+    double bytes = 0.0;
+    {
+        const QtOutput qtOutput;
+        const NullOutput nullOutput;
+        baseline = measure<Approach::Baseline, 0u>(*loggers, 1);
+        dispatch(static_cast<Approach>(approach), argumentCount, [&]<Approach a, std::size_t n>() {
+            measurement = measure<a, n>(*loggers, threadCount);
+            bytes = bytesPerCall<a, n>();
+        });
+    }
+
+    const double overhead = percentile(baseline.ticks, 0.5);
+    const auto nanoseconds = [&](const double fraction) { return std::max(0.0, percentile(measurement.ticks, fraction) - overhead) / ticksPerNanosecond(); };
+    qDebug() << "ns/call median:" << nanoseconds(0.5) << "p99:" << nanoseconds(0.99) << "p99.9:" << nanoseconds(0.999) << "bytes/call:" << bytes;
+    if (measurement.counted && baseline.counted)
+    {
+        const auto perCall = [](const std::uint64_t count, const Measurement &m) { return static_cast<double>(count) / static_cast<double>(m.ticks.size()); };
+        qDebug() << "instructions/call:" << perCall(measurement.instructions, measurement) - perCall(baseline.instructions, baseline)
+                 << "cache misses/call:" << perCall(measurement.cacheMisses, measurement) - perCall(baseline.cacheMisses, baseline);
+    }
+    else
+    {
+        qDebug() << "No perf_event counters, see /proc/sys/kernel/perf_event_paranoid";
+    }
+}
+
+void ComparisonBenchmark::codeSize_data()
+{
+    QTest::addColumn<int>("approach");
+    QTest::addColumn<int>("argumentCount");
+    for (int approach = 0; approach < static_cast<int>(s_approachNames.size()); ++approach)
+    {
+        for (int argumentCount = 0; argumentCount <= 4; ++argumentCount)
+        {
+            QTest::addRow("%s, %d arguments", s_approachNames[static_cast<std::size_t>(approach)], argumentCount) << approach << argumentCount;
+        }
+    }
+}
+
+// NOTE: the size of a function with one call, minus that of a function without
+void ComparisonBenchmark::codeSize()
+{
+    QFETCH(int, approach);
+    QFETCH(int, argumentCount);
+    const std::size_t baseline = functionSize(reinterpret_cast<std::uintptr_t>(&callSite<Approach::Baseline, 0u>));
+    std::size_t size = 0u;
+    dispatch(static_cast<Approach>(approach), argumentCount, [&]<Approach a, std::size_t n>() { size = functionSize(reinterpret_cast<std::uintptr_t>(&callSite<a, n>)); });
+    QVERIFY(size > 0u);
+    qDebug() << "bytes/call site:" << size - std::min(size, baseline);
+}
+
+QTEST_APPLESS_MAIN(ComparisonBenchmark)
@@ -0,0 +1,19 @@
+#ifndef COMPARISON_BENCHMARK_H
+#define COMPARISON_BENCHMARK_H
+
+#include <QObject>
+
+/// Logger::trace against the programs in ExistingApproaches, per call and per call site
+class ComparisonBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void callCost_data();
+    void callCost();
+
+    void codeSize_data();
+    void codeSize();
+};
+
+#endif // COMPARISON_BENCHMARK_H
@@ -0,0 +1,16 @@
+QT = core testlib
+
+include("../GlobalSettings.pri")
+
+HEADERS += ComparisonBenchmark.h
+SOURCES += ComparisonBenchmark.cpp
+
+CONFIG += release
+DEFINES += ARM
+HEADERS += ../Logger/Logger.h
+HEADERS += ../Logger/MirroredLogger.h
+
+# Logging context for qDebug, as in ExistingApproaches/01-QtLogging
+DEFINES += QT_MESSAGELOGCONTEXT
+
+include("../LogDecoder/LogDecoder.pri")
@@ -0,0 +1,39 @@
+#include "CallSiteControl.h"
+
+#include <mutex>
+#include <stdexcept>
+
+#include "../Logger/Logger.h"
+#include "SymbolIndex.h"
+
+namespace LogDecoder
+{
+namespace
+{
+constexpr std::string_view s_mangledTagPrefix = "_ZN7Details19LoggerTraceTypeInfoI";
+} // namespace
+
+std::size_t setCallSitesEnabled(const std::string_view function, const bool enabled)
+{
+    static std::mutex s_mutex;
+    const std::lock_guard lock(s_mutex);
+    static SymbolIndex s_symbols("/proc/self/exe");
+
+    const std::span<Details::CallSite> callSites = Details::callSites();
+    // NOTE: every call site refers to a type tag, so the first one fixes the load bias
+    if (callSites.empty() || !s_symbols.inferLoadBias(callSites.front().m_traceInnerInstance, s_mangledTagPrefix, callSites.front().m_traceCallSite))
+    {
+        throw std::runtime_error("Cannot resolve the call sites of this process");
+    }
+    std::size_t count = 0u;
+    for (Details::CallSite &callSite : callSites)
+    {
+        if (s_symbols.resolveFunction(callSite.m_traceCallSite).find(function) != std::string::npos)
+        {
+            callSite.setEnabled(enabled);
+            ++count;
+        }
+    }
+    return count;
+}
+} // namespace LogDecoder
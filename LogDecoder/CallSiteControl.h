@@ -0,0 +1,17 @@
+#ifndef CALL_SITE_CONTROL_H
+#define CALL_SITE_CONTROL_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace LogDecoder
+{
+/// Enables or disables the call sites of this process in the functions whose demangled name
+/// contains the pattern, returns how many
+///
+/// The symbols come from /proc/self/exe, read on the first call. See CallSites::setEnabled
+/// to select the call sites by address instead.
+std::size_t setCallSitesEnabled(std::string_view function, bool enabled);
+} // namespace LogDecoder
+
+#endif // CALL_SITE_CONTROL_H
@@ -0,0 +1,282 @@
+#include "Collector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LogDecoder
+{
+class Collector::Ring
+{
+public:
+    using BlockOffset = Details::RingLayout<0u>::BlockOffset;
+    static constexpr BlockOffset noRecord = Details::RingLayout<0u>::noRecord;
+
+    Ring(const std::string &path, std::string name)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+        }
+        struct stat status;
+        if (::fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(Details::MappedHeader))
+        {
+            ::close(fd);
+            throw std::runtime_error("Missing ring header in " + path);
+        }
+        m_inode = status.st_ino;
+        // NOTE: shared, such that the records appear as the producer writes them
+        void *mapping = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            throw std::runtime_error("Cannot map " + path + ": " + std::strerror(errno));
+        }
+        m_data = {static_cast<const char *>(mapping), static_cast<std::size_t>(status.st_size)};
+        try
+        {
+            m_ring = SharedRing{path, std::move(name), readRingHeader(m_data)};
+        }
+        catch (...)
+        {
+            ::munmap(mapping, m_data.size());
+            throw;
+        }
+        // NOTE: the oldest record of a wrapped ring is likely torn, collect has it skipped
+        const std::uint64_t tail = this->tail();
+        m_position = std::max(tail, bufferSize()) - bufferSize();
+        m_atRecord = m_position == 0u;
+        m_lastTail = tail;
+    }
+    ~Ring()
+    {
+        ::munmap(const_cast<char *>(m_data.data()), m_data.size());
+    }
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    const SharedRing &ring() const
+    {
+        return m_ring;
+    }
+    bool exited() const
+    {
+        return ::kill(static_cast<pid_t>(m_ring.header.pid), 0) != 0 && errno == ESRCH;
+    }
+    /// Whether the process created a logger of the same name again, whose file took the path
+    bool replaced() const
+    {
+        struct stat status;
+        return ::stat(m_ring.path.c_str(), &status) == 0 && status.st_ino != m_inode;
+    }
+
+    /// Hands the complete records since the previous call to the sink, all of them if the
+    /// process exited, returns their size
+    std::size_t collect(const Sink &sink, const bool exited)
+    {
+        const std::uint64_t tail = this->tail();
+        if (tail < m_lastTail)
+        {
+            // NOTE: the logger got cleared
+            m_position = 0u;
+            m_atRecord = true;
+            m_candidate.reset();
+            m_complete = 0u;
+        }
+        m_lastTail = tail;
+        const std::uint64_t end = exited ? tail : std::min(complete(), tail);
+        if (end <= m_position)
+        {
+            return 0u;
+        }
+
+        std::uint64_t begin = m_position;
+        std::uint64_t lostBytes = 0u;
+        if (end - begin > bufferSize())
+        {
+            lostBytes = end - bufferSize() - begin;
+            begin = end - bufferSize();
+            m_atRecord = false;
+        }
+        // Copy, then drop from the front whatever the producer overwrote meanwhile, as CircularBuffer::copyTo does
+        m_copy.resize(end - begin);
+        const std::uint64_t modBegin = begin % bufferSize();
+        const std::uint64_t firstPart = std::min(end - begin, bufferSize() - modBegin);
+        const char *buffer = m_data.data() + m_ring.header.bufferOffset;
+        std::memcpy(m_copy.data(), buffer + modBegin, firstPart);
+        std::memcpy(m_copy.data() + firstPart, buffer, end - begin - firstPart);
+        const std::uint64_t firstBlock = begin / blockSize() + 1u;
+        std::vector<BlockOffset> offsets;
+        for (std::uint64_t block = firstBlock; block * blockSize() < end; ++block)
+        {
+            offsets.push_back(blockOffset(block % (bufferSize() / blockSize())));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const std::uint64_t valid = std::max(this->tail(), bufferSize()) - bufferSize();
+        std::uint64_t first = begin;
+        if (!m_atRecord || valid > begin)
+        {
+            first = end;
+            for (std::uint64_t block = std::max(firstBlock, valid / blockSize() + 1u); block * blockSize() < end; ++block)
+            {
+                if (const BlockOffset offset = offsets[block - firstBlock]; offset != noRecord)
+                {
+                    first = std::min(end, block * blockSize() + offset);
+                    break;
+                }
+            }
+        }
+        lostBytes += first - begin;
+        m_position = end;
+        m_atRecord = true;
+        sink(m_ring, std::span<const char>(m_copy).subspan(first - begin), lostBytes);
+        return end - first;
+    }
+
+private:
+    /// Writers that were in flight when the tail was read, see Details::MappedHeader
+    struct Candidate
+    {
+        std::uint64_t tail;
+        std::vector<std::pair<std::size_t, std::uint64_t>> busySlots; /// index and odd sequence
+        bool busyOverflow; /// whether writers without a slot were in flight
+    };
+
+    /// Non-modulo position up to which every record is complete
+    ///
+    /// NOTE: read the tail, then the slots, as WriterSlot::waitForWriters. Rather than waiting,
+    /// a later call checks whether the writers in flight moved on.
+    std::uint64_t complete()
+    {
+        if (m_candidate && std::ranges::all_of(m_candidate->busySlots, [this](const auto &busy) { return writerSlot(busy.first) != busy.second; })
+            && (!m_candidate->busyOverflow || overflowWriters() == 0u))
+        {
+            m_complete = m_candidate->tail;
+            m_candidate.reset();
+        }
+        if (!m_candidate)
+        {
+            Candidate candidate{tail(), {}, false};
+            for (std::size_t slot = 0u; slot < m_ring.header.writerSlotCount; ++slot)
+            {
+                if (const std::uint64_t sequence = writerSlot(slot); sequence % 2u != 0u)
+                {
+                    candidate.busySlots.emplace_back(slot, sequence);
+                }
+            }
+            candidate.busyOverflow = overflowWriters() != 0u;
+            if (candidate.busySlots.empty() && !candidate.busyOverflow)
+            {
+                m_complete = candidate.tail;
+            }
+            else
+            {
+                m_candidate = std::move(candidate);
+            }
+        }
+        return m_complete;
+    }
+
+    std::uint64_t bufferSize() const
+    {
+        return m_ring.header.bufferSize;
+    }
+    std::uint64_t blockSize() const
+    {
+        return m_ring.header.blockSize;
+    }
+    std::uint64_t tail() const
+    {
+        return reinterpret_cast<const std::atomic<std::uint64_t> *>(m_data.data() + offsetof(Details::MappedHeader, nonModTail))->load(std::memory_order_acquire);
+    }
+    std::uint64_t writerSlot(const std::size_t slot) const
+    {
+        return reinterpret_cast<const Details::MappedWriterSlot *>(m_data.data() + m_ring.header.writerSlotsOffset)[slot].sequence.load(std::memory_order_acquire);
+    }
+    std::uint64_t overflowWriters() const
+    {
+        return reinterpret_cast<const std::atomic<std::uint64_t> *>(m_data.data() + offsetof(Details::MappedHeader, overflowWriters))->load(std::memory_order_acquire);
+    }
+    BlockOffset blockOffset(const std::uint64_t block) const
+    {
+        return reinterpret_cast<const std::atomic<BlockOffset> *>(m_data.data() + m_ring.header.blockOffsetsOffset)[block].load(std::memory_order_relaxed);
+    }
+
+    std::span<const char> m_data;
+    SharedRing m_ring;
+    std::uint64_t m_position = 0u; /// non-modulo, collected up to here
+    bool m_atRecord = true; /// whether m_position is the start of a record
+    std::uint64_t m_lastTail = 0u; /// at the previous collect
+    std::uint64_t m_complete = 0u; /// non-modulo, every record before is complete
+    std::optional<Candidate> m_candidate; /// tail that becomes complete once its writers moved on
+    ino_t m_inode = 0u; /// of the mapped file
+    std::vector<char> m_copy;
+};
+
+Collector::Collector(std::string directory)
+    : m_directory(std::move(directory))
+{
+}
+
+Collector::~Collector() = default;
+
+std::size_t Collector::poll(const Sink &sink)
+{
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(m_directory, error))
+    {
+        const std::string fileName = entry.path().filename().string();
+        if (!fileName.starts_with(Details::s_sharedRingPrefix) || m_rings.contains(entry.path().string()))
+        {
+            continue;
+        }
+        const std::size_t nameBegin = fileName.find('.', Details::s_sharedRingPrefix.size());
+        try
+        {
+            m_rings.emplace(entry.path().string(), std::make_unique<Ring>(entry.path().string(), nameBegin == std::string::npos ? std::string() : fileName.substr(nameBegin + 1u)));
+        }
+        catch (const std::runtime_error &)
+        {
+            // NOTE: a ring that is still being set up, the next poll will see it complete
+        }
+    }
+
+    std::size_t bytes = 0u;
+    for (auto it = m_rings.begin(); it != m_rings.end();)
+    {
+        // NOTE: checked first, such that the final collect sees every record of the process
+        const bool exited = it->second->exited();
+        // NOTE: the logger of the previous file is gone, the next poll maps the new one
+        const bool replaced = !exited && it->second->replaced();
+        bytes += it->second->collect(sink, exited || replaced);
+        if (replaced)
+        {
+            it = m_rings.erase(it);
+        }
+        else if (exited)
+        {
+            ::unlink(it->first.c_str());
+            it = m_rings.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    return bytes;
+}
+} // namespace LogDecoder
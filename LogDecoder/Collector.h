@@ -0,0 +1,59 @@
+#ifndef COLLECTOR_H
+#define COLLECTOR_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "../Logger/SharedLogger.h"
+#include "Recovery.h"
+
+namespace LogDecoder
+{
+/// Ring of a SharedLogger, as found by a Collector
+struct SharedRing
+{
+    std::string path;
+    std::string name; /// of the logger, unique within its process
+    RingHeader header; /// the pid, build id and calibration among others
+};
+
+/// Collects the records of the SharedLoggers of all processes on the host while they trace
+///
+/// Each poll copies what the rings received since the previous poll straight out of the
+/// shared pages, the producers neither wait nor make a syscall for it. Only complete records
+/// are taken: each writer marks itself in flight in the ring, see Details::MappedHeader, and
+/// the records before a tail are taken once the writers in flight at the time moved on.
+/// Whatever got overwritten before it was collected counts as lost. Once a process exited,
+/// the rest of its rings is collected and their files are removed.
+class Collector
+{
+public:
+    /// Records of a ring since the previous poll, in the Plain format, from a record boundary on
+    using Sink = std::function<void(const SharedRing &ring, std::span<const char> records, std::uint64_t lostBytes)>;
+
+    explicit Collector(std::string directory = std::string(Details::s_sharedRingDirectory));
+    ~Collector();
+    Collector(const Collector &) = delete;
+    Collector &operator=(const Collector &) = delete;
+
+    /// Picks up new rings and hands the new records of every ring to the sink, returns their bytes
+    std::size_t poll(const Sink &sink);
+
+    std::size_t ringCount() const
+    {
+        return m_rings.size();
+    }
+
+private:
+    class Ring;
+
+    const std::string m_directory;
+    std::map<std::string, std::unique_ptr<Ring>> m_rings; /// by path
+};
+} // namespace LogDecoder
+
+#endif // COLLECTOR_H
@@ -0,0 +1,428 @@
+#include "Compression.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+namespace LogDecoder
+{
+namespace
+{
+constexpr std::size_t s_recordHeaderSize = sizeof(std::int64_t) + 2 * sizeof(std::uintptr_t);
+
+void appendVarint(std::string &s, std::uint64_t value)
+{
+    while (value >= 0x80u)
+    {
+        s.push_back(static_cast<char>(value | 0x80u));
+        value >>= 7;
+    }
+    s.push_back(static_cast<char>(value));
+}
+
+std::uint64_t zigzag(const std::int64_t value)
+{
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t unzigzag(const std::uint64_t value)
+{
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1u);
+}
+
+/// Difference of two values of size bytes, as a signed number of that size
+std::int64_t difference(const std::uint64_t value, const std::uint64_t previous, const std::size_t size)
+{
+    const int shift = 64 - 8 * static_cast<int>(size);
+    return static_cast<std::int64_t>((value - previous) << shift) >> shift;
+}
+
+std::uint64_t loadInteger(const char *data, const std::size_t size)
+{
+    std::uint64_t value = 0u;
+    std::memcpy(&value, data, size); // NOTE: little endian
+    return value;
+}
+
+/// Stores the lower size bytes of the value, with a fixed size copy for each size
+inline void storeInteger(char *data, const std::uint64_t value, const std::size_t size) __attribute__((always_inline))
+{
+    switch (size)
+    {
+    case 1u:
+        *data = static_cast<char>(value);
+        break;
+    case 2u:
+        std::memcpy(data, &value, 2u);
+        break;
+    case 4u:
+        std::memcpy(data, &value, 4u);
+        break;
+    default:
+        std::memcpy(data, &value, 8u);
+        break;
+    }
+}
+
+/// Layout of the fixed part of the type, in the order of the fields
+std::vector<SegmentField> fieldsOf(const TraceType &type)
+{
+    std::vector<SegmentField> fields;
+    if (type.sampled)
+    {
+        fields.push_back({SegmentField::Integer, sizeof(Details::Suppressed::count), 0u});
+    }
+    if (type.span)
+    {
+        fields.push_back({SegmentField::Integer, sizeof(Details::SpanEnd::duration), 0u});
+        fields.push_back({SegmentField::Integer, sizeof(Details::SpanEnd::thread), 0u});
+        fields.push_back({SegmentField::Integer, sizeof(Details::SpanEnd::depth), 0u});
+    }
+    for (std::size_t i = 0u; i < type.arguments.size(); ++i)
+    {
+        const ArgumentType &argument = *type.arguments[i];
+        if (type.payloads[i])
+        {
+            fields.push_back({SegmentField::Count, sizeof(Details::Payload<char>::count), static_cast<std::uint16_t>(argument.size)});
+            fields.push_back({SegmentField::Integer, sizeof(Details::Payload<char>::truncated), 0u});
+            continue;
+        }
+        const bool integer = argument.kind != ArgumentType::Kind::Floating && argument.kind != ArgumentType::Kind::Structure
+                             && (argument.size == 1u || argument.size == 2u || argument.size == 4u || argument.size == 8u);
+        fields.push_back({integer ? SegmentField::Integer : SegmentField::Raw, static_cast<std::uint8_t>(argument.size), 0u});
+    }
+    return fields;
+}
+
+/// Reads the codes of a segment, throws at their end
+class Codes
+{
+public:
+    explicit Codes(const std::span<const char> codes)
+        : m_position(reinterpret_cast<const std::uint8_t *>(codes.data()))
+        , m_end(m_position + codes.size())
+    {
+    }
+
+    std::uint64_t next() __attribute__((always_inline))
+    {
+        if (m_position != m_end && *m_position < 0x80u) [[likely]]
+        {
+            return *m_position++;
+        }
+        std::uint64_t value = 0u;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (m_position == m_end)
+            {
+                throw std::runtime_error("Truncated segment codes");
+            }
+            const std::uint8_t byte = *m_position++;
+            value |= static_cast<std::uint64_t>(byte & 0x7Fu) << shift;
+            if (byte < 0x80u)
+            {
+                return value;
+            }
+        }
+        throw std::runtime_error("Corrupt segment codes");
+    }
+
+private:
+    const std::uint8_t *m_position;
+    const std::uint8_t *const m_end;
+};
+
+/// Dictionary entry while decompressing
+struct Type
+{
+    std::uintptr_t address;
+    std::uintptr_t typeInfo;
+    std::int64_t time; /// of the previous record
+    std::int64_t interval; /// between the previous two records
+    std::size_t fixedSize;
+    std::vector<SegmentField> fields;
+    std::vector<std::uint64_t> values;
+};
+
+template <typename T>
+T take(std::span<const char> &data)
+{
+    if (data.size() < sizeof(T))
+    {
+        throw std::runtime_error("Truncated segment dictionary");
+    }
+    T t;
+    std::memcpy(&t, data.data(), sizeof(T));
+    data = data.subspan(sizeof(T));
+    return t;
+}
+
+std::vector<Type> readDictionary(std::span<const char> dictionary, const std::uint32_t typeCount)
+{
+    std::vector<Type> types(typeCount);
+    for (Type &type : types)
+    {
+        type.address = take<std::uint64_t>(dictionary);
+        type.typeInfo = take<std::uint64_t>(dictionary);
+        type.fields.resize(take<std::uint16_t>(dictionary));
+        type.fixedSize = 0u;
+        for (SegmentField &field : type.fields)
+        {
+            field = take<SegmentField>(dictionary);
+            if (field.kind > SegmentField::Count || (field.kind != SegmentField::Raw && field.size != 1u && field.size != 2u && field.size != 4u && field.size != 8u))
+            {
+                throw std::runtime_error("Corrupt segment dictionary");
+            }
+            type.fixedSize += field.size;
+        }
+        type.values.assign(type.fields.size(), 0u);
+    }
+    return types;
+}
+/// Decodes the records of a segment into exactly the given bytes
+void decompressRecords(const SegmentHeader &header, std::vector<Type> &types, Codes &codes, const std::span<const char> rawBytes, const std::span<char> records)
+{
+    const char *raw = rawBytes.data();
+    const char *const rawEnd = raw + rawBytes.size();
+    char *out = records.data();
+    char *const outEnd = out + records.size();
+    std::int64_t time = 0;
+    std::size_t seen = 0u; /// types, the writer numbers them in the order of their first record
+    for (std::uint64_t r = 0u; r < header.recordCount; ++r)
+    {
+        const std::uint64_t id = codes.next();
+        if (id >= seen)
+        {
+            if (id != seen || seen == types.size())
+            {
+                throw std::runtime_error("Unknown type in segment");
+            }
+            types[seen].time = time;
+            types[seen++].interval = 0;
+        }
+        Type &type = types[id];
+        if (static_cast<std::size_t>(outEnd - out) < s_recordHeaderSize + type.fixedSize)
+        {
+            throw std::runtime_error("Segment exceeds its size");
+        }
+        const std::int64_t predicted = std::max(static_cast<std::int64_t>(static_cast<std::uint64_t>(type.time) + static_cast<std::uint64_t>(type.interval)), time);
+        const std::int64_t ticks = static_cast<std::int64_t>(static_cast<std::uint64_t>(predicted) + static_cast<std::uint64_t>(unzigzag(codes.next())));
+        type.interval = static_cast<std::int64_t>(static_cast<std::uint64_t>(ticks) - static_cast<std::uint64_t>(type.time));
+        type.time = ticks;
+        time = ticks;
+        std::memcpy(out, &ticks, sizeof(ticks));
+        std::memcpy(out + sizeof(ticks), &type.address, sizeof(type.address));
+        std::memcpy(out + sizeof(ticks) + sizeof(type.address), &type.typeInfo, sizeof(type.typeInfo));
+        out += s_recordHeaderSize;
+
+        std::size_t elementsSize = 0u;
+        for (std::size_t f = 0u; f < type.fields.size(); ++f)
+        {
+            const SegmentField &field = type.fields[f];
+            if (field.kind == SegmentField::Raw)
+            {
+                if (static_cast<std::size_t>(rawEnd - raw) < field.size)
+                {
+                    throw std::runtime_error("Truncated segment raw bytes");
+                }
+                if (field.size == sizeof(double))
+                {
+                    std::memcpy(out, raw, sizeof(double));
+                }
+                else
+                {
+                    std::memcpy(out, raw, field.size);
+                }
+                raw += field.size;
+            }
+            else
+            {
+                const std::uint64_t value = type.values[f] + static_cast<std::uint64_t>(unzigzag(codes.next()));
+                storeInteger(out, value, field.size);
+                type.values[f] = value;
+                if (field.kind == SegmentField::Count)
+                {
+                    elementsSize += (value & 0xFFFFu) * field.elementSize;
+                }
+            }
+            out += field.size;
+        }
+        if (elementsSize > 0u)
+        {
+            if (static_cast<std::size_t>(rawEnd - raw) < elementsSize || static_cast<std::size_t>(outEnd - out) < elementsSize)
+            {
+                throw std::runtime_error("Truncated segment payload");
+            }
+            std::memcpy(out, raw, elementsSize);
+            raw += elementsSize;
+            out += elementsSize;
+        }
+    }
+    if (out != outEnd || raw != rawEnd)
+    {
+        throw std::runtime_error("Segment does not match its size");
+    }
+}
+} // namespace
+
+SegmentWriter::SegmentWriter(std::ostream &s, const std::size_t segmentRecords)
+    : m_stream(s)
+    , m_segmentRecords(std::max<std::size_t>(segmentRecords, 1u))
+{
+}
+
+void SegmentWriter::write(const Record &record)
+{
+    if (record.threadId != Record::noThread)
+    {
+        throw std::invalid_argument("Segments hold records without a thread id");
+    }
+    const auto [id, inserted] = m_ids.try_emplace(Key{record.address, record.typeInfo}, static_cast<std::uint32_t>(m_types.size()));
+    if (inserted)
+    {
+        Type &type = m_types.emplace_back(Type{m_time, 0, fieldsOf(*record.type), {}});
+        type.values.assign(type.fields.size(), 0u);
+        const std::uint64_t address = record.address;
+        const std::uint64_t typeInfo = record.typeInfo;
+        const auto fieldCount = static_cast<std::uint16_t>(type.fields.size());
+        m_dictionary.append(reinterpret_cast<const char *>(&address), sizeof(address));
+        m_dictionary.append(reinterpret_cast<const char *>(&typeInfo), sizeof(typeInfo));
+        m_dictionary.append(reinterpret_cast<const char *>(&fieldCount), sizeof(fieldCount));
+        m_dictionary.append(reinterpret_cast<const char *>(type.fields.data()), type.fields.size() * sizeof(SegmentField));
+    }
+    Type &type = m_types[id->second];
+    appendVarint(m_codes, id->second);
+
+    // NOTE: a call site in a loop traces at a steady interval, others at least after the previous record
+    const std::int64_t predicted = std::max(static_cast<std::int64_t>(static_cast<std::uint64_t>(type.time) + static_cast<std::uint64_t>(type.interval)), m_time);
+    appendVarint(m_codes, zigzag(static_cast<std::int64_t>(static_cast<std::uint64_t>(record.ticks) - static_cast<std::uint64_t>(predicted))));
+    type.interval = static_cast<std::int64_t>(static_cast<std::uint64_t>(record.ticks) - static_cast<std::uint64_t>(type.time));
+    type.time = record.ticks;
+    m_time = record.ticks;
+
+    const char *data = record.payload.data();
+    for (std::size_t f = 0u; f < type.fields.size(); ++f)
+    {
+        const SegmentField &field = type.fields[f];
+        if (field.kind == SegmentField::Raw)
+        {
+            m_raw.append(data, field.size);
+        }
+        else
+        {
+            const std::uint64_t value = loadInteger(data, field.size);
+            appendVarint(m_codes, zigzag(difference(value, type.values[f], field.size)));
+            type.values[f] = value;
+        }
+        data += field.size;
+    }
+    // The elements of the payloads follow the fixed part
+    m_raw.append(data, static_cast<std::size_t>(record.payload.data() + record.payload.size() - data));
+
+    m_plainSize += s_recordHeaderSize + record.payload.size();
+    m_plainBytes += s_recordHeaderSize + record.payload.size();
+    if (++m_recordCount == m_segmentRecords)
+    {
+        flush();
+    }
+}
+
+void SegmentWriter::writeDumpHeader(const std::span<const char> header)
+{
+    m_stream.write(header.data(), static_cast<std::streamsize>(header.size()));
+    m_plainBytes += header.size();
+    m_writtenBytes += header.size();
+}
+
+void SegmentWriter::finish()
+{
+    if (m_recordCount > 0u)
+    {
+        flush();
+    }
+    m_stream.flush();
+}
+
+void SegmentWriter::flush()
+{
+    SegmentHeader header;
+    std::memcpy(header.magic, s_segmentMagic.data(), sizeof(header.magic));
+    header.typeCount = static_cast<std::uint32_t>(m_types.size());
+    header.recordCount = m_recordCount;
+    header.plainSize = m_plainSize;
+    header.dictionarySize = m_dictionary.size();
+    header.codesSize = m_codes.size();
+    header.rawSize = m_raw.size();
+    m_stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    m_stream.write(m_dictionary.data(), static_cast<std::streamsize>(m_dictionary.size()));
+    m_stream.write(m_codes.data(), static_cast<std::streamsize>(m_codes.size()));
+    m_stream.write(m_raw.data(), static_cast<std::streamsize>(m_raw.size()));
+    m_writtenBytes += sizeof(header) + m_dictionary.size() + m_codes.size() + m_raw.size();
+
+    m_ids.clear();
+    m_types.clear();
+    m_dictionary.clear();
+    m_codes.clear();
+    m_raw.clear();
+    m_recordCount = 0u;
+    m_plainSize = 0u;
+    m_time = 0;
+}
+
+void decompress(std::span<const char> segments, std::string &records)
+{
+    if (!dumpBuildId(segments).empty())
+    {
+        Details::DumpHeader header;
+        std::memcpy(&header, segments.data(), sizeof(header));
+        if (header.size < sizeof(header) || header.size > segments.size())
+        {
+            throw std::runtime_error("Truncated dump header");
+        }
+        records.append(segments.data(), header.size);
+        segments = segments.subspan(header.size);
+    }
+    while (!segments.empty())
+    {
+        if (segments.size() < sizeof(SegmentHeader))
+        {
+            throw std::runtime_error("Truncated segment header");
+        }
+        SegmentHeader header;
+        std::memcpy(&header, segments.data(), sizeof(header));
+        const std::size_t available = segments.size() - sizeof(header);
+        if (std::string_view(header.magic, sizeof(header.magic)) != s_segmentMagic || header.dictionarySize > available || header.codesSize > available - header.dictionarySize
+            || header.rawSize > available - header.dictionarySize - header.codesSize)
+        {
+            throw std::runtime_error("Corrupt segment header");
+        }
+        const std::span<const char> body = segments.subspan(sizeof(header));
+        std::vector<Type> types = readDictionary(body.first(header.dictionarySize), header.typeCount);
+        Codes codes(body.subspan(header.dictionarySize, header.codesSize));
+        const char *raw = body.data() + header.dictionarySize + header.codesSize;
+        const char *const rawEnd = raw + header.rawSize;
+        segments = body.subspan(header.dictionarySize + header.codesSize + header.rawSize);
+
+        // NOTE: without zeroing the records first, an error leaves the records as they were
+        const std::size_t begin = records.size();
+        std::exception_ptr error;
+        records.resize_and_overwrite(begin + header.plainSize, [&](char *data, const std::size_t) {
+            try
+            {
+                decompressRecords(header, types, codes, {raw, rawEnd}, {data + begin, header.plainSize});
+                return begin + header.plainSize;
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+                return begin;
+            }
+        });
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+} // namespace LogDecoder
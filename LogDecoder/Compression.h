@@ -0,0 +1,123 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "LogDecoder.h"
+
+namespace LogDecoder
+{
+/// Start of a compressed segment, followed by its dictionary, codes and raw bytes
+struct __attribute__((packed)) SegmentHeader
+{
+    char magic[4]; /// s_segmentMagic
+    std::uint32_t typeCount; /// entries of the dictionary
+    std::uint64_t recordCount;
+    std::uint64_t plainSize; /// of the records once decompressed
+    std::uint64_t dictionarySize;
+    std::uint64_t codesSize;
+    std::uint64_t rawSize;
+};
+
+/// Field of the fixed part of a record, as stored in the dictionary of a segment
+struct __attribute__((packed)) SegmentField
+{
+    enum Kind : std::uint8_t
+    {
+        Raw, /// copied as is, e.g. a double
+        Integer, /// difference with the previous value of the call site, as a zigzag varint
+        Count, /// an Integer, the element count of a payload of elementSize bytes each
+    };
+    Kind kind;
+    std::uint8_t size;
+    std::uint16_t elementSize;
+};
+
+constexpr std::string_view s_segmentMagic = "MLS1";
+
+/// Compresses records into segments, the Plain format in a fraction of the size
+///
+/// A segment numbers the distinct call site and type pairs in its dictionary, together
+/// with the layout of their arguments. Each record then takes a varint with its number,
+/// its time stamp as the difference with the one predicted from the previous two records of
+/// the call site, and every integer argument as the difference with its previous value at
+/// the call site, both zigzag varints. Floating point arguments and payload elements go to
+/// a separate stream as they are. Every segment starts from scratch, so segments decompress
+/// independently, without the symbols.
+class SegmentWriter
+{
+public:
+    static constexpr std::size_t s_defaultSegmentRecords = 1u << 16;
+
+    explicit SegmentWriter(std::ostream &s, std::size_t segmentRecords = s_defaultSegmentRecords);
+
+    /// Details::DumpHeader of the records, see Decoder::header, written as is before the first segment
+    void writeDumpHeader(std::span<const char> header);
+    /// Any record of the Plain, Compact or Indexed formats, see Decoder::nextAny
+    void write(const Record &record);
+    /// Writes the last segment
+    void finish();
+
+    /// Of the dump header and the records so far, in the Plain format
+    std::uint64_t plainBytes() const
+    {
+        return m_plainBytes;
+    }
+    /// Of the segments so far
+    std::uint64_t writtenBytes() const
+    {
+        return m_writtenBytes;
+    }
+
+private:
+    struct Type
+    {
+        std::int64_t time; /// of the previous record
+        std::int64_t interval; /// between the previous two records
+        std::vector<SegmentField> fields;
+        std::vector<std::uint64_t> values; /// previous value of each field
+    };
+    struct Key
+    {
+        std::uintptr_t address;
+        std::uintptr_t typeInfo;
+        bool operator==(const Key &) const = default;
+    };
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const
+        {
+            return std::hash<std::uintptr_t>()(key.address * 31u + key.typeInfo);
+        }
+    };
+
+    void flush();
+
+    std::ostream &m_stream;
+    const std::size_t m_segmentRecords;
+    std::unordered_map<Key, std::uint32_t, KeyHash> m_ids;
+    std::vector<Type> m_types;
+    std::string m_dictionary;
+    std::string m_codes;
+    std::string m_raw;
+    std::uint64_t m_recordCount = 0u;
+    std::uint64_t m_plainSize = 0u; /// of the current segment
+    std::int64_t m_time = 0; /// of the previous record
+    std::uint64_t m_plainBytes = 0u;
+    std::uint64_t m_writtenBytes = 0u;
+};
+
+/// Appends the records of the segments to the Plain format, throws if they are corrupt
+///
+/// A Details::DumpHeader in front of the segments is copied first.
+void decompress(std::span<const char> segments, std::string &records);
+} // namespace LogDecoder
+
+#endif // COMPRESSION_H
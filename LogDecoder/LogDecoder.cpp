@@ -0,0 +1,662 @@
+#include "LogDecoder.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+#include "../Logger/CompactLogger.h"
+#include "SymbolIndex.h"
+
+namespace LogDecoder
+{
+namespace
+{
+constexpr std::string_view s_tagPrefix = "Details::LoggerTraceTypeInfo<";
+constexpr std::string_view s_tagSuffix = ">::tag()";
+constexpr std::string_view s_mangledTagPrefix = "_ZN7Details19LoggerTraceTypeInfoI";
+constexpr std::string_view s_formatPrefix = "Details::Format<";
+constexpr std::string_view s_severityPrefix = "Details::Severity<(Level)";
+constexpr std::string_view s_payloadPrefix = "Details::Payload<";
+
+template <typename T>
+std::any load(const char *data)
+{
+    T t;
+    std::memcpy(&t, data, sizeof(T));
+    return t;
+}
+
+template <typename T>
+void print(std::ostream &s, const char *data)
+{
+    T t;
+    std::memcpy(&t, data, sizeof(T));
+    if constexpr (std::is_same_v<T, bool>)
+    {
+        s << (t ? "true" : "false");
+    }
+    else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char>)
+    {
+        s << static_cast<int>(t);
+    }
+    else if constexpr (std::is_integral_v<T> && std::is_unsigned_v<T>)
+    {
+        s << static_cast<unsigned long long>(t);
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+        s << static_cast<long long>(t);
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+        s << t;
+    }
+    else if constexpr (std::is_same_v<T, Clocks::Calibration>)
+    {
+        s << "{" << t.ticksPerSecond << " Hz, " << t.anchorTicks << " @ " << t.anchorNanoseconds << " ns}";
+    }
+    else if constexpr (std::is_same_v<T, Details::TimeAnchor>)
+    {
+        s << "{" << t.time << "}";
+    }
+}
+
+template <typename T>
+std::any loadPayload(const char *data, const std::size_t count)
+{
+    if constexpr (std::is_same_v<T, char>)
+    {
+        return std::string(data, count);
+    }
+    else
+    {
+        std::vector<T> elements(count);
+        for (std::size_t i = 0u; i < count; ++i)
+        {
+            T t;
+            std::memcpy(&t, data + i * sizeof(T), sizeof(T));
+            elements[i] = t; // NOTE: std::vector<bool> has no data()
+        }
+        return elements;
+    }
+}
+
+template <typename T>
+constexpr ArgumentType argumentType(const std::string_view name, const ArgumentType::Kind kind)
+{
+    return {name, kind, sizeof(T), &load<T>, &print<T>, &loadPayload<T>};
+}
+
+// NOTE: the names as spelled by the demangler, the fixed width aliases resolve to these
+using Kind = ArgumentType::Kind;
+constexpr std::array s_argumentTypes{
+    argumentType<bool>("bool", Kind::Bool),
+    argumentType<char>("char", Kind::Character),
+    argumentType<signed char>("signed char", Kind::Signed),
+    argumentType<unsigned char>("unsigned char", Kind::Unsigned),
+    argumentType<short>("short", Kind::Signed),
+    argumentType<unsigned short>("unsigned short", Kind::Unsigned),
+    argumentType<int>("int", Kind::Signed),
+    argumentType<unsigned int>("unsigned int", Kind::Unsigned),
+    argumentType<long>("long", Kind::Signed),
+    argumentType<unsigned long>("unsigned long", Kind::Unsigned),
+    argumentType<long long>("long long", Kind::Signed),
+    argumentType<unsigned long long>("unsigned long long", Kind::Unsigned),
+    argumentType<wchar_t>("wchar_t", Kind::Character),
+    argumentType<char8_t>("char8_t", Kind::Character),
+    argumentType<char16_t>("char16_t", Kind::Character),
+    argumentType<char32_t>("char32_t", Kind::Character),
+    argumentType<float>("float", Kind::Floating),
+    argumentType<double>("double", Kind::Floating),
+    argumentType<long double>("long double", Kind::Floating),
+    argumentType<Clocks::Calibration>("Clocks::Calibration", Kind::Structure),
+    argumentType<Details::TimeAnchor>("Details::TimeAnchor", Kind::Structure),
+};
+
+// NOTE: the type table of a dump refers to these by Details::argumentCode
+static_assert(std::tuple_size_v<Details::ArgumentTypes> == s_argumentTypes.size());
+static_assert([]<std::size_t... i>(std::index_sequence<i...>) { return ((sizeof(std::tuple_element_t<i, Details::ArgumentTypes>) == s_argumentTypes[i].size) && ...); }(std::make_index_sequence<s_argumentTypes.size()>()));
+
+template <typename T>
+T valueAt(const std::span<const char> data, const std::size_t offset)
+{
+    T t;
+    std::memcpy(&t, data.data() + offset, sizeof(T));
+    return t;
+}
+
+/// Characters of a Details::Format, e.g. "Details::Format<Details::FixedString<3ul>{char [3]{(char)104, (char)105}}>"
+///
+/// The demangler spells every character as a number and leaves out the trailing zeros.
+std::string parseFormat(const std::string_view name)
+{
+    constexpr std::string_view character = "(char)";
+    std::string format;
+    for (std::size_t at = name.find(character); at != std::string_view::npos; at = name.find(character, at))
+    {
+        at += character.size();
+        int value = 0;
+        const auto [end, error] = std::from_chars(name.data() + at, name.data() + name.size(), value);
+        if (error != std::errc{})
+        {
+            throw std::runtime_error("Unsupported format: " + std::string(name));
+        }
+        format.push_back(static_cast<char>(value));
+        at = static_cast<std::size_t>(end - name.data());
+    }
+    while (!format.empty() && format.back() == '\0')
+    {
+        format.pop_back();
+    }
+    return format;
+}
+
+/// Marks the records of Clocks::Calibration and Details::TimeAnchor, which the decoder applies
+void setSpecial(TraceType &type)
+{
+    if (type.arguments.size() == 1u && !type.payloads.front() && type.arguments.front()->name == "Clocks::Calibration")
+    {
+        type.special = TraceType::Special::Calibration;
+    }
+    else if (type.arguments.size() == 1u && !type.payloads.front() && type.arguments.front()->name == "Details::TimeAnchor")
+    {
+        type.special = TraceType::Special::TimeAnchor;
+    }
+}
+
+/// Nearest time stamp to the reference with the given lower 32 bits
+std::int64_t complete(const std::int64_t reference, const std::uint32_t truncated)
+{
+    constexpr std::int64_t range = std::int64_t{1} << 32;
+    std::int64_t time = (reference & ~(range - 1)) | truncated;
+    if (time - reference > range / 2)
+    {
+        time -= range;
+    }
+    else if (reference - time > range / 2)
+    {
+        time += range;
+    }
+    return time;
+}
+} // namespace
+
+std::string_view levelName(const Level level)
+{
+    switch (level)
+    {
+    case Level::Debug:
+        return "Debug";
+    case Level::Info:
+        return "Info";
+    case Level::Warning:
+        return "Warning";
+    case Level::Error:
+        return "Error";
+    }
+    return "?";
+}
+
+void Record::printArgument(std::ostream &s, const std::size_t i) const
+{
+    const ArgumentType &argumentType = *type->arguments.at(i);
+    if (!type->payloads[i])
+    {
+        argumentType.print(s, payload.data() + type->offsets[i]);
+        return;
+    }
+    const std::span<const char> elements = elementsOf(i);
+    if (argumentType.name == "char")
+    {
+        s << std::string_view(elements.data(), elements.size()) << (truncated(i) ? "..." : "");
+        return;
+    }
+    s << '[';
+    for (std::size_t offset = 0u; offset < elements.size(); offset += argumentType.size)
+    {
+        s << (offset > 0u ? ", " : "");
+        argumentType.print(s, elements.data() + offset);
+    }
+    s << (truncated(i) ? ", ...]" : "]");
+}
+
+std::span<const char> Record::elementsOf(const std::size_t i) const
+{
+    std::size_t offset = type->size;
+    for (std::size_t j = 0u; j < i; ++j)
+    {
+        offset += type->payloads[j] ? payloadOf(j).count * type->arguments[j]->size : 0u;
+    }
+    return payload.subspan(offset, payloadOf(i).count * type->arguments[i]->size);
+}
+
+void Record::printMessage(std::ostream &s) const
+{
+    const std::string &format = type->format;
+    std::size_t argument = 0u;
+    for (std::size_t i = 0u; i < format.size(); ++i)
+    {
+        if ((format[i] == '{' || format[i] == '}') && i + 1u < format.size() && format[i + 1u] == format[i])
+        {
+            s << format[i++];
+        }
+        else if (const std::size_t close = format.find('}', i); format[i] == '{' && close != std::string::npos && argument < argumentCount())
+        {
+            // NOTE: format specifications are not supported, the argument prints as usual
+            printArgument(s, argument++);
+            i = close;
+        }
+        else
+        {
+            s << format[i];
+        }
+    }
+}
+
+TraceType TraceType::fromTagName(const std::string_view demangledName)
+{
+    if (!demangledName.starts_with(s_tagPrefix) || !demangledName.ends_with(s_tagSuffix))
+    {
+        throw std::runtime_error("Not a trace type: " + std::string(demangledName));
+    }
+    std::string_view arguments = demangledName.substr(s_tagPrefix.size(), demangledName.size() - s_tagPrefix.size() - s_tagSuffix.size());
+
+    TraceType type;
+    while (!arguments.empty())
+    {
+        // Split at the top level comma
+        std::size_t end = 0u;
+        for (int depth = 0; end < arguments.size() && (depth > 0 || arguments[end] != ','); ++end)
+        {
+            depth += arguments[end] == '<' || arguments[end] == '(' || arguments[end] == '{' ? 1 : arguments[end] == '>' || arguments[end] == ')' || arguments[end] == '}' ? -1 : 0;
+        }
+        std::string_view name = arguments.substr(0u, end);
+        // NOTE: the demangler separates nested closing brackets, as in "Details::Payload<float> >"
+        while (name.ends_with(' '))
+        {
+            name.remove_suffix(1u);
+        }
+        if (type.arguments.empty() && type.format.empty() && !type.level && name.starts_with(s_severityPrefix))
+        {
+            int level = 0;
+            const std::string_view value = name.substr(s_severityPrefix.size());
+            if (std::from_chars(value.data(), value.data() + value.size(), level).ec != std::errc{} || level < static_cast<int>(Level::Debug) || level > static_cast<int>(Level::Error))
+            {
+                throw std::runtime_error("Unsupported level: " + std::string(name));
+            }
+            type.level = static_cast<Level>(level);
+            arguments.remove_prefix(std::min(arguments.size(), end + 2u)); // ", "
+            continue;
+        }
+        if (type.arguments.empty() && type.format.empty() && name.starts_with(s_formatPrefix))
+        {
+            type.format = parseFormat(name);
+            arguments.remove_prefix(std::min(arguments.size(), end + 2u)); // ", "
+            continue;
+        }
+        if (type.arguments.empty() && !type.sampled && name == "Details::Suppressed")
+        {
+            type.sampled = true;
+            type.size += sizeof(Details::Suppressed);
+            arguments.remove_prefix(std::min(arguments.size(), end + 2u)); // ", "
+            continue;
+        }
+        if (type.arguments.empty() && !type.span && !type.sampled && name == "Details::SpanEnd")
+        {
+            type.span = true;
+            type.size += sizeof(Details::SpanEnd);
+            arguments.remove_prefix(std::min(arguments.size(), end + 2u)); // ", "
+            continue;
+        }
+        const bool payload = name.starts_with(s_payloadPrefix) && name.ends_with('>');
+        const std::string_view typeName = payload ? name.substr(s_payloadPrefix.size(), name.size() - s_payloadPrefix.size() - 1u) : name;
+        const auto argumentType = std::ranges::find(s_argumentTypes, typeName, &ArgumentType::name);
+        if (argumentType == s_argumentTypes.end())
+        {
+            throw std::runtime_error("Unsupported argument type: " + std::string(name));
+        }
+        type.arguments.push_back(&*argumentType);
+        type.offsets.push_back(type.size);
+        type.payloads.push_back(payload);
+        type.size += payload ? sizeof(Details::Payload<char>) : argumentType->size;
+        arguments.remove_prefix(std::min(arguments.size(), end + 2u)); // ", "
+    }
+
+    setSpecial(type);
+    return type;
+}
+
+std::span<const unsigned char> dumpBuildId(const std::span<const char> data)
+{
+    if (data.size() < sizeof(Details::DumpHeader) || !std::ranges::equal(data.first(Details::DumpHeader::expectedMagic.size()), Details::DumpHeader::expectedMagic))
+    {
+        return {};
+    }
+    const auto buildIdSize = std::min<std::uint64_t>(valueAt<std::uint64_t>(data, offsetof(Details::DumpHeader, buildIdSize)), sizeof(Details::DumpHeader::buildId));
+    return {reinterpret_cast<const unsigned char *>(data.data() + offsetof(Details::DumpHeader, buildId)), buildIdSize};
+}
+
+Decoder::Decoder(const std::span<const char> data, SymbolIndex &symbols, const Format format)
+    : m_data(data)
+    , m_symbols(symbols)
+    , m_format(format)
+{
+    if (m_format == Format::Compact16 || m_format == Format::Compact32)
+    {
+        if (m_data.size() < sizeof(std::uint64_t))
+        {
+            throw std::runtime_error("Missing call site table");
+        }
+        const auto callSiteCount = valueAt<std::uint64_t>(m_data, 0u);
+        if (callSiteCount > (m_data.size() - sizeof(std::uint64_t)) / sizeof(Details::CallSite))
+        {
+            throw std::runtime_error("Truncated call site table");
+        }
+        m_callSites.resize(callSiteCount);
+        std::memcpy(m_callSites.data(), m_data.data() + sizeof(std::uint64_t), callSiteCount * sizeof(Details::CallSite));
+        m_offset = sizeof(std::uint64_t) + callSiteCount * sizeof(Details::CallSite);
+    }
+    else if (m_format == Format::Indexed)
+    {
+        if (m_data.size() < sizeof(Details::BlockIndex))
+        {
+            throw std::runtime_error("Missing block index");
+        }
+        const auto index = valueAt<Details::BlockIndex>(m_data, m_data.size() - sizeof(Details::BlockIndex));
+        const std::size_t available = m_data.size() - sizeof(Details::BlockIndex);
+        if (index.blockSize == 0u || index.entryCount > available / sizeof(std::uint64_t) || index.recordsSize > available - index.entryCount * sizeof(std::uint64_t))
+        {
+            throw std::runtime_error("Corrupt block index");
+        }
+        const std::size_t recordsEnd = available - index.entryCount * sizeof(std::uint64_t);
+        m_blockIndex = m_data.subspan(recordsEnd, index.entryCount * sizeof(std::uint64_t));
+        m_recordsBegin = recordsEnd - index.recordsSize;
+        m_firstBoundary = index.firstBoundary;
+        m_blockSize = index.blockSize;
+        m_data = m_data.first(recordsEnd);
+    }
+    if (m_format != Format::Compact16 && m_format != Format::Compact32 && !dumpBuildId(m_data.first(std::min(m_data.size(), m_format == Format::Indexed ? m_recordsBegin : m_data.size()))).empty())
+    {
+        readHeader();
+    }
+    if (!buildId().empty() && !m_symbols.buildId().empty() && !std::ranges::equal(buildId(), m_symbols.buildId()))
+    {
+        throw std::runtime_error("The dump was written by another build than the symbol file");
+    }
+}
+
+/// Pre-populates the types from the table of the Details::DumpHeader, which replaces the symbols for them
+void Decoder::readHeader()
+{
+    const auto header = valueAt<Details::DumpHeader>(m_data, 0u);
+    if (header.size < sizeof(header) || header.size > (m_format == Format::Indexed ? m_recordsBegin : m_data.size()))
+    {
+        throw std::runtime_error("Corrupt dump header");
+    }
+    m_header = m_data.first(header.size);
+    if (header.calibrated)
+    {
+        m_calibration = header.calibration;
+    }
+    std::size_t offset = sizeof(header);
+    const auto require = [this](const std::size_t offset, const std::size_t size) {
+        if (size > m_header.size() - std::min(offset, m_header.size()))
+        {
+            throw std::runtime_error("Truncated type table");
+        }
+    };
+    for (std::uint64_t i = 0u; i < header.typeCount; ++i)
+    {
+        require(offset, sizeof(Details::TypeTableEntry));
+        const auto entry = valueAt<Details::TypeTableEntry>(m_header, offset);
+        offset += sizeof(entry);
+        TraceType type;
+        if (entry.level != Details::TypeLayout::noLevel)
+        {
+            if (entry.level < static_cast<std::uint8_t>(Level::Debug) || entry.level > static_cast<std::uint8_t>(Level::Error))
+            {
+                throw std::runtime_error("Unsupported level in the type table");
+            }
+            type.level = static_cast<Level>(entry.level);
+        }
+        type.sampled = entry.sampled != 0u;
+        type.span = entry.span != 0u;
+        type.size = (type.sampled ? sizeof(Details::Suppressed) : 0u) + (type.span ? sizeof(Details::SpanEnd) : 0u);
+        require(offset, entry.argumentCount * sizeof(Details::ArgumentLayout) + entry.formatSize);
+        for (std::uint16_t j = 0u; j < entry.argumentCount; ++j)
+        {
+            const auto argument = valueAt<Details::ArgumentLayout>(m_header, offset);
+            offset += sizeof(argument);
+            if (argument.code == 0u || argument.code > s_argumentTypes.size())
+            {
+                throw std::runtime_error("Unsupported argument type in the type table");
+            }
+            const ArgumentType &argumentType = s_argumentTypes[argument.code - 1u];
+            type.arguments.push_back(&argumentType);
+            type.offsets.push_back(type.size);
+            type.payloads.push_back(argument.payload);
+            type.size += argument.payload ? sizeof(Details::Payload<char>) : argumentType.size;
+        }
+        type.format.assign(m_header.data() + offset, entry.formatSize);
+        offset += entry.formatSize;
+        setSpecial(type);
+        m_types.emplace(entry.tag, std::move(type));
+    }
+    m_offset = header.size;
+}
+
+bool Decoder::next(Record &record)
+{
+    while (read(m_offset, record))
+    {
+        if (apply(record))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Decoder::nextAny(Record &record)
+{
+    if (!read(m_offset, record))
+    {
+        return false;
+    }
+    apply(record);
+    return true;
+}
+
+std::size_t Decoder::boundaryAt(const std::size_t offset) const
+{
+    if (m_format != Format::Indexed)
+    {
+        throw std::runtime_error("Seeking requires the Indexed format");
+    }
+    if (offset <= m_recordsBegin)
+    {
+        return m_recordsBegin;
+    }
+    const std::size_t position = offset - m_recordsBegin;
+    const std::size_t entry = position <= m_firstBoundary ? 0u : (position - m_firstBoundary + m_blockSize - 1u) / m_blockSize;
+    if (entry >= m_blockIndex.size() / sizeof(std::uint64_t))
+    {
+        return m_data.size();
+    }
+    return m_recordsBegin + std::min<std::size_t>(valueAt<std::uint64_t>(m_blockIndex, entry * sizeof(std::uint64_t)), m_data.size() - m_recordsBegin);
+}
+
+void Decoder::seek(const std::size_t offset)
+{
+    const std::size_t boundary = m_format == Format::Indexed ? boundaryAt(offset) : offset;
+    const std::size_t specialsEnd = m_format == Format::Indexed ? m_recordsBegin : boundary;
+    Record record;
+    while (m_offset < specialsEnd && read(m_offset, record))
+    {
+        if (apply(record))
+        {
+            break;
+        }
+    }
+    m_offset = boundary;
+}
+
+/// Applies the special records, true for a regular one
+bool Decoder::apply(const Record &record)
+{
+    switch (record.type->special)
+    {
+    case TraceType::Special::Calibration:
+        m_calibration = record.argument<Clocks::Calibration>(0u);
+        return false;
+    case TraceType::Special::TimeAnchor:
+        m_timeReference = record.argument<Details::TimeAnchor>(0u).time;
+        return false;
+    case TraceType::Special::None:
+        return true;
+    }
+    return true;
+}
+
+bool Decoder::read(std::size_t &offset, Record &record)
+{
+    while (readRecord(offset, record))
+    {
+        // NOTE: in front of the first time anchor, e.g. of a wrapped buffer, the upper bits of
+        // a compact time stamp are unknown
+        if ((m_format != Format::Compact16 && m_format != Format::Compact32) || record.type->special != TraceType::Special::None || m_timeReference)
+        {
+            return true;
+        }
+        ++m_unplacedCount;
+    }
+    return false;
+}
+
+bool Decoder::readRecord(std::size_t &offset, Record &record)
+{
+    if (offset == m_data.size())
+    {
+        return false;
+    }
+    const std::size_t begin = offset;
+    const auto require = [this, begin, &offset](const std::size_t size) {
+        if (size > m_data.size() - offset)
+        {
+            throw std::runtime_error("Truncated record at offset " + std::to_string(begin));
+        }
+    };
+
+    record.threadId = Record::noThread;
+    std::optional<std::uint32_t> truncatedTime;
+    switch (m_format)
+    {
+    case Format::Sharded:
+        require(sizeof(std::uint16_t));
+        record.threadId = valueAt<std::uint16_t>(m_data, offset);
+        offset += sizeof(std::uint16_t);
+        [[fallthrough]];
+    case Format::Plain:
+    case Format::Indexed:
+        require(sizeof(std::int64_t) + 2 * sizeof(std::uintptr_t));
+        record.ticks = valueAt<std::int64_t>(m_data, offset);
+        record.address = valueAt<std::uintptr_t>(m_data, offset + sizeof(std::int64_t));
+        record.typeInfo = valueAt<std::uintptr_t>(m_data, offset + sizeof(std::int64_t) + sizeof(std::uintptr_t));
+        offset += sizeof(std::int64_t) + 2 * sizeof(std::uintptr_t);
+        break;
+    case Format::Compact16:
+    case Format::Compact32:
+    {
+        const std::size_t idSize = m_format == Format::Compact16 ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+        require(idSize + sizeof(std::uint32_t));
+        const std::size_t id = idSize == sizeof(std::uint16_t) ? valueAt<std::uint16_t>(m_data, offset) : valueAt<std::uint32_t>(m_data, offset);
+        if (id >= m_callSites.size())
+        {
+            throw std::runtime_error("Unknown call site id at offset " + std::to_string(begin));
+        }
+        record.address = m_callSites[id].m_traceCallSite;
+        record.typeInfo = m_callSites[id].m_traceInnerInstance;
+        truncatedTime = valueAt<std::uint32_t>(m_data, offset + idSize);
+        offset += idSize + sizeof(std::uint32_t);
+        break;
+    }
+    }
+
+    record.type = &typeOf(record.typeInfo, record.address);
+    require(record.type->size);
+    std::size_t size = record.type->size;
+    for (std::size_t i = 0u; i < record.type->payloads.size(); ++i)
+    {
+        if (record.type->payloads[i])
+        {
+            size += valueAt<Details::Payload<char>>(m_data, offset + record.type->offsets[i]).count * record.type->arguments[i]->size;
+        }
+    }
+    require(size);
+    record.payload = m_data.subspan(offset, size);
+    offset += size;
+
+    if (truncatedTime)
+    {
+        if (record.type->special == TraceType::Special::TimeAnchor)
+        {
+            record.ticks = record.argument<Details::TimeAnchor>(0u).time;
+        }
+        else if (record.type->special == TraceType::Special::Calibration)
+        {
+            record.ticks = record.argument<Clocks::Calibration>(0u).anchorTicks;
+        }
+        else if (m_timeReference)
+        {
+            record.ticks = complete(*m_timeReference, *truncatedTime);
+            m_timeReference = record.ticks;
+        }
+        else
+        {
+            record.ticks = 0;
+        }
+    }
+    record.time = toNanoseconds(record.ticks);
+    record.span.reset();
+    if (record.type->span)
+    {
+        const auto spanEnd = valueAt<Details::SpanEnd>(record.payload, 0u);
+        record.span = Span{toNanoseconds(record.ticks + spanEnd.duration) - record.time, spanEnd.thread, spanEnd.depth};
+    }
+    return true;
+}
+
+const TraceType &Decoder::typeOf(const std::uintptr_t typeInfo, const std::uintptr_t address)
+{
+    if (!m_loadBiasKnown && !m_symbols.symbols().empty())
+    {
+        m_loadBiasKnown = true;
+        if (!m_symbols.inferLoadBias(typeInfo, s_mangledTagPrefix, address))
+        {
+            throw std::runtime_error("Type information does not match the symbols");
+        }
+    }
+    if (const auto it = m_types.find(typeInfo); it != m_types.end())
+    {
+        return it->second;
+    }
+    const SymbolIndex::Symbol *symbol = m_symbols.resolve(typeInfo);
+    if (symbol == nullptr || !symbol->mangledName.starts_with(s_mangledTagPrefix))
+    {
+        throw std::runtime_error("Unknown type information at offset " + std::to_string(m_offset));
+    }
+    return m_types.emplace(typeInfo, TraceType::fromTagName(SymbolIndex::demangle(symbol->mangledName))).first->second;
+}
+
+std::int64_t Decoder::toNanoseconds(const std::int64_t ticks) const
+{
+    if (!m_calibration)
+    {
+        return ticks;
+    }
+    const double seconds = static_cast<double>(ticks - m_calibration->anchorTicks) / m_calibration->ticksPerSecond;
+    return m_calibration->anchorNanoseconds + std::llround(seconds * 1e9);
+}
+} // namespace LogDecoder
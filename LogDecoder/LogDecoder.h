@@ -0,0 +1,240 @@
+#ifndef LOG_DECODER_H
+#define LOG_DECODER_H
+
+#include <any>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "../Logger/Logger.h"
+
+namespace LogDecoder
+{
+class SymbolIndex;
+
+/// Output layout of the different loggers
+enum class Format
+{
+    Plain, /// Logger
+    Sharded, /// ShardedLogger, records prefixed with a thread id
+    Compact16, /// CompactLogger with std::uint16_t call site ids
+    Compact32, /// CompactLogger with std::uint32_t call site ids
+    Indexed, /// IndexedLogger, Plain records followed by a Details::BlockIndex
+};
+
+/// Storage of a single trace argument
+struct ArgumentType
+{
+    enum class Kind
+    {
+        Bool,
+        Character,
+        Signed,
+        Unsigned,
+        Floating,
+        Structure,
+    };
+    std::string_view name;
+    Kind kind;
+    std::size_t size;
+    std::any (*load)(const char *data);
+    void (*print)(std::ostream &s, const char *data);
+    std::any (*loadPayload)(const char *data, std::size_t count); /// std::string for char, std::vector<T> otherwise
+};
+
+/// Arguments of one Details::LoggerTraceTypeInfo<Ts...> instance
+struct TraceType
+{
+    enum class Special
+    {
+        None,
+        Calibration, /// Clocks::Calibration, converts ticks to nanoseconds
+        TimeAnchor, /// Details::TimeAnchor, completes truncated time stamps
+    };
+    std::vector<const ArgumentType *> arguments; /// the element type for a payload
+    std::vector<std::size_t> offsets;
+    std::vector<bool> payloads; /// whether argument i is a Details::Payload, its elements follow the fixed part
+    std::size_t size = 0u; /// of the fixed part
+    Special special = Special::None;
+    std::string format; /// message of a trace<format> call, empty otherwise
+    std::optional<Level> level; /// of a trace<level> call
+    bool sampled = false; /// of a Logger::sample call, the fixed part starts with a Details::Suppressed
+    bool span = false; /// of a Logger::span, the fixed part starts with a Details::SpanEnd
+
+    /// Parses the demangled name of the tag function, e.g. "Details::LoggerTraceTypeInfo<bool, int>::tag()"
+    static TraceType fromTagName(std::string_view demangledName);
+};
+
+/// Build id in the Details::DumpHeader at the start of the data, empty without one
+std::span<const unsigned char> dumpBuildId(std::span<const char> data);
+
+/// Name of the level, e.g. "Warning"
+std::string_view levelName(Level level);
+
+/// Decoded Details::SpanEnd of a Logger::span, the time of its record is the start
+struct Span
+{
+    std::int64_t duration; /// nanoseconds if calibrated, ticks otherwise
+    std::uint16_t thread;
+    std::uint16_t depth; /// enclosing spans of the same thread
+};
+
+/// One record, referring to the decoded data without copies
+struct Record
+{
+    std::int64_t ticks = 0; /// time stamp as written by the clock
+    std::int64_t time = 0; /// nanoseconds since epoch if calibrated, ticks otherwise
+    std::uintptr_t address = 0u; /// where is trace called from?
+    std::uintptr_t typeInfo = 0u; /// what templated form?
+    std::uint16_t threadId = noThread;
+    const TraceType *type = nullptr;
+    std::span<const char> payload; /// the fixed part, followed by the elements of the payload arguments
+    std::optional<Span> span; /// of a Logger::span record
+
+    static constexpr std::uint16_t noThread = 0xFFFF;
+
+    std::size_t argumentCount() const
+    {
+        return type->arguments.size();
+    }
+    std::any argument(const std::size_t i) const
+    {
+        if (type->payloads.at(i))
+        {
+            return type->arguments[i]->loadPayload(elementsOf(i).data(), payloadOf(i).count);
+        }
+        return type->arguments.at(i)->load(payload.data() + type->offsets.at(i));
+    }
+    /// Traces that the Sampling policy of the call site dropped right before this one
+    std::uint64_t suppressed() const
+    {
+        if (!type->sampled)
+        {
+            return 0u;
+        }
+        Details::Suppressed suppressed;
+        std::memcpy(&suppressed, payload.data(), sizeof(suppressed));
+        return suppressed.count;
+    }
+    /// Fixed size arguments only
+    template <typename T>
+    T argument(const std::size_t i) const
+    {
+        T t;
+        std::memcpy(&t, payload.data() + type->offsets.at(i), sizeof(T));
+        return t;
+    }
+    void printArgument(std::ostream &s, const std::size_t i) const;
+    /// Whether the cap cut off elements of a payload argument
+    bool truncated(const std::size_t i) const
+    {
+        return type->payloads.at(i) && payloadOf(i).truncated;
+    }
+    /// Prints the format with the arguments in place of its {} placeholders, {{ and }} escape a brace
+    void printMessage(std::ostream &s) const;
+
+private:
+    Details::Payload<char> payloadOf(std::size_t i) const
+    {
+        Details::Payload<char> header;
+        std::memcpy(&header, payload.data() + type->offsets[i], sizeof(header));
+        return header;
+    }
+    std::span<const char> elementsOf(std::size_t i) const;
+};
+
+/// Walks the records of a dump one by one, in bounded memory
+///
+/// The type tags are looked up in the type table of the Details::DumpHeader, if the dump
+/// starts with one, and resolved through the symbol index otherwise. Without a table, the
+/// symbols are required; with one, they only name the call sites. The load bias of
+/// position independent binaries is derived from the first type tag.
+class Decoder
+{
+public:
+    Decoder(std::span<const char> data, SymbolIndex &symbols, Format format = Format::Plain);
+
+    /// Next regular record, false at the end of the data
+    ///
+    /// Calibration and time anchor records are applied, not returned.
+    bool next(Record &record);
+    /// Next record, also a calibration or time anchor record, which is applied all the same
+    bool nextAny(Record &record);
+
+    /// Number of bytes consumed so far
+    std::size_t offset() const
+    {
+        return m_offset;
+    }
+    /// Offset right after the last record
+    std::size_t size() const
+    {
+        return m_data.size();
+    }
+    /// Records of a compact dump skipped in front of its first time anchor, whose time is unknown
+    std::uint64_t unplacedCount() const
+    {
+        return m_unplacedCount;
+    }
+
+    /// Start of a record at or after the offset, at most one block further, in constant time
+    ///
+    /// Decoders that each continue from the boundary of a chunk split a dump into parts that
+    /// can be decoded in parallel. Only available for the Indexed format.
+    std::size_t boundaryAt(std::size_t offset) const;
+    /// Continues at boundaryAt(offset), after applying the special records in front of the buffer
+    ///
+    /// The other formats continue at the offset, which must be the start of a record, such as
+    /// one from a StoreIndexEntry, after applying the special records in front of the first regular one.
+    void seek(std::size_t offset);
+
+    /// Of the Details::DumpHeader, empty without one
+    std::span<const unsigned char> buildId() const
+    {
+        return dumpBuildId(m_header);
+    }
+    /// Details::DumpHeader with its type table and padding, empty without one
+    std::span<const char> header() const
+    {
+        return m_header;
+    }
+
+    /// Converts the ticks of the records, as a Calibration record would
+    void setCalibration(const Clocks::Calibration &calibration)
+    {
+        m_calibration = calibration;
+    }
+
+private:
+    void readHeader();
+    bool apply(const Record &record);
+    bool read(std::size_t &offset, Record &record);
+    bool readRecord(std::size_t &offset, Record &record);
+    const TraceType &typeOf(std::uintptr_t typeInfo, std::uintptr_t address);
+    std::int64_t toNanoseconds(std::int64_t ticks) const;
+
+    std::span<const char> m_data;
+    SymbolIndex &m_symbols;
+    const Format m_format;
+    std::size_t m_offset = 0u;
+    std::size_t m_recordsBegin = 0u;
+    std::span<const char> m_header;
+    std::span<const char> m_blockIndex;
+    std::uint64_t m_firstBoundary = 0u;
+    std::uint64_t m_blockSize = 0u;
+    std::vector<Details::CallSite> m_callSites;
+    std::unordered_map<std::uintptr_t, TraceType> m_types;
+    bool m_loadBiasKnown = false;
+    std::optional<Clocks::Calibration> m_calibration;
+    std::optional<std::int64_t> m_timeReference;
+    std::uint64_t m_unplacedCount = 0u;
+};
+} // namespace LogDecoder
+
+#endif // LOG_DECODER_H
@@ -0,0 +1,4 @@
+# Link the static LogDecoder library, see LogDecoder.pro
+INCLUDEPATH += $$PWD
+LIBS += -L$${OUT_PWD}/../LogDecoder -lLogDecoder
+PRE_TARGETDEPS += $${OUT_PWD}/../LogDecoder/libLogDecoder.a
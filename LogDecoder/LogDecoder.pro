@@ -0,0 +1,36 @@
+TEMPLATE = lib
+CONFIG += staticlib
+QT =
+
+include("../GlobalSettings.pri")
+
+HEADERS += CallSiteControl.h
+SOURCES += CallSiteControl.cpp
+HEADERS += Collector.h
+SOURCES += Collector.cpp
+HEADERS += Compression.h
+SOURCES += Compression.cpp
+HEADERS += LogDecoder.h
+SOURCES += LogDecoder.cpp
+HEADERS += LogModel.h
+SOURCES += LogModel.cpp
+HEADERS += MappedFile.h
+SOURCES += MappedFile.cpp
+HEADERS += Recovery.h
+SOURCES += Recovery.cpp
+HEADERS += SpanStatistics.h
+SOURCES += SpanStatistics.cpp
+HEADERS += Store.h
+SOURCES += Store.cpp
+HEADERS += SymbolIndex.h
+SOURCES += SymbolIndex.cpp
+HEADERS += TraceEvents.h
+SOURCES += TraceEvents.cpp
+
+DEFINES += ARM
+HEADERS += ../Logger/CompactLogger.h
+HEADERS += ../Logger/CrashHandler.h
+HEADERS += ../Logger/Logger.h
+HEADERS += ../Logger/MappedLogger.h
+HEADERS += ../Logger/MirroredLogger.h
+HEADERS += ../Logger/SharedLogger.h
@@ -0,0 +1,38 @@
+#include "LogModel.h"
+
+#include <iterator>
+#include <sstream>
+
+#include "SymbolIndex.h"
+
+namespace LogDecoder
+{
+LogModel::LogModel(std::istream &&stream, const std::string &symbolFilePath, const Format format)
+    : m_symbols(std::make_unique<SymbolIndex>(symbolFilePath))
+{
+    const std::string data{std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+    Decoder decoder(data, *m_symbols, format);
+    LogDecoder::Record record;
+    while (decoder.next(record))
+    {
+        Record &modelRecord = m_records.emplace_back(Record{record.time, record.address, record.threadId, {}, {}, record.type->level, record.suppressed(), record.span});
+        for (std::size_t i = 0u; i < record.argumentCount(); ++i)
+        {
+            modelRecord.args.push_back(record.argument(i));
+        }
+        if (!record.type->format.empty())
+        {
+            std::ostringstream message;
+            record.printMessage(message);
+            modelRecord.message = message.str();
+        }
+    }
+}
+
+LogModel::~LogModel() = default;
+
+std::string LogModel::resolveFunction(const std::uintptr_t address) const
+{
+    return m_symbols->resolveFunction(address);
+}
+} // namespace LogDecoder
@@ -0,0 +1,49 @@
+#ifndef LOG_MODEL_H
+#define LOG_MODEL_H
+
+#include <any>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "LogDecoder.h"
+
+namespace LogDecoder
+{
+/// All records of a (small) dump decoded in memory, e.g. for unit tests
+///
+/// Use the Decoder directly on a MappedFile to walk large dumps.
+class LogModel
+{
+public:
+    struct Record
+    {
+        std::int64_t time; /// nanoseconds since epoch if calibrated, ticks otherwise
+        std::uintptr_t address; /// where is trace called from?
+        std::uint16_t threadId;
+        std::vector<std::any> args;
+        std::string message; /// formatted, empty for a trace without format
+        std::optional<Level> level; /// of a trace<level> call
+        std::uint64_t suppressed; /// traces of a sampled call site dropped right before this one
+        std::optional<Span> span; /// of a Logger::span, whose start is the time
+    };
+
+    LogModel(std::istream &&stream, const std::string &symbolFilePath, Format format = Format::Plain);
+    ~LogModel();
+
+    const std::vector<Record> &records() const
+    {
+        return m_records;
+    }
+    std::string resolveFunction(std::uintptr_t address) const;
+
+private:
+    std::unique_ptr<SymbolIndex> m_symbols;
+    std::vector<Record> m_records;
+};
+} // namespace LogDecoder
+
+#endif // LOG_MODEL_H
@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+namespace LogDecoder
+{
+/// Read-only memory map of a whole file
+///
+/// Only the address space is reserved, the pages are read on demand by the kernel.
+/// Call release() behind a sequential reader to keep the resident memory bounded.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    std::span<const char> data() const
+    {
+        return {m_data, m_size};
+    }
+
+    /// Drops the pages before offset from memory, they are read again when accessed
+    void release(std::size_t offset);
+
+private:
+    const char *m_data = nullptr;
+    std::size_t m_size = 0u;
+    std::size_t m_released = 0u;
+};
+} // namespace LogDecoder
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,151 @@
+#include "Recovery.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include "../Logger/CrashHandler.h"
+#include "../Logger/MappedLogger.h"
+
+namespace LogDecoder
+{
+namespace
+{
+using Header = Details::MappedHeader;
+
+// NOTE: copied field by field, the atomic tail is read as the plain integer it is in the file
+std::uint64_t field(const std::span<const char> file, const std::size_t offset)
+{
+    std::uint64_t value;
+    std::memcpy(&value, file.data() + offset, sizeof(value));
+    return value;
+}
+} // namespace
+
+RingHeader readRingHeader(const std::span<const char> file)
+{
+    using BlockOffset = Details::RingLayout<0u>::BlockOffset;
+
+    if (file.size() < sizeof(Header))
+    {
+        throw std::runtime_error("Missing ring header");
+    }
+    std::array<char, 8> magic;
+    std::memcpy(magic.data(), file.data() + offsetof(Header, magic), magic.size());
+    if (magic != Header::expectedMagic)
+    {
+        throw std::runtime_error("Not a ring file");
+    }
+    RingHeader header;
+    header.writerSlotsOffset = field(file, offsetof(Header, writerSlotsOffset));
+    header.writerSlotCount = field(file, offsetof(Header, writerSlotCount));
+    header.blockOffsetsOffset = field(file, offsetof(Header, blockOffsetsOffset));
+    header.bufferOffset = field(file, offsetof(Header, bufferOffset));
+    header.bufferSize = field(file, offsetof(Header, bufferSize));
+    header.blockSize = field(file, offsetof(Header, blockSize));
+    if (header.blockSize == 0u || header.bufferSize % header.blockSize != 0u || header.bufferOffset > file.size() || header.bufferSize > file.size() - header.bufferOffset ||
+        header.blockOffsetsOffset > header.bufferOffset || header.bufferSize / header.blockSize * sizeof(BlockOffset) > header.bufferOffset - header.blockOffsetsOffset ||
+        header.writerSlotsOffset < sizeof(Header) || header.writerSlotsOffset > header.blockOffsetsOffset ||
+        header.writerSlotCount > (header.blockOffsetsOffset - header.writerSlotsOffset) / sizeof(Details::MappedWriterSlot))
+    {
+        throw std::runtime_error("Corrupt ring header");
+    }
+
+    const std::uint64_t buildIdSize = std::min<std::uint64_t>(field(file, offsetof(Header, buildIdSize)), sizeof(Header::buildId));
+    const auto *buildId = reinterpret_cast<const unsigned char *>(file.data() + offsetof(Header, buildId));
+    header.buildId.assign(buildId, buildId + buildIdSize);
+    if (field(file, offsetof(Header, calibrated)) != 0u)
+    {
+        Clocks::Calibration calibration;
+        std::memcpy(&calibration, file.data() + offsetof(Header, calibration), sizeof(calibration));
+        header.calibration = calibration;
+    }
+    header.pid = field(file, offsetof(Header, pid));
+    return header;
+}
+
+RecoveredRing recover(const std::span<const char> file)
+{
+    using BlockOffset = Details::RingLayout<0u>::BlockOffset;
+    constexpr BlockOffset noRecord = Details::RingLayout<0u>::noRecord;
+
+    const RingHeader header = readRingHeader(file);
+    const std::uint64_t blockOffsetsOffset = header.blockOffsetsOffset;
+    const std::uint64_t bufferSize = header.bufferSize;
+    const std::uint64_t blockSize = header.blockSize;
+    const std::uint64_t end = field(file, offsetof(Header, nonModTail));
+
+    RecoveredRing ring;
+    ring.buildId = header.buildId;
+    ring.calibration = header.calibration;
+    ring.pid = header.pid;
+
+    // Once wrapped, continue at the first record that starts in a later block, as CircularBuffer does
+    std::uint64_t begin = std::max(end, bufferSize) - bufferSize;
+    if (begin > 0u)
+    {
+        const std::uint64_t blockCount = bufferSize / blockSize;
+        std::uint64_t first = end;
+        for (std::uint64_t block = begin / blockSize + 1u; block * blockSize < end; ++block)
+        {
+            BlockOffset offset;
+            std::memcpy(&offset, file.data() + blockOffsetsOffset + block % blockCount * sizeof(BlockOffset), sizeof(offset));
+            if (offset != noRecord)
+            {
+                first = std::min(end, block * blockSize + offset);
+                break;
+            }
+        }
+        ring.lostBytes = first - begin;
+        begin = first;
+    }
+    const char *buffer = file.data() + header.bufferOffset;
+    const std::uint64_t modBegin = begin % bufferSize;
+    const std::uint64_t firstPart = std::min(end - begin, bufferSize - modBegin);
+    ring.records.reserve(end - begin);
+    ring.records.append(buffer + modBegin, firstPart);
+    ring.records.append(buffer, end - begin - firstPart);
+    return ring;
+}
+
+CrashDump readCrashDump(const std::span<const char> file)
+{
+    using Header = Details::CrashHeader;
+    using Section = Details::CrashSection;
+
+    Header header;
+    if (file.size() < sizeof(header))
+    {
+        throw std::runtime_error("Missing crash dump header");
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != Header::expectedMagic)
+    {
+        throw std::runtime_error("Not a crash dump");
+    }
+    CrashDump dump{header.signal, header.code, header.faultAddress, header.threadId, {}};
+    const std::vector<unsigned char> buildId(header.buildId.begin(), header.buildId.begin() + std::min<std::uint64_t>(header.buildIdSize, header.buildId.size()));
+
+    for (std::size_t offset = sizeof(header); file.size() - offset >= sizeof(Section);)
+    {
+        Section section;
+        std::memcpy(&section, file.data() + offset, sizeof(section));
+        offset += sizeof(section);
+        // NOTE: the size of a section that got cut short was never written
+        const std::uint64_t size = std::min<std::uint64_t>(section.size, file.size() - offset);
+        const std::uint64_t validFrom = std::min(section.validFrom, size);
+
+        RecoveredRing &ring = dump.loggers.emplace_back();
+        ring.records.assign(file.data() + offset + validFrom, size - validFrom);
+        if (section.calibrated != 0u)
+        {
+            ring.calibration = section.calibration;
+        }
+        ring.buildId = buildId;
+        ring.lostBytes = validFrom;
+        offset += size;
+    }
+    return dump;
+}
+} // namespace LogDecoder
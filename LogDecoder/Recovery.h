@@ -0,0 +1,62 @@
+#ifndef RECOVERY_H
+#define RECOVERY_H
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../Logger/Logger.h"
+
+namespace LogDecoder
+{
+/// Fixed fields of the file of a MappedLogger, see Details::MappedHeader
+struct RingHeader
+{
+    std::uint64_t writerSlotsOffset = 0u;
+    std::uint64_t writerSlotCount = 0u;
+    std::uint64_t blockOffsetsOffset = 0u;
+    std::uint64_t bufferOffset = 0u;
+    std::uint64_t bufferSize = 0u;
+    std::uint64_t blockSize = 0u;
+    std::optional<Clocks::Calibration> calibration;
+    std::vector<unsigned char> buildId; /// of the executable that traced, empty if unknown
+    std::uint64_t pid = 0u; /// of the process that traced
+};
+
+/// Checks the header of the file and reads all of it but the write position
+RingHeader readRingHeader(std::span<const char> file);
+
+/// Records of a file written by a MappedLogger, e.g. after the process crashed
+struct RecoveredRing
+{
+    std::string records; /// oldest first, in the Plain format
+    std::optional<Clocks::Calibration> calibration;
+    std::vector<unsigned char> buildId; /// of the executable that traced, empty if unknown
+    std::uint64_t lostBytes = 0u; /// of the oldest record, torn in two by the wrap around
+    std::uint64_t pid = 0u; /// of the process that traced, 0 if unknown
+};
+
+/// Puts the records of the ring in order, starting at the first complete one
+///
+/// Records that were in flight when the process died can be incomplete at the end.
+RecoveredRing recover(std::span<const char> file);
+
+/// Dump written by the CrashHandler from a fatal signal
+struct CrashDump
+{
+    int signal = 0;
+    int code = 0; /// si_code, e.g. SEGV_MAPERR
+    std::uint64_t faultAddress = 0u;
+    std::uint64_t threadId = 0u;
+    std::vector<RecoveredRing> loggers; /// in the order of their registration slots
+};
+
+/// Splits a crash dump into the records of each logger
+///
+/// Records that got overwritten while the handler wrote them count as lost bytes.
+CrashDump readCrashDump(std::span<const char> file);
+} // namespace LogDecoder
+
+#endif // RECOVERY_H
@@ -0,0 +1,151 @@
+#include "SpanStatistics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "SymbolIndex.h"
+
+namespace LogDecoder
+{
+namespace
+{
+constexpr std::uint64_t s_subBucketCount = std::uint64_t{1u} << LatencyHistogram::subBucketBits;
+} // namespace
+
+void LatencyHistogram::record(const std::int64_t value)
+{
+    const std::int64_t clamped = std::max<std::int64_t>(value, 0);
+    const std::size_t bucket = bucketOf(static_cast<std::uint64_t>(clamped));
+    if (bucket >= m_counts.size())
+    {
+        m_counts.resize(bucket + 1u);
+    }
+    ++m_counts[bucket];
+    m_min = m_count == 0u ? clamped : std::min(m_min, clamped);
+    m_max = m_count == 0u ? clamped : std::max(m_max, clamped);
+    m_sum += static_cast<double>(clamped);
+    ++m_count;
+}
+
+std::int64_t LatencyHistogram::percentile(const double fraction) const
+{
+    if (m_count == 0u)
+    {
+        return 0;
+    }
+    const auto rank = std::clamp<std::uint64_t>(static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(m_count))), 1u, m_count);
+    std::uint64_t below = 0u;
+    for (std::size_t bucket = 0u; bucket < m_counts.size(); ++bucket)
+    {
+        below += m_counts[bucket];
+        if (below >= rank)
+        {
+            return std::clamp(static_cast<std::int64_t>(highestOf(bucket)), m_min, m_max);
+        }
+    }
+    return m_max;
+}
+
+/// Values below s_subBucketCount map to themselves, [2^m, 2^(m+1)) to s_subBucketCount buckets
+std::size_t LatencyHistogram::bucketOf(const std::uint64_t value)
+{
+    if (value < s_subBucketCount)
+    {
+        return value;
+    }
+    const int shift = std::bit_width(value) - 1 - subBucketBits;
+    return static_cast<std::size_t>((static_cast<std::uint64_t>(shift) + 1u) * s_subBucketCount + (value >> shift) - s_subBucketCount);
+}
+
+std::uint64_t LatencyHistogram::highestOf(const std::size_t bucket)
+{
+    if (bucket < s_subBucketCount)
+    {
+        return bucket;
+    }
+    const int shift = static_cast<int>(bucket / s_subBucketCount) - 1;
+    const std::uint64_t lowest = (s_subBucketCount + bucket % s_subBucketCount) << shift;
+    return lowest + ((std::uint64_t{1u} << shift) - 1u);
+}
+
+SpanStatistics::SpanStatistics(const SymbolIndex &symbols)
+    : m_symbols(symbols)
+{
+}
+
+void SpanStatistics::add(const Record &record)
+{
+    if (!record.span)
+    {
+        return;
+    }
+    auto callSite = m_callSites.find(record.address);
+    if (callSite == m_callSites.end())
+    {
+        std::string name = m_symbols.resolveFunction(record.address);
+        if (name.empty())
+        {
+            name = "??";
+        }
+        if (!record.type->format.empty())
+        {
+            name += ' ' + record.type->format;
+        }
+        // NOTE: the separator of the frames in a stack
+        std::ranges::replace(name, ';', ':');
+        callSite = m_callSites.emplace(record.address, CallSite{std::move(name), {}}).first;
+    }
+    callSite->second.latencies.record(record.span->duration);
+    m_threads[record.span->thread].push_back({record.time, record.span->duration, record.span->depth, &callSite->second});
+}
+
+void SpanStatistics::writeStacksTo(std::ostream &s) const
+{
+    std::map<std::string, std::int64_t> stacks;
+    for (const auto &[thread, recorded] : m_threads)
+    {
+        // NOTE: an enclosing span starts first, or at the same time with a lower depth
+        std::vector<Instance> instances = recorded;
+        std::ranges::sort(instances, [](const Instance &a, const Instance &b) { return a.begin != b.begin ? a.begin < b.begin : a.depth < b.depth; });
+
+        std::vector<std::string> paths(instances.size());
+        std::vector<std::int64_t> selfTimes(instances.size());
+        std::vector<std::size_t> open; // index of the latest span at each depth
+        constexpr std::size_t unknown = ~std::size_t{0u};
+        for (std::size_t i = 0u; i < instances.size(); ++i)
+        {
+            const Instance &instance = instances[i];
+            open.resize(instance.depth, unknown);
+            std::string &path = paths[i];
+            if (instance.depth == 0u)
+            {
+                path = instance.callSite->name;
+            }
+            else if (const std::size_t parent = open.back(); parent != unknown && instances[parent].begin + instances[parent].duration >= instance.begin)
+            {
+                path = paths[parent] + ';' + instance.callSite->name;
+                selfTimes[parent] -= instance.duration;
+            }
+            else
+            {
+                for (std::size_t d = 0u; d < instance.depth; ++d)
+                {
+                    path += "[unknown];";
+                }
+                path += instance.callSite->name;
+            }
+            selfTimes[i] += instance.duration;
+            open.push_back(i);
+        }
+        for (std::size_t i = 0u; i < instances.size(); ++i)
+        {
+            stacks[paths[i]] += std::max<std::int64_t>(selfTimes[i], 0);
+        }
+    }
+    for (const auto &[path, time] : stacks)
+    {
+        s << path << ' ' << time << '\n';
+    }
+}
+} // namespace LogDecoder
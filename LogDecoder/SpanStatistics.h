@@ -0,0 +1,102 @@
+#ifndef SPAN_STATISTICS_H
+#define SPAN_STATISTICS_H
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "LogDecoder.h"
+
+namespace LogDecoder
+{
+class SymbolIndex;
+
+/// Counts of values in logarithmic buckets of linear sub-buckets, as HdrHistogram does
+///
+/// Values below 2^subBucketBits are exact, larger ones are kept within a relative error of
+/// 2^-subBucketBits, in a few kilobytes for the whole range of std::int64_t.
+class LatencyHistogram
+{
+public:
+    static constexpr int subBucketBits = 5;
+
+    /// Negative values count as 0
+    void record(std::int64_t value);
+
+    std::uint64_t count() const
+    {
+        return m_count;
+    }
+    std::int64_t min() const
+    {
+        return m_min;
+    }
+    std::int64_t max() const
+    {
+        return m_max;
+    }
+    double mean() const
+    {
+        return m_count == 0u ? 0.0 : m_sum / static_cast<double>(m_count);
+    }
+    /// Highest value of the bucket that holds the fraction of the values, e.g. 0.99
+    std::int64_t percentile(double fraction) const;
+
+private:
+    static std::size_t bucketOf(std::uint64_t value);
+    static std::uint64_t highestOf(std::size_t bucket);
+
+    std::vector<std::uint64_t> m_counts;
+    std::uint64_t m_count = 0u;
+    std::int64_t m_min = 0;
+    std::int64_t m_max = 0;
+    double m_sum = 0.0;
+};
+
+/// Latencies per call site and stacks of the Logger::span records of a dump
+///
+/// The records of enclosing spans follow those of the spans they enclose, so the stacks are
+/// only put together by writeStacksTo, once all records are in.
+class SpanStatistics
+{
+public:
+    struct CallSite
+    {
+        std::string name; /// the function, followed by the format of a span<format>
+        LatencyHistogram latencies;
+    };
+
+    explicit SpanStatistics(const SymbolIndex &symbols);
+
+    /// Adds the record of a span, ignores any other
+    void add(const Record &record);
+
+    /// By the address of the call site
+    const std::map<std::uintptr_t, CallSite> &callSites() const
+    {
+        return m_callSites;
+    }
+    /// One line per stack, outermost span first, with the time spent in the innermost span
+    /// itself, e.g. "main;handle;parse 1200", the input of flamegraph.pl
+    ///
+    /// Spans whose enclosing spans were overwritten start with [unknown] frames.
+    void writeStacksTo(std::ostream &s) const;
+
+private:
+    struct Instance
+    {
+        std::int64_t begin;
+        std::int64_t duration;
+        std::uint16_t depth;
+        const CallSite *callSite;
+    };
+
+    const SymbolIndex &m_symbols;
+    std::map<std::uintptr_t, CallSite> m_callSites;
+    std::map<std::uint16_t, std::vector<Instance>> m_threads;
+};
+} // namespace LogDecoder
+
+#endif // SPAN_STATISTICS_H
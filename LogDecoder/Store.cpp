@@ -0,0 +1,283 @@
+#include "Store.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include "MappedFile.h"
+
+namespace LogDecoder
+{
+namespace
+{
+constexpr std::size_t s_bloomProbes = 4u;
+
+/// Bytes of the bloom filter of a segment, 8 KiB for the default segment size
+std::size_t bloomSize(const std::uint64_t segmentSize)
+{
+    return static_cast<std::size_t>(std::clamp<std::uint64_t>(segmentSize >> 13, 64u, 8u << 10));
+}
+
+/// Bit of a bloom filter of size bytes for each probe, from 16 bits each of a mixed address
+template <typename F>
+void forEachProbe(const std::uintptr_t address, const std::size_t size, F f)
+{
+    std::uint64_t hash = address;
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9u;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBu;
+    hash ^= hash >> 31;
+    for (std::size_t probe = 0u; probe < s_bloomProbes; ++probe)
+    {
+        f(static_cast<std::size_t>(hash >> (16u * probe) & 0xFFFFu) % (8u * size));
+    }
+}
+
+template <typename T>
+void writeValue(std::ostream &s, const T &value)
+{
+    s.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/// Sequence of a <sequence>.seg file, none for other files
+std::optional<std::uint64_t> segmentSequence(const std::filesystem::path &path)
+{
+    const std::string stem = path.stem().string();
+    if (path.extension() != ".seg" || stem.empty() || !std::ranges::all_of(stem, [](const char c) { return c >= '0' && c <= '9'; }))
+    {
+        return std::nullopt;
+    }
+    return std::stoull(stem);
+}
+
+std::string segmentPath(const std::string &directory, const std::uint64_t sequence, const std::string_view extension)
+{
+    std::string name = std::to_string(sequence);
+    name.insert(0u, name.size() < 12u ? 12u - name.size() : 0u, '0');
+    return (std::filesystem::path(directory) / (name + std::string(extension))).string();
+}
+} // namespace
+
+StoreWriter::StoreWriter(const std::string &directory, const std::span<const char> header, const std::uint64_t budget, const std::uint64_t segmentSize,
+                         const std::uint64_t indexInterval)
+    : m_directory(directory)
+    , m_header(header.data(), header.size())
+    , m_budget(budget)
+    , m_segmentSize(segmentSize)
+    , m_indexInterval(indexInterval)
+{
+    if (budget < segmentSize || indexInterval == 0u)
+    {
+        throw std::runtime_error("The store budget must hold a segment");
+    }
+    std::filesystem::create_directories(directory);
+    std::vector<std::pair<std::uint64_t, Segment>> segments;
+    for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(directory))
+    {
+        if (const std::optional<std::uint64_t> sequence = segmentSequence(entry.path()); sequence && entry.is_regular_file())
+        {
+            segments.push_back({*sequence, {entry.path().string(), entry.file_size()}});
+        }
+    }
+    std::ranges::sort(segments, {}, &std::pair<std::uint64_t, Segment>::first);
+    for (auto &[sequence, segment] : segments)
+    {
+        m_storedBytes += segment.size;
+        m_segments.push_back(std::move(segment));
+        m_sequence = sequence + 1u;
+    }
+}
+
+void StoreWriter::write(const Record &record)
+{
+    if (record.type->special == TraceType::Special::TimeAnchor)
+    {
+        // NOTE: the Plain format keeps whole time stamps
+        return;
+    }
+    std::string &plain = m_record;
+    plain.resize(sizeof(std::int64_t) + 2 * sizeof(std::uintptr_t));
+    std::memcpy(plain.data(), &record.ticks, sizeof(std::int64_t));
+    std::memcpy(plain.data() + sizeof(std::int64_t), &record.address, sizeof(std::uintptr_t));
+    std::memcpy(plain.data() + sizeof(std::int64_t) + sizeof(std::uintptr_t), &record.typeInfo, sizeof(std::uintptr_t));
+    plain.append(record.payload.data(), record.payload.size());
+    if (record.type->special == TraceType::Special::Calibration)
+    {
+        // NOTE: repeated at the start of every segment, such that each keeps the time base
+        m_calibration = plain;
+        if (m_offset != 0u)
+        {
+            m_file.write(plain.data(), static_cast<std::streamsize>(plain.size()));
+            m_offset += plain.size();
+        }
+        return;
+    }
+
+    if (m_offset != 0u && m_footer.recordCount > 0u && m_offset + plain.size() > m_segmentSize)
+    {
+        close();
+    }
+    if (m_offset == 0u)
+    {
+        open();
+    }
+    if (m_index.empty() || m_offset >= m_index.back().offset + m_indexInterval)
+    {
+        m_index.push_back({m_offset, m_footer.lastTime, 0});
+        m_intervalMinTimes.push_back(std::numeric_limits<std::int64_t>::max());
+    }
+    m_file.write(plain.data(), static_cast<std::streamsize>(plain.size()));
+    m_offset += plain.size();
+    ++m_footer.recordCount;
+    m_footer.firstTime = std::min(m_footer.firstTime, record.time);
+    m_footer.lastTime = std::max(m_footer.lastTime, record.time);
+    m_intervalMinTimes.back() = std::min(m_intervalMinTimes.back(), record.time);
+    forEachProbe(record.address, m_bloom.size(), [this](const std::size_t bit) { m_bloom[bit / 8u] |= static_cast<unsigned char>(1u << (bit % 8u)); });
+}
+
+void StoreWriter::finish()
+{
+    if (m_offset != 0u)
+    {
+        close();
+    }
+}
+
+void StoreWriter::open()
+{
+    const std::string path = segmentPath(m_directory, m_sequence, ".open");
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file)
+    {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    m_file.write(m_header.data(), static_cast<std::streamsize>(m_header.size()));
+    m_file.write(m_calibration.data(), static_cast<std::streamsize>(m_calibration.size()));
+    m_offset = m_header.size() + m_calibration.size();
+    m_footer = {};
+    std::memcpy(m_footer.magic, s_storeMagic.data(), sizeof(m_footer.magic));
+    m_footer.firstTime = std::numeric_limits<std::int64_t>::max();
+    m_footer.lastTime = std::numeric_limits<std::int64_t>::min();
+    m_index.clear();
+    m_intervalMinTimes.clear();
+    m_bloom.assign(bloomSize(m_segmentSize), 0u);
+}
+
+void StoreWriter::close()
+{
+    std::int64_t minTime = std::numeric_limits<std::int64_t>::max();
+    for (std::size_t i = m_index.size(); i-- > 0u;)
+    {
+        minTime = std::min(minTime, m_intervalMinTimes[i]);
+        m_index[i].minTimeAfter = minTime;
+    }
+    m_footer.recordsEnd = m_offset;
+    m_footer.indexCount = m_index.size();
+    m_footer.bloomSize = m_bloom.size();
+    m_file.write(reinterpret_cast<const char *>(m_index.data()), static_cast<std::streamsize>(m_index.size() * sizeof(StoreIndexEntry)));
+    m_file.write(reinterpret_cast<const char *>(m_bloom.data()), static_cast<std::streamsize>(m_bloom.size()));
+    writeValue(m_file, m_footer);
+    m_file.close();
+    const std::string path = segmentPath(m_directory, m_sequence, ".open");
+    if (!m_file)
+    {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    const std::string completePath = segmentPath(m_directory, m_sequence, ".seg");
+    std::filesystem::rename(path, completePath);
+    const std::uint64_t size = m_offset + m_index.size() * sizeof(StoreIndexEntry) + m_bloom.size() + sizeof(StoreFooter);
+    m_segments.push_back({completePath, size});
+    m_storedBytes += size;
+    ++m_sequence;
+    m_offset = 0u;
+
+    while (m_storedBytes > m_budget && m_segments.size() > 1u)
+    {
+        std::filesystem::remove(m_segments.front().path);
+        m_storedBytes -= m_segments.front().size;
+        m_segments.pop_front();
+        ++m_removedCount;
+    }
+}
+
+bool StoreSegment::mayContain(const std::uintptr_t address) const
+{
+    if (bloom.empty())
+    {
+        return true;
+    }
+    bool contained = true;
+    forEachProbe(address, bloom.size(), [this, &contained](const std::size_t bit) { contained = contained && (bloom[bit / 8u] >> (bit % 8u) & 1u) != 0u; });
+    return contained;
+}
+
+StoreReader::StoreReader(const std::string &directory)
+{
+    for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(directory))
+    {
+        const std::optional<std::uint64_t> sequence = segmentSequence(entry.path());
+        if (!sequence || !entry.is_regular_file())
+        {
+            continue;
+        }
+        StoreSegment segment{entry.path().string(), *sequence, {}, {}, {}};
+        const std::uint64_t size = entry.file_size();
+        std::ifstream file(segment.path, std::ios::binary);
+        const auto corrupt = [&segment] { return std::runtime_error("Corrupt store segment " + segment.path); };
+        if (size < sizeof(StoreFooter) || !file.seekg(static_cast<std::streamoff>(size - sizeof(StoreFooter)))
+            || !file.read(reinterpret_cast<char *>(&segment.footer), sizeof(StoreFooter))
+            || std::string_view(segment.footer.magic, sizeof(segment.footer.magic)) != s_storeMagic)
+        {
+            throw corrupt();
+        }
+        const StoreFooter &footer = segment.footer;
+        if (footer.indexCount > size / sizeof(StoreIndexEntry) || footer.bloomSize > size
+            || footer.recordsEnd + footer.indexCount * sizeof(StoreIndexEntry) + footer.bloomSize + sizeof(StoreFooter) != size)
+        {
+            throw corrupt();
+        }
+        segment.index.resize(footer.indexCount);
+        segment.bloom.resize(footer.bloomSize);
+        if (!file.seekg(static_cast<std::streamoff>(footer.recordsEnd))
+            || !file.read(reinterpret_cast<char *>(segment.index.data()), static_cast<std::streamsize>(segment.index.size() * sizeof(StoreIndexEntry)))
+            || !file.read(reinterpret_cast<char *>(segment.bloom.data()), static_cast<std::streamsize>(segment.bloom.size())))
+        {
+            throw corrupt();
+        }
+        m_segments.push_back(std::move(segment));
+    }
+    std::ranges::sort(m_segments, {}, &StoreSegment::sequence);
+}
+
+std::uint64_t StoreReader::query(const StoreQuery &query, SymbolIndex &symbols, const std::function<void(const Record &)> &consume) const
+{
+    std::uint64_t recordCount = 0u;
+    for (const StoreSegment &segment : m_segments)
+    {
+        const StoreFooter &footer = segment.footer;
+        if (segment.index.empty() || footer.lastTime < query.from || footer.firstTime > query.to || (query.address && !segment.mayContain(*query.address)))
+        {
+            continue;
+        }
+        // NOTE: the latest times before the entries and the earliest ones after them only grow
+        const auto first = std::ranges::partition_point(segment.index, [&query](const StoreIndexEntry &entry) { return entry.maxTimeBefore < query.from; });
+        const auto last = std::ranges::partition_point(segment.index, [&query](const StoreIndexEntry &entry) { return entry.minTimeAfter <= query.to; });
+        const std::uint64_t begin = (first == segment.index.begin() ? first : first - 1)->offset;
+        const std::uint64_t end = last == segment.index.end() ? footer.recordsEnd : last->offset;
+
+        const MappedFile file(segment.path);
+        Decoder decoder(file.data().first(footer.recordsEnd), symbols);
+        decoder.seek(begin);
+        Record record;
+        while (decoder.offset() < end && decoder.next(record))
+        {
+            if (record.time >= query.from && record.time <= query.to && (!query.address || record.address == *query.address))
+            {
+                ++recordCount;
+                consume(record);
+            }
+        }
+    }
+    return recordCount;
+}
+} // namespace LogDecoder
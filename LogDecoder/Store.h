@@ -0,0 +1,150 @@
+#ifndef STORE_H
+#define STORE_H
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LogDecoder.h"
+
+namespace LogDecoder
+{
+/// Entry of the sparse time index of a store segment, one per index interval of records
+struct __attribute__((packed)) StoreIndexEntry
+{
+    std::uint64_t offset; /// of the first record of the interval
+    std::int64_t maxTimeBefore; /// latest time of the records in front of the offset
+    std::int64_t minTimeAfter; /// earliest time of the records from the offset on
+};
+
+/// End of a store segment, after its index entries and its call site bloom filter
+struct __attribute__((packed)) StoreFooter
+{
+    char magic[8]; /// s_storeMagic
+    std::uint64_t recordsEnd; /// where the index entries start
+    std::uint64_t recordCount;
+    std::int64_t firstTime; /// earliest time of the records
+    std::int64_t lastTime; /// latest time of the records
+    std::uint64_t indexCount;
+    std::uint64_t bloomSize; /// bytes, after the index entries
+};
+
+constexpr std::string_view s_storeMagic = "MinLogS1";
+
+/// Writes records into a directory of segment files of about segmentSize bytes each, keeping
+/// at most budget bytes on disk
+///
+/// A segment is a dump of the Plain format of its own: the Details::DumpHeader of the records,
+/// the last calibration record, if any, and the records, followed by a StoreIndexEntry every
+/// indexInterval bytes of records, a bloom filter of the call site addresses and a StoreFooter.
+/// It is written as <sequence>.open and renamed to <sequence>.seg once complete. Whenever the
+/// segments exceed the budget, the oldest are removed. The segments already in the directory
+/// count towards the budget, the sequence continues after them. Thread ids of Sharded records
+/// are dropped.
+class StoreWriter
+{
+public:
+    static constexpr std::uint64_t s_defaultSegmentSize = 64u << 20;
+    static constexpr std::uint64_t s_defaultIndexInterval = 64u << 10;
+
+    StoreWriter(const std::string &directory, std::span<const char> header, std::uint64_t budget, std::uint64_t segmentSize = s_defaultSegmentSize,
+                std::uint64_t indexInterval = s_defaultIndexInterval);
+
+    /// Any record of the Plain, Compact or Indexed formats, see Decoder::nextAny
+    void write(const Record &record);
+    /// Completes the current segment
+    void finish();
+
+    /// Of the complete segments in the directory
+    std::uint64_t storedBytes() const
+    {
+        return m_storedBytes;
+    }
+    /// Segments removed to stay within the budget
+    std::uint64_t removedCount() const
+    {
+        return m_removedCount;
+    }
+
+private:
+    struct Segment
+    {
+        std::string path;
+        std::uint64_t size;
+    };
+
+    void open();
+    void close();
+
+    const std::string m_directory;
+    const std::string m_header;
+    const std::uint64_t m_budget;
+    const std::uint64_t m_segmentSize;
+    const std::uint64_t m_indexInterval;
+    std::deque<Segment> m_segments; /// complete, oldest first
+    std::uint64_t m_storedBytes = 0u;
+    std::uint64_t m_removedCount = 0u;
+    std::uint64_t m_sequence = 0u; /// of the next segment
+    std::string m_calibration; /// last calibration record, in the Plain format
+    std::string m_record; /// being written, in the Plain format
+    std::ofstream m_file;
+    std::uint64_t m_offset = 0u; /// in the current segment, 0 if there is none
+    StoreFooter m_footer{};
+    std::vector<StoreIndexEntry> m_index;
+    std::vector<std::int64_t> m_intervalMinTimes; /// earliest time of the records of each index entry
+    std::vector<unsigned char> m_bloom;
+};
+
+/// Complete segment of a store, as listed by StoreReader
+struct StoreSegment
+{
+    std::string path;
+    std::uint64_t sequence;
+    StoreFooter footer;
+    std::vector<StoreIndexEntry> index;
+    std::vector<unsigned char> bloom;
+
+    /// False if no record of the segment was traced at the address, true if some may be
+    bool mayContain(std::uintptr_t address) const;
+};
+
+/// Records of a StoreReader query, between from and to inclusive, of the call site if any
+struct StoreQuery
+{
+    std::int64_t from = std::numeric_limits<std::int64_t>::min(); /// nanoseconds if calibrated, ticks otherwise
+    std::int64_t to = std::numeric_limits<std::int64_t>::max();
+    std::optional<std::uintptr_t> address;
+};
+
+/// Queries the segments of a StoreWriter directory without scanning them
+///
+/// Only the footers, index entries and bloom filters are read up front. A query skips the
+/// segments outside of its time range or without its call site, and decodes each remaining
+/// one from the last index entry before the range to the first one after it.
+class StoreReader
+{
+public:
+    explicit StoreReader(const std::string &directory);
+
+    /// Oldest first
+    const std::vector<StoreSegment> &segments() const
+    {
+        return m_segments;
+    }
+
+    /// Passes the records of the query to consume, in the order of the segments, returns their number
+    std::uint64_t query(const StoreQuery &query, SymbolIndex &symbols, const std::function<void(const Record &)> &consume) const;
+
+private:
+    std::vector<StoreSegment> m_segments;
+};
+} // namespace LogDecoder
+
+#endif // STORE_H
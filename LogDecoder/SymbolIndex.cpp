@@ -0,0 +1,154 @@
+#include "SymbolIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <cxxabi.h>
+#include <elf.h>
+
+#include "MappedFile.h"
+
+namespace LogDecoder
+{
+namespace
+{
+template <typename T>
+const T *at(const std::span<const char> data, const std::size_t offset, const std::size_t count = 1u)
+{
+    if (offset > data.size() || count * sizeof(T) > data.size() - offset)
+    {
+        throw std::runtime_error("Truncated ELF file");
+    }
+    return reinterpret_cast<const T *>(data.data() + offset);
+}
+} // namespace
+
+SymbolIndex::SymbolIndex() = default;
+
+SymbolIndex::SymbolIndex(const std::string &elfFilePath)
+    : m_file(std::make_unique<MappedFile>(elfFilePath))
+{
+    const std::span<const char> data = m_file->data();
+    const auto *header = at<Elf64_Ehdr>(data, 0u);
+    if (std::memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 || header->e_ident[EI_CLASS] != ELFCLASS64)
+    {
+        throw std::runtime_error(elfFilePath + " is not a 64-bit ELF file");
+    }
+
+    // NOTE: the load bias of position independent code is a multiple of the segment alignment
+    const auto *segments = at<Elf64_Phdr>(data, header->e_phoff, header->e_phnum);
+    for (const Elf64_Phdr &segment : std::span(segments, header->e_phnum))
+    {
+        if (segment.p_type == PT_LOAD && segment.p_align > 0u)
+        {
+            m_alignment = segment.p_align;
+            break;
+        }
+    }
+
+    const auto *sections = at<Elf64_Shdr>(data, header->e_shoff, header->e_shnum);
+    const std::span<const Elf64_Shdr> sectionTable(sections, header->e_shnum);
+    for (const Elf64_Shdr &section : sectionTable)
+    {
+        for (std::size_t offset = 0u; section.sh_type == SHT_NOTE && offset + sizeof(Elf64_Nhdr) <= section.sh_size;)
+        {
+            const auto *note = at<Elf64_Nhdr>(data, section.sh_offset + offset);
+            const std::size_t name = section.sh_offset + offset + sizeof(Elf64_Nhdr);
+            const std::size_t description = name + (note->n_namesz + 3u) / 4u * 4u;
+            if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4u && std::memcmp(at<char>(data, name, 4u), "GNU", 4u) == 0)
+            {
+                m_buildId = {at<unsigned char>(data, description, note->n_descsz), note->n_descsz};
+            }
+            offset = description + (note->n_descsz + 3u) / 4u * 4u - section.sh_offset;
+        }
+    }
+
+    // Prefer the full symbol table, the dynamic one only has the exported symbols
+    auto symbolTable = std::ranges::find(sectionTable, Elf64_Word{SHT_SYMTAB}, &Elf64_Shdr::sh_type);
+    if (symbolTable == sectionTable.end())
+    {
+        symbolTable = std::ranges::find(sectionTable, Elf64_Word{SHT_DYNSYM}, &Elf64_Shdr::sh_type);
+    }
+    if (symbolTable == sectionTable.end())
+    {
+        throw std::runtime_error(elfFilePath + " has no symbol table");
+    }
+    const Elf64_Shdr &stringTable = sectionTable[symbolTable->sh_link];
+    const std::span<const char> names(at<char>(data, stringTable.sh_offset, stringTable.sh_size), stringTable.sh_size);
+
+    const std::size_t symbolCount = symbolTable->sh_size / sizeof(Elf64_Sym);
+    const auto *symbols = at<Elf64_Sym>(data, symbolTable->sh_offset, symbolCount);
+    m_symbols.reserve(symbolCount);
+    for (const Elf64_Sym &symbol : std::span(symbols, symbolCount))
+    {
+        const unsigned char type = ELF64_ST_TYPE(symbol.st_info);
+        if ((type != STT_FUNC && type != STT_OBJECT) || symbol.st_shndx == SHN_UNDEF || symbol.st_name >= names.size())
+        {
+            continue;
+        }
+        m_symbols.push_back({symbol.st_value, symbol.st_value + std::max<std::uintptr_t>(symbol.st_size, 1u), std::string_view(&names[symbol.st_name])});
+    }
+    std::ranges::sort(m_symbols, {}, &Symbol::begin);
+}
+
+SymbolIndex::~SymbolIndex() = default;
+
+bool SymbolIndex::inferLoadBias(const std::uintptr_t address, const std::string_view mangledPrefix, const std::uintptr_t otherAddress)
+{
+    const auto matches = [&] {
+        const Symbol *symbol = resolve(address);
+        return symbol != nullptr && symbol->mangledName.starts_with(mangledPrefix) && resolve(otherAddress) != nullptr;
+    };
+    if (matches())
+    {
+        return true;
+    }
+    const std::intptr_t previousLoadBias = m_loadBias;
+    for (const Symbol &symbol : m_symbols)
+    {
+        if (symbol.mangledName.starts_with(mangledPrefix) && (address - symbol.begin) % m_alignment == 0u)
+        {
+            m_loadBias = static_cast<std::intptr_t>(address - symbol.begin);
+            if (matches())
+            {
+                return true;
+            }
+        }
+    }
+    m_loadBias = previousLoadBias;
+    return false;
+}
+
+const SymbolIndex::Symbol *SymbolIndex::resolve(const std::uintptr_t address) const
+{
+    const std::uintptr_t linkAddress = address - static_cast<std::uintptr_t>(m_loadBias);
+    auto it = std::ranges::upper_bound(m_symbols, linkAddress, {}, &Symbol::begin);
+    if (it == m_symbols.begin())
+    {
+        return nullptr;
+    }
+    --it;
+    return linkAddress < it->end ? &*it : nullptr;
+}
+
+std::string SymbolIndex::resolveFunction(const std::uintptr_t address) const
+{
+    const Symbol *symbol = resolve(address);
+    return symbol != nullptr ? demangle(symbol->mangledName) : std::string{};
+}
+
+std::string SymbolIndex::demangle(const std::string_view mangledName)
+{
+    const std::string name(mangledName);
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+    if (status != 0 || demangled == nullptr)
+    {
+        return name;
+    }
+    std::string result(demangled);
+    std::free(demangled);
+    return result;
+}
+} // namespace LogDecoder
@@ -0,0 +1,75 @@
+#ifndef SYMBOL_INDEX_H
+#define SYMBOL_INDEX_H
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LogDecoder
+{
+class MappedFile;
+
+/// Sorted address intervals of the functions and objects in an ELF symbol table
+///
+/// Built once from the file (e.g. a .syms file from objcopy --only-keep-debug), after
+/// which every lookup is a binary search. The names point into the mapped file.
+class SymbolIndex
+{
+public:
+    struct Symbol
+    {
+        std::uintptr_t begin;
+        std::uintptr_t end;
+        std::string_view mangledName;
+    };
+
+    /// Without symbols, nothing resolves, for dumps that describe their types
+    SymbolIndex();
+    explicit SymbolIndex(const std::string &elfFilePath);
+    ~SymbolIndex();
+    SymbolIndex(const SymbolIndex &) = delete;
+    SymbolIndex &operator=(const SymbolIndex &) = delete;
+
+    /// Difference between the run-time and the link-time addresses
+    std::intptr_t loadBias() const
+    {
+        return m_loadBias;
+    }
+    void setLoadBias(std::intptr_t loadBias)
+    {
+        m_loadBias = loadBias;
+    }
+    /// Derives the load bias from the run-time address of a symbol starting with mangledPrefix,
+    /// such as the type tag of a record, and another run-time address that must resolve as well
+    bool inferLoadBias(std::uintptr_t address, std::string_view mangledPrefix, std::uintptr_t otherAddress);
+
+    /// Symbol containing the run-time address, if any
+    const Symbol *resolve(std::uintptr_t address) const;
+    /// Demangled name of the symbol containing the run-time address, empty if unknown
+    std::string resolveFunction(std::uintptr_t address) const;
+
+    const std::vector<Symbol> &symbols() const
+    {
+        return m_symbols;
+    }
+    /// NT_GNU_BUILD_ID note, empty if the file has none
+    std::span<const unsigned char> buildId() const
+    {
+        return m_buildId;
+    }
+
+    static std::string demangle(std::string_view mangledName);
+
+private:
+    std::unique_ptr<MappedFile> m_file;
+    std::vector<Symbol> m_symbols;
+    std::span<const unsigned char> m_buildId;
+    std::uintptr_t m_alignment = 0x1000;
+    std::intptr_t m_loadBias = 0;
+};
+} // namespace LogDecoder
+
+#endif // SYMBOL_INDEX_H
@@ -0,0 +1,154 @@
+#include "TraceEvents.h"
+
+#include <iomanip>
+#include <sstream>
+#include <string_view>
+
+#include "SymbolIndex.h"
+
+namespace LogDecoder
+{
+namespace
+{
+/// Appends the text as the contents of a JSON string
+void escape(std::ostream &s, const std::string_view text)
+{
+    for (const char c : text)
+    {
+        switch (c)
+        {
+        case '"':
+            s << "\\\"";
+            break;
+        case '\\':
+            s << "\\\\";
+            break;
+        case '\n':
+            s << "\\n";
+            break;
+        case '\t':
+            s << "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20u)
+            {
+                s << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+            }
+            else
+            {
+                s << c;
+            }
+        }
+    }
+}
+
+/// Microseconds with three decimals, the unit of the trace event format
+void writeMicroseconds(std::ostream &s, const std::int64_t nanoseconds)
+{
+    if (nanoseconds < 0)
+    {
+        s << '-';
+    }
+    const std::uint64_t magnitude = nanoseconds < 0 ? 0u - static_cast<std::uint64_t>(nanoseconds) : static_cast<std::uint64_t>(nanoseconds);
+    s << magnitude / 1000u << '.' << std::setw(3) << std::setfill('0') << magnitude % 1000u << std::setfill(' ');
+}
+} // namespace
+
+TraceEventWriter::TraceEventWriter(std::ostream &s, const SymbolIndex &symbols)
+    : m_stream(s)
+    , m_symbols(symbols)
+{
+}
+
+void TraceEventWriter::write(const Record &record)
+{
+    const std::uint32_t thread = record.threadId != Record::noThread ? record.threadId : record.span ? record.span->thread : 0u;
+    if (m_threads.insert(thread).second)
+    {
+        beginEvent();
+        m_stream << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << thread << R"(,"args":{"name":"thread )" << thread << "\"}}";
+    }
+
+    beginEvent();
+    m_stream << R"({"name":")" << nameOf(record.address) << R"(","cat":")" << (record.type->level ? levelName(*record.type->level) : std::string_view("trace"));
+    if (record.span)
+    {
+        m_stream << R"(","ph":"X","dur":)";
+        writeMicroseconds(m_stream, record.span->duration);
+    }
+    else
+    {
+        m_stream << R"(","ph":"i","s":"t")";
+    }
+    m_stream << ",\"ts\":";
+    writeMicroseconds(m_stream, record.time);
+    m_stream << ",\"pid\":1,\"tid\":" << thread << ",\"args\":{";
+
+    const char *separator = "";
+    if (!record.type->format.empty())
+    {
+        std::ostringstream message;
+        record.printMessage(message);
+        m_stream << "\"message\":\"";
+        escape(m_stream, message.view());
+        m_stream << '"';
+        separator = ",";
+    }
+    if (const std::uint64_t suppressed = record.suppressed(); suppressed > 0u)
+    {
+        m_stream << separator << "\"suppressed\":" << suppressed;
+        separator = ",";
+    }
+    for (std::size_t i = 0u; i < record.argumentCount(); ++i)
+    {
+        std::ostringstream value;
+        record.printArgument(value, i);
+        const ArgumentType::Kind kind = record.type->arguments[i]->kind;
+        // NOTE: inf and nan are not JSON numbers
+        const bool number = !record.type->payloads[i]
+                            && (kind == ArgumentType::Kind::Bool || kind == ArgumentType::Kind::Signed || kind == ArgumentType::Kind::Unsigned
+                                || (kind == ArgumentType::Kind::Floating && value.view().find_first_of("in") == std::string_view::npos));
+        m_stream << separator << "\"arg" << i << "\":";
+        if (number)
+        {
+            m_stream << value.view();
+        }
+        else
+        {
+            m_stream << '"';
+            escape(m_stream, value.view());
+            m_stream << '"';
+        }
+        separator = ",";
+    }
+    m_stream << "}}";
+}
+
+void TraceEventWriter::finish()
+{
+    if (m_empty)
+    {
+        beginEvent();
+    }
+    m_stream << "\n]}\n";
+}
+
+void TraceEventWriter::beginEvent()
+{
+    m_stream << (m_empty ? "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n" : ",\n");
+    m_empty = false;
+}
+
+const std::string &TraceEventWriter::nameOf(const std::uintptr_t address)
+{
+    auto name = m_names.find(address);
+    if (name == m_names.end())
+    {
+        const std::string function = m_symbols.resolveFunction(address);
+        std::ostringstream s;
+        escape(s, function.empty() ? "??" : function);
+        name = m_names.emplace(address, s.str()).first;
+    }
+    return name->second;
+}
+} // namespace LogDecoder
@@ -0,0 +1,44 @@
+#ifndef TRACE_EVENTS_H
+#define TRACE_EVENTS_H
+
+#include <cstdint>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "LogDecoder.h"
+
+namespace LogDecoder
+{
+class SymbolIndex;
+
+/// Writes records as Chrome trace events, the JSON that Perfetto and chrome://tracing open
+///
+/// Each record becomes an event as it arrives, named after the function of its call site,
+/// with the message and the arguments as event args. A span becomes a complete event with
+/// its duration. Records of a Sharded dump go on the track of their thread, spans on that
+/// of the thread that opened them. Only the names of the call sites and the threads seen so
+/// far are kept, so a dump of any size streams through in constant memory.
+class TraceEventWriter
+{
+public:
+    TraceEventWriter(std::ostream &s, const SymbolIndex &symbols);
+
+    void write(const Record &record);
+    /// Closes the JSON document
+    void finish();
+
+private:
+    void beginEvent();
+    const std::string &nameOf(std::uintptr_t address);
+
+    std::ostream &m_stream;
+    const SymbolIndex &m_symbols;
+    std::unordered_map<std::uintptr_t, std::string> m_names; /// JSON escaped
+    std::set<std::uint32_t> m_threads;
+    bool m_empty = true;
+};
+} // namespace LogDecoder
+
+#endif // TRACE_EVENTS_H
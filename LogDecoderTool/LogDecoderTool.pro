@@ -0,0 +1,8 @@
+QT =
+
+include("../GlobalSettings.pri")
+include("../LogDecoder/LogDecoder.pri")
+
+SOURCES += LogDecoderToolMain.cpp
+
+DEFINES += ARM
@@ -0,0 +1,510 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../LogDecoder/Compression.h"
+#include "../LogDecoder/LogDecoder.h"
+#include "../LogDecoder/MappedFile.h"
+#include "../LogDecoder/Recovery.h"
+#include "../LogDecoder/SpanStatistics.h"
+#include "../LogDecoder/Store.h"
+#include "../LogDecoder/TraceEvents.h"
+#include "../LogDecoder/SymbolIndex.h"
+
+namespace
+{
+constexpr std::size_t s_releaseInterval = 64u << 20; // bytes
+
+int usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [--format plain|sharded|compact16|compact32|indexed|mapped|crash|compressed|store] [--count] [--spans|--stacks|--trace-events|--compress <file>|--store <directory> [--budget <bytes>]] [--from <time>] [--to <time>] [--address <hex>] [--jobs <n>] [<symbol file or directory>] <dump>\n"
+              << "  Prints the records of a dump written by Logger::writeTo, one per line.\n"
+              << "  The symbols name the call sites, a directory holds them as <build id>.syms. Without them,\n"
+              << "  the type table of the dump describes the arguments and the call sites print as addresses.\n"
+              << "  --format mapped recovers the records from the file of a MappedLogger, e.g. after a crash.\n"
+              << "  --format crash prints the records of each logger in a dump of the CrashHandler.\n"
+              << "  --format compressed decompresses the segments written by --compress first.\n"
+              << "  --format store queries the directory written by --store, between --from and --to, of the call site at --address.\n"
+              << "  --count only counts the records and reports the decoding throughput.\n"
+              << "  --spans prints the latency percentiles of each Logger::span call site instead.\n"
+              << "  --stacks prints the stacks of the spans with their own time, the input of flamegraph.pl.\n"
+              << "  --trace-events converts the records into Chrome trace event JSON, for Perfetto.\n"
+              << "  --compress writes the records as compressed segments into the file instead.\n"
+              << "  --store appends the records to the segments of the directory instead, keeping at most --budget bytes.\n"
+              << "  --jobs decodes an indexed dump in n parallel chunks.\n";
+    return 2;
+}
+
+/// Hexadecimal digits of the build id
+std::string hex(const std::span<const unsigned char> buildId)
+{
+    std::ostringstream s;
+    s << std::hex << std::setfill('0');
+    for (const unsigned char byte : buildId)
+    {
+        s << std::setw(2) << int{byte};
+    }
+    return s.str();
+}
+
+/// Symbols of the file, or of the build in the directory, none for an empty path or an unknown build
+std::unique_ptr<LogDecoder::SymbolIndex> loadSymbols(const std::string &path, const std::span<const unsigned char> buildId)
+{
+    if (path.empty())
+    {
+        return std::make_unique<LogDecoder::SymbolIndex>();
+    }
+    if (!std::filesystem::is_directory(path))
+    {
+        return std::make_unique<LogDecoder::SymbolIndex>(path);
+    }
+    const std::filesystem::path file = std::filesystem::path(path) / (hex(buildId) + ".syms");
+    if (buildId.empty() || !std::filesystem::exists(file))
+    {
+        std::cerr << "No symbols for build " << (buildId.empty() ? "?" : hex(buildId)) << " in " << path << '\n';
+        return std::make_unique<LogDecoder::SymbolIndex>();
+    }
+    return std::make_unique<LogDecoder::SymbolIndex>(file.string());
+}
+
+/// Prints records one per line, with the names of their call sites
+class RecordPrinter
+{
+public:
+    explicit RecordPrinter(const LogDecoder::SymbolIndex &symbols)
+        : m_symbols(symbols)
+    {
+    }
+
+    void print(std::ostream &s, const LogDecoder::Record &record)
+    {
+        using namespace LogDecoder;
+
+        auto function = m_functions.find(record.address);
+        if (function == m_functions.end())
+        {
+            std::string name = m_symbols.resolveFunction(record.address);
+            if (name.empty())
+            {
+                std::ostringstream address;
+                address << "0x" << std::hex << record.address;
+                name = address.str();
+            }
+            function = m_functions.emplace(record.address, std::move(name)).first;
+        }
+        s << record.time << ' ';
+        if (record.threadId != Record::noThread)
+        {
+            s << '[' << record.threadId << "] ";
+        }
+        if (record.type->level)
+        {
+            s << levelName(*record.type->level) << ' ';
+        }
+        if (const std::uint64_t suppressed = record.suppressed(); suppressed > 0u)
+        {
+            s << "(+" << suppressed << " suppressed) ";
+        }
+        if (record.span)
+        {
+            s << "(span of " << record.span->duration << ") ";
+        }
+        s << function->second;
+        if (!record.type->format.empty())
+        {
+            s << ": ";
+            record.printMessage(s);
+            s << '\n';
+            return;
+        }
+        s << '(';
+        for (std::size_t a = 0u; a < record.argumentCount(); ++a)
+        {
+            s << (a > 0u ? ", " : "");
+            record.printArgument(s, a);
+        }
+        s << ")\n";
+    }
+
+private:
+    const LogDecoder::SymbolIndex &m_symbols;
+    std::unordered_map<std::uintptr_t, std::string> m_functions;
+};
+
+/// Decodes the records up to the end offset, returns the number of records
+///
+/// The records go to consume, if any, instead of the output.
+std::size_t decode(LogDecoder::Decoder &decoder, const std::size_t end, const LogDecoder::SymbolIndex &symbols, std::ostream *s, LogDecoder::MappedFile *dump,
+                   const std::function<void(const LogDecoder::Record &)> &consume = {})
+{
+    using namespace LogDecoder;
+
+    RecordPrinter printer(symbols);
+    std::size_t recordCount = 0u;
+    std::size_t released = 0u;
+    Record record;
+    while (decoder.offset() < end && decoder.next(record))
+    {
+        ++recordCount;
+        if (dump != nullptr && decoder.offset() - released > s_releaseInterval)
+        {
+            released = decoder.offset();
+            dump->release(released);
+        }
+        if (consume)
+        {
+            consume(record);
+        }
+        else if (s != nullptr)
+        {
+            printer.print(*s, record);
+        }
+    }
+    return recordCount;
+}
+
+void printLatencies(const LogDecoder::SpanStatistics &spans)
+{
+    std::cout << std::setw(10) << "count" << std::setw(12) << "min" << std::setw(12) << "p50" << std::setw(12) << "p90" << std::setw(12) << "p99"
+              << std::setw(12) << "p99.9" << std::setw(12) << "max" << "  call site\n";
+    for (const auto &[address, callSite] : spans.callSites())
+    {
+        const LogDecoder::LatencyHistogram &latencies = callSite.latencies;
+        std::cout << std::setw(10) << latencies.count() << std::setw(12) << latencies.min();
+        for (const double fraction : {0.5, 0.9, 0.99, 0.999})
+        {
+            std::cout << std::setw(12) << latencies.percentile(fraction);
+        }
+        std::cout << std::setw(12) << latencies.max() << "  " << callSite.name << '\n';
+    }
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    using namespace LogDecoder;
+
+    Format format = Format::Plain;
+    bool mapped = false;
+    bool crashed = false;
+    bool countOnly = false;
+    bool latencies = false;
+    bool stacks = false;
+    bool traceEvents = false;
+    bool compressed = false;
+    std::string compressTo;
+    bool stored = false;
+    std::string storeTo;
+    std::uint64_t budget = std::uint64_t{1u} << 30;
+    StoreQuery query;
+    std::size_t jobs = 1u;
+    int i = 1;
+    for (; i < argc && std::string_view(argv[i]).starts_with("--"); ++i)
+    {
+        const std::string_view option(argv[i]);
+        if (option == "--count")
+        {
+            countOnly = true;
+        }
+        else if (option == "--spans")
+        {
+            latencies = true;
+        }
+        else if (option == "--stacks")
+        {
+            stacks = true;
+        }
+        else if (option == "--trace-events")
+        {
+            traceEvents = true;
+        }
+        else if (option == "--compress" && i + 1 < argc)
+        {
+            compressTo = argv[++i];
+        }
+        else if (option == "--store" && i + 1 < argc)
+        {
+            storeTo = argv[++i];
+        }
+        else if (option == "--budget" && i + 1 < argc)
+        {
+            budget = std::stoull(argv[++i]);
+        }
+        else if (option == "--from" && i + 1 < argc)
+        {
+            query.from = std::stoll(argv[++i]);
+        }
+        else if (option == "--to" && i + 1 < argc)
+        {
+            query.to = std::stoll(argv[++i]);
+        }
+        else if (option == "--address" && i + 1 < argc)
+        {
+            query.address = std::stoull(argv[++i], nullptr, 16);
+        }
+        else if (option == "--format" && i + 1 < argc)
+        {
+            const std::string_view value(argv[++i]);
+            if (value == "plain")
+            {
+                format = Format::Plain;
+            }
+            else if (value == "sharded")
+            {
+                format = Format::Sharded;
+            }
+            else if (value == "compact16")
+            {
+                format = Format::Compact16;
+            }
+            else if (value == "compact32")
+            {
+                format = Format::Compact32;
+            }
+            else if (value == "indexed")
+            {
+                format = Format::Indexed;
+            }
+            else if (value == "mapped")
+            {
+                format = Format::Plain;
+                mapped = true;
+            }
+            else if (value == "crash")
+            {
+                format = Format::Plain;
+                crashed = true;
+            }
+            else if (value == "compressed")
+            {
+                format = Format::Plain;
+                compressed = true;
+            }
+            else if (value == "store")
+            {
+                format = Format::Plain;
+                stored = true;
+            }
+            else
+            {
+                return usage(argv[0]);
+            }
+        }
+        else if (option == "--jobs" && i + 1 < argc)
+        {
+            jobs = std::stoul(argv[++i]);
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+    if (argc - i < 1 || argc - i > 2 || jobs == 0u || (jobs > 1u && format != Format::Indexed) || int{latencies} + int{stacks} + int{traceEvents} > 1
+        || ((latencies || stacks || traceEvents) && (countOnly || jobs > 1u))
+        || (!compressTo.empty() && (latencies || stacks || traceEvents || countOnly || jobs > 1u || mapped || crashed))
+        || (!storeTo.empty() && (!compressTo.empty() || latencies || stacks || traceEvents || countOnly || jobs > 1u || mapped || crashed || stored)))
+    {
+        return usage(argv[0]);
+    }
+
+    try
+    {
+        std::optional<StoreReader> store;
+        if (stored)
+        {
+            store.emplace(argv[argc - 1]);
+            if (store->segments().empty())
+            {
+                throw std::runtime_error(std::string("No segments in ") + argv[argc - 1]);
+            }
+        }
+        // NOTE: the segments of a store start with the dump header of the same build
+        MappedFile dump(stored ? store->segments().front().path : std::string(argv[argc - 1]));
+        std::string decompressed;
+        if (compressed)
+        {
+            decompress(dump.data(), decompressed);
+        }
+        const std::span<const char> data = compressed ? std::span<const char>(decompressed) : dump.data();
+        std::vector<RecoveredRing> rings;
+        if (mapped)
+        {
+            rings.push_back(recover(dump.data()));
+        }
+        else if (crashed)
+        {
+            CrashDump crash = readCrashDump(dump.data());
+            std::cerr << "Signal " << crash.signal << " (code " << crash.code << ") at address 0x" << std::hex << crash.faultAddress << std::dec
+                      << " in thread " << crash.threadId << '\n';
+            rings = std::move(crash.loggers);
+        }
+        const std::span<const unsigned char> buildId = mapped || crashed ? (rings.empty() ? std::span<const unsigned char>{} : std::span<const unsigned char>(rings.front().buildId)) : dumpBuildId(data);
+        const std::unique_ptr<SymbolIndex> symbolIndex = loadSymbols(argc - i == 2 ? argv[i] : std::string{}, buildId);
+        SymbolIndex &symbols = *symbolIndex;
+
+        const auto start = std::chrono::steady_clock::now();
+        std::size_t recordCount = 0u;
+        SpanStatistics spans(symbols);
+        TraceEventWriter events(std::cout, symbols);
+        std::function<void(const Record &)> consume;
+        if (latencies || stacks)
+        {
+            consume = [&spans](const Record &record) { spans.add(record); };
+        }
+        else if (traceEvents)
+        {
+            consume = [&events](const Record &record) { events.write(record); };
+        }
+        if (mapped || crashed)
+        {
+            for (std::size_t r = 0u; r < rings.size(); ++r)
+            {
+                const RecoveredRing &ring = rings[r];
+                if (!ring.buildId.empty() && !symbols.buildId().empty() && !std::ranges::equal(ring.buildId, symbols.buildId()))
+                {
+                    throw std::runtime_error("The dump was written by another build than the symbol file");
+                }
+                Decoder decoder(ring.records, symbols, format);
+                if (ring.calibration)
+                {
+                    decoder.setCalibration(*ring.calibration);
+                }
+                if (crashed && !countOnly && !consume)
+                {
+                    std::cout << "# Logger " << r << '\n';
+                }
+                recordCount += decode(decoder, decoder.size(), symbols, countOnly ? nullptr : &std::cout, nullptr, consume);
+            }
+        }
+        else if (!compressTo.empty())
+        {
+            // NOTE: also the calibration records, such that the segments keep the time base
+            std::ofstream output(compressTo, std::ios::binary);
+            SegmentWriter segments(output);
+            Decoder decoder(data, symbols, format);
+            segments.writeDumpHeader(decoder.header());
+            Record record;
+            while (decoder.nextAny(record))
+            {
+                segments.write(record);
+            }
+            segments.finish();
+            if (!output)
+            {
+                throw std::runtime_error("Cannot write " + compressTo);
+            }
+            std::cerr << segments.plainBytes() << " bytes compressed into " << segments.writtenBytes() << " bytes\n";
+        }
+        else if (!storeTo.empty())
+        {
+            // NOTE: also the calibration records, such that the segments keep the time base
+            Decoder decoder(data, symbols, format);
+            StoreWriter writer(storeTo, decoder.header(), budget);
+            Record record;
+            while (decoder.nextAny(record))
+            {
+                writer.write(record);
+            }
+            writer.finish();
+            std::cerr << writer.storedBytes() << " bytes stored, " << writer.removedCount() << " segments removed\n";
+        }
+        else if (stored)
+        {
+            RecordPrinter printer(symbols);
+            recordCount = store->query(query, symbols, [&](const Record &record) {
+                if (consume)
+                {
+                    consume(record);
+                }
+                else if (!countOnly)
+                {
+                    printer.print(std::cout, record);
+                }
+            });
+        }
+        else if (jobs == 1u)
+        {
+            Decoder decoder(data, symbols, format);
+            recordCount = decode(decoder, decoder.size(), symbols, countOnly ? nullptr : &std::cout, compressed ? nullptr : &dump, consume);
+        }
+        else
+        {
+            // NOTE: the first record fixes the load bias, after which the symbols are only read
+            Decoder decoder(dump.data(), symbols, format);
+            Record record;
+            decoder.next(record);
+
+            const std::size_t chunkSize = decoder.size() / jobs + 1u;
+            std::vector<std::ostringstream> outputs(jobs);
+            std::vector<std::size_t> counts(jobs);
+            std::vector<std::exception_ptr> errors(jobs);
+            std::vector<std::thread> threads;
+            for (std::size_t job = 0u; job < jobs; ++job)
+            {
+                threads.emplace_back([&, job] {
+                    try
+                    {
+                        Decoder chunk(dump.data(), symbols, format);
+                        chunk.seek(job * chunkSize);
+                        counts[job] = decode(chunk, chunk.boundaryAt((job + 1u) * chunkSize), symbols, countOnly ? nullptr : &outputs[job], nullptr);
+                    }
+                    catch (...)
+                    {
+                        errors[job] = std::current_exception();
+                    }
+                });
+            }
+            for (std::size_t job = 0u; job < jobs; ++job)
+            {
+                threads[job].join();
+            }
+            for (std::size_t job = 0u; job < jobs; ++job)
+            {
+                if (errors[job])
+                {
+                    std::rethrow_exception(errors[job]);
+                }
+                recordCount += counts[job];
+                std::cout << outputs[job].view();
+            }
+        }
+
+        if (latencies)
+        {
+            printLatencies(spans);
+        }
+        else if (stacks)
+        {
+            spans.writeStacksTo(std::cout);
+        }
+        else if (traceEvents)
+        {
+            events.finish();
+        }
+        if (countOnly)
+        {
+            const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+            std::cout << recordCount << " records in " << duration.count() << " s: " << static_cast<double>(recordCount) / duration.count() << " records/s\n";
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
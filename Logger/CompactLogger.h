@@ -0,0 +1,226 @@
+#ifndef COMPACT_LOGGER_H
+#define COMPACT_LOGGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+#include "Logger.h"
+
+namespace Details
+{
+/// Full time stamp, the compact records only hold its lower bits
+struct TimeAnchor
+{
+    std::int64_t time;
+};
+} // namespace Details
+
+/// Logger with a 6 byte record header: a dense call site id and a truncated time stamp
+///
+/// The call site id replaces both the instruction pointer and the type tag: writeTo
+/// prefixes the output with the table of all call sites. Each record only keeps the
+/// lower 32 bits of its time stamp. Whenever the upper bits change, a TimeAnchor
+/// record with the full time stamp is added, and writeTo ends with one as well.
+/// This keeps reconstruction exact with concurrent writers, where deltas to the
+/// previous record would not be. The record that crosses a multiple of anchorSpacing
+/// bytes adds one too, such that a wrapped buffer keeps an anchor near its front:
+/// the decoder skips the records in front of the first anchor, whose upper bits are
+/// unknown.
+///
+/// Output: std::uint64_t call site count, Details::CallSite table, records
+template <std::size_t sizeLog2, typename Clock = Clocks::HighResolution, typename CallSiteId = std::uint16_t>
+class CompactLogger
+{
+public:
+    CompactLogger()
+    {
+        if (Details::callSites().size() > std::size_t{std::numeric_limits<CallSiteId>::max()} + 1u)
+        {
+            throw std::length_error("Too many call sites for the CallSiteId type");
+        }
+    }
+
+    // Logging
+public:
+    template <TriviallyCopyable... Ts>
+    void trace(const Ts... args) __attribute__((always_inline))
+    {
+        append<Details::LoggerTraceTypeInfo<Ts...>>(args...);
+    }
+    /// Like trace, with a message such as trace<"cache miss at {}">(address), see Logger
+    template <Details::FixedString format, TriviallyCopyable... Ts>
+    void trace(const Ts... args) __attribute__((always_inline))
+    {
+        append<Details::LoggerTraceTypeInfo<Details::Format<format>, Ts...>>(args...);
+    }
+    /// Like trace, with a severity such as trace<Level::Warning>(code), see Logger
+    template <Level level, TriviallyCopyable... Ts>
+    void trace(const Ts... args) __attribute__((always_inline))
+    {
+        if constexpr (level >= minimumLevel)
+        {
+            append<Details::LoggerTraceTypeInfo<Details::Severity<level>, Ts...>>(args...);
+        }
+    }
+    template <Level level, Details::FixedString format, TriviallyCopyable... Ts>
+    void trace(const Ts... args) __attribute__((always_inline))
+    {
+        if constexpr (level >= minimumLevel)
+        {
+            append<Details::LoggerTraceTypeInfo<Details::Severity<level>, Details::Format<format>, Ts...>>(args...);
+        }
+    }
+
+    /// Like trace, where a Sampling policy decides which traces of the call site get through, see Logger
+    template <typename Policy, TriviallyCopyable... Ts>
+    void sample(const Ts... args) __attribute__((always_inline))
+    {
+        appendSampled<Details::LoggerTraceTypeInfo<Details::Suppressed, Ts...>, Policy>(args...);
+    }
+    template <typename Policy, Details::FixedString format, TriviallyCopyable... Ts>
+    void sample(const Ts... args) __attribute__((always_inline))
+    {
+        appendSampled<Details::LoggerTraceTypeInfo<Details::Format<format>, Details::Suppressed, Ts...>, Policy>(args...);
+    }
+
+    using TimeUnit = typename Clock::TimeUnit;
+    static inline typename TimeUnit::rep now() __attribute__((always_inline))
+    {
+        return Clock::now();
+    }
+
+private:
+    using TruncatedTime = std::uint32_t;
+    /// Half of the range of the truncated time, such that a reader can
+    /// pick the nearest candidate around the last anchor
+    static constexpr int periodShift = std::numeric_limits<TruncatedTime>::digits - 1;
+    static std::uint64_t period(const typename TimeUnit::rep time)
+    {
+        return static_cast<std::uint64_t>(time) >> periodShift;
+    }
+    using Buffer = Details::CircularBuffer<sizeLog2>;
+    /// Bytes between the anchors that do not depend on the time, a whole number of blocks
+    static constexpr std::size_t anchorSpacing = std::max<std::size_t>(Buffer::blockSize, 256u);
+
+    void anchor(const typename TimeUnit::rep time) __attribute__((noinline))
+    {
+        m_circularBuffer.append(anchorRecord(time));
+        // NOTE: only after the anchor, such that every record of the period follows one
+        m_period.store(period(time), std::memory_order_release);
+    }
+    static auto anchorRecord(const typename TimeUnit::rep time) __attribute__((always_inline))
+    {
+        return RecordT<Details::TimeAnchor>{static_cast<CallSiteId>(Details::callSiteId<Details::TimeAnchor>()), static_cast<TruncatedTime>(time), Details::TimeAnchor{time}};
+    }
+
+    template <typename TypeInfo, TriviallyCopyable... Ts>
+    void append(const Ts... args) __attribute__((always_inline))
+    {
+        Details::CallSite *const callSite = Details::callSiteOf<TypeInfo>();
+        if (!callSite->enabled()) [[unlikely]]
+        {
+            return;
+        }
+        write(callSite, args...);
+    }
+    template <typename TypeInfo, typename Policy, TriviallyCopyable... Ts>
+    void appendSampled(const Ts... args) __attribute__((always_inline))
+    {
+        Details::CallSite *const callSite = Details::callSiteOf<TypeInfo>();
+        if (!callSite->enabled()) [[unlikely]]
+        {
+            return;
+        }
+        Details::SamplingState &state = Details::samplingState(Details::callSiteId(callSite));
+        if (!Policy::admit(state))
+        {
+            ++state.suppressed;
+            return;
+        }
+        write(callSite, Details::Suppressed{std::exchange(state.suppressed, 0u)}, args...);
+    }
+    template <TriviallyCopyable... Ts>
+    void write(const Details::CallSite *callSite, const Ts... args) __attribute__((always_inline))
+    {
+        const auto time = now();
+        if (period(time) != m_period.load(std::memory_order_acquire)) [[unlikely]]
+        {
+            anchor(time);
+        }
+        using Traced = RecordT<Ts...>;
+        const std::size_t position = m_circularBuffer.append(Traced{static_cast<CallSiteId>(Details::callSiteId(callSite)), static_cast<TruncatedTime>(time), args...});
+        if (position / anchorSpacing != (position + sizeof(Traced)) / anchorSpacing) [[unlikely]]
+        {
+            anchor(time);
+        }
+    }
+
+    struct __attribute__((packed)) Record
+    {
+        const CallSiteId m_callSiteId; /// index in Details::callSites()
+        const TruncatedTime m_time;
+    };
+
+    template <std::size_t I, TriviallyCopyable T>
+    struct __attribute__((packed)) RecordArg
+    {
+        T arg;
+    };
+
+    template <TriviallyCopyable...>
+    struct __attribute__((packed)) RecordT;
+    template <std::size_t... Is, TriviallyCopyable... Ts>
+    struct __attribute__((packed)) RecordT<std::index_sequence<Is...>, Ts...> : Record, RecordArg<Is, Ts>...
+    {
+        RecordT(const CallSiteId callSiteId, const TruncatedTime time, const Ts... args)
+            : Record{callSiteId, time}, RecordArg<Is, Ts>{args}...
+        {
+        }
+    };
+    template <TriviallyCopyable... Ts>
+    struct RecordT : RecordT<std::make_index_sequence<sizeof...(Ts)>, Ts...>
+    {
+        using RecordT<std::make_index_sequence<sizeof...(Ts)>, Ts...>::RecordT;
+    };
+
+    // Buffer
+public:
+    void writeTo(std::ostream &s) const
+    {
+        writeHeaderTo(s);
+        m_circularBuffer.writeTo(s);
+        m_circularBuffer.writeRecordTo(s, anchorRecord(now()));
+    }
+    /// Like writeTo, but consistent while other threads keep tracing
+    void snapshotTo(std::ostream &s) const
+    {
+        writeHeaderTo(s);
+        m_circularBuffer.snapshotTo(s);
+        m_circularBuffer.writeRecordTo(s, anchorRecord(now()));
+    }
+
+private:
+    void writeHeaderTo(std::ostream &s) const
+    {
+        const std::span<const Details::CallSite> callSites = Details::callSites();
+        const std::uint64_t callSiteCount = callSites.size();
+        s.write(reinterpret_cast<const char *>(&callSiteCount), sizeof(callSiteCount));
+        s.write(reinterpret_cast<const char *>(callSites.data()), static_cast<std::streamsize>(callSites.size_bytes()));
+
+        if constexpr (requires { Clock::calibration(); })
+        {
+            const Clocks::Calibration calibration = Clock::calibration();
+            m_circularBuffer.writeRecordTo(s, RecordT<Clocks::Calibration>{static_cast<CallSiteId>(Details::callSiteId<Clocks::Calibration>()), static_cast<TruncatedTime>(calibration.anchorTicks), calibration});
+        }
+    }
+
+private:
+    alignas(64) std::atomic<std::uint64_t> m_period{std::numeric_limits<std::uint64_t>::max()};
+    alignas(64) Buffer m_circularBuffer;
+};
+
+#endif // COMPACT_LOGGER_H
@@ -0,0 +1,219 @@
+#ifndef COUNTING_LOGGER_H
+#define COUNTING_LOGGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "Logger.h"
+
+/// Health of the buffer of a CountingLogger, zero where the buffer does not keep track
+struct LoggerStatistics
+{
+    std::uint64_t reservedBytes = 0u; /// since the buffer was created or cleared
+    std::uint64_t wrapCount = 0u; /// times the buffer got overwritten from the start
+    std::uint64_t overwrittenBytes = 0u; /// of records that are no longer in the buffer
+    std::uint64_t lostBytes = 0u; /// of records that a StreamingLogger could not write
+    std::uint64_t snapshotCount = 0u; /// of snapshotTo
+    std::int64_t lastSnapshotDuration = 0; /// nanoseconds
+    std::int64_t maxSnapshotDuration = 0; /// nanoseconds
+};
+
+/// Records and bytes that a call site traced, summed over the threads
+struct CallSiteCount
+{
+    const Details::CallSite *callSite;
+    std::uint64_t records;
+    std::uint64_t bytes;
+};
+
+namespace Details
+{
+/// Records and bytes of every call site, counted by the loggers with a CountingBuffer
+///
+/// NOTE: every thread counts into its own array, indexed by the dense call site id, with two
+/// plain stores and no read-modify-write. The sums walk the arrays of all threads, which are
+/// recycled but never freed, so the counts of threads that ended remain. Records that a
+/// thread writes after its registration is gone, e.g. from the destructor of another
+/// thread_local, are not counted.
+class CallSiteCounters
+{
+public:
+    struct Count
+    {
+        std::uint64_t records = 0u;
+        std::uint64_t bytes = 0u;
+    };
+
+    static void add(const std::size_t callSiteId, const std::size_t bytes) __attribute__((always_inline))
+    {
+        if (s_counts == nullptr && !registerThread()) [[unlikely]]
+        {
+            return;
+        }
+        Count &count = s_counts[callSiteId];
+        std::atomic_ref<std::uint64_t>(count.records).store(count.records + 1u, std::memory_order_relaxed);
+        std::atomic_ref<std::uint64_t>(count.bytes).store(count.bytes + bytes, std::memory_order_relaxed);
+    }
+
+    /// Counts of all threads so far, indexed by the dense call site id
+    static std::vector<Count> sums()
+    {
+        std::vector<Count> sums(callSites().size());
+        const std::lock_guard lock(s_mutex);
+        for (const auto &counters : s_counters)
+        {
+            for (std::size_t id = 0u; id < sums.size(); ++id)
+            {
+                sums[id].records += std::atomic_ref<std::uint64_t>(counters->m_counts[id].records).load(std::memory_order_relaxed);
+                sums[id].bytes += std::atomic_ref<std::uint64_t>(counters->m_counts[id].bytes).load(std::memory_order_relaxed);
+            }
+        }
+        return sums;
+    }
+
+private:
+    /// False once the thread has ended, rather than building its destroyed Registration again
+    static bool registerThread() __attribute__((noinline))
+    {
+        if (s_exited)
+        {
+            return false;
+        }
+        struct Registration
+        {
+            Registration()
+            {
+                const std::lock_guard lock(s_mutex);
+                const auto it = std::find_if(s_counters.begin(), s_counters.end(), [](const auto &counters) { return !counters->m_inUse; });
+                CallSiteCounters *const counters = it != s_counters.end() ? it->get() : s_counters.emplace_back(std::make_unique<CallSiteCounters>()).get();
+                counters->m_inUse = true;
+                m_counters = counters;
+                s_counts = counters->m_counts.get();
+            }
+            ~Registration()
+            {
+                const std::lock_guard lock(s_mutex);
+                m_counters->m_inUse = false;
+                s_counts = nullptr;
+                s_exited = true;
+            }
+            CallSiteCounters *m_counters;
+        };
+        static thread_local Registration registration;
+        return true;
+    }
+
+    std::unique_ptr<Count[]> m_counts = std::make_unique<Count[]>(callSites().size());
+    bool m_inUse = false; /// guarded by s_mutex
+
+    static inline thread_local Count *s_counts = nullptr;
+    static inline thread_local bool s_exited = false; /// whether the Registration is gone
+    static inline std::mutex s_mutex;
+    static inline std::vector<std::unique_ptr<CallSiteCounters>> s_counters;
+};
+
+/// Buffer that counts the records and bytes of each call site, and how the buffer keeps up
+///
+/// Wraps any buffer of Logger, e.g. CountingBuffer<StreamingBuffer<20u>>. The pull API is
+/// statistics() and callSiteCounts(); Logger::traceStatistics writes them into the buffer
+/// itself. The call site counts are shared by all loggers that count.
+template <typename Buffer>
+class CountingBuffer : public Buffer
+{
+public:
+    using Buffer::Buffer;
+
+    /// Called by Logger for each record
+    static void countRecord(const std::size_t callSiteId, const std::size_t bytes) __attribute__((always_inline))
+    {
+        CallSiteCounters::add(callSiteId, bytes);
+    }
+
+    /// Like the snapshotTo of the buffer, timed
+    void snapshotTo(std::ostream &s) const
+    {
+        const auto start = std::chrono::steady_clock::now();
+        Buffer::snapshotTo(s);
+        const std::int64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        m_snapshotCount.fetch_add(1u, std::memory_order_relaxed);
+        m_lastSnapshotDuration.store(duration, std::memory_order_relaxed);
+        for (std::int64_t maxDuration = m_maxSnapshotDuration.load(std::memory_order_relaxed); duration > maxDuration;)
+        {
+            if (m_maxSnapshotDuration.compare_exchange_weak(maxDuration, duration, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+    }
+
+    LoggerStatistics statistics() const
+    {
+        LoggerStatistics statistics;
+        if constexpr (requires(const Buffer &buffer) { buffer.reserved(); })
+        {
+            statistics.reservedBytes = Buffer::reserved();
+            statistics.wrapCount = statistics.reservedBytes / Buffer::bufferSize;
+            statistics.overwrittenBytes = std::max<std::uint64_t>(statistics.reservedBytes, Buffer::bufferSize) - Buffer::bufferSize;
+        }
+        if constexpr (requires(const Buffer &buffer) { buffer.lostBytes(); })
+        {
+            statistics.lostBytes = Buffer::lostBytes();
+        }
+        statistics.snapshotCount = m_snapshotCount.load(std::memory_order_relaxed);
+        statistics.lastSnapshotDuration = m_lastSnapshotDuration.load(std::memory_order_relaxed);
+        statistics.maxSnapshotDuration = m_maxSnapshotDuration.load(std::memory_order_relaxed);
+        return statistics;
+    }
+    /// Call sites that traced so far, the most bytes first
+    static std::vector<CallSiteCount> callSiteCounts()
+    {
+        const std::vector<CallSiteCounters::Count> sums = CallSiteCounters::sums();
+        std::vector<CallSiteCount> counts;
+        for (std::size_t id = 0u; id < sums.size(); ++id)
+        {
+            if (sums[id].records > 0u)
+            {
+                counts.push_back({&callSites()[id], sums[id].records, sums[id].bytes});
+            }
+        }
+        std::ranges::sort(counts, [](const CallSiteCount &a, const CallSiteCount &b) { return a.bytes > b.bytes; });
+        return counts;
+    }
+    /// Like callSiteCounts, the records and bytes since the previous call, see Logger::traceStatistics
+    std::vector<CallSiteCount> callSiteDeltas()
+    {
+        const std::vector<CallSiteCounters::Count> sums = CallSiteCounters::sums();
+        const std::lock_guard lock(m_reportedMutex);
+        m_reported.resize(sums.size());
+        std::vector<CallSiteCount> deltas;
+        for (std::size_t id = 0u; id < sums.size(); ++id)
+        {
+            if (sums[id].records > m_reported[id].records)
+            {
+                deltas.push_back({&callSites()[id], sums[id].records - m_reported[id].records, sums[id].bytes - m_reported[id].bytes});
+            }
+        }
+        m_reported = sums;
+        return deltas;
+    }
+
+private:
+    mutable std::atomic<std::uint64_t> m_snapshotCount{0u};
+    mutable std::atomic<std::int64_t> m_lastSnapshotDuration{0};
+    mutable std::atomic<std::int64_t> m_maxSnapshotDuration{0};
+    std::mutex m_reportedMutex;
+    std::vector<CallSiteCounters::Count> m_reported; /// sums at the previous callSiteDeltas
+};
+} // namespace Details
+
+/// Logger that counts the records and bytes of each call site, see Details::CountingBuffer
+template <std::size_t sizeLog2, typename Clock = Clocks::HighResolution>
+using CountingLogger = Logger<sizeLog2, Clock, Details::CountingBuffer<Details::CircularBuffer<sizeLog2>>>;
+
+#endif // COUNTING_LOGGER_H
@@ -0,0 +1,276 @@
+#ifndef CRASH_HANDLER_H
+#define CRASH_HANDLER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <ios>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "Logger.h"
+
+namespace Details
+{
+/// Start of a crash dump, followed by a CrashSection and its records per registered logger
+struct CrashHeader
+{
+    static constexpr std::array<char, 8> expectedMagic{'M', 'i', 'n', 'L', 'o', 'g', 'C', '1'};
+
+    std::array<char, 8> magic;
+    std::int32_t signal;
+    std::int32_t code; /// si_code, e.g. SEGV_MAPERR
+    std::uint64_t faultAddress; /// si_addr
+    std::uint64_t threadId; /// of the thread that received the signal
+    std::uint64_t buildIdSize;
+    std::array<unsigned char, 32> buildId; /// NT_GNU_BUILD_ID of the executable that crashed
+};
+
+/// One logger in a crash dump, followed by its records in the plain format
+struct CrashSection
+{
+    static constexpr std::uint64_t unfinished = std::numeric_limits<std::uint64_t>::max();
+
+    std::uint64_t id; /// slot of the CrashHandler::Registration
+    std::uint64_t size; /// of the records, unfinished if the dump got cut short
+    std::uint64_t validFrom; /// first record that was not overwritten during the dump
+    std::uint64_t calibrated; /// whether calibration is set
+    Clocks::Calibration calibration;
+};
+
+/// Output through write(2) only, which is async-signal-safe
+class FileDescriptorStream
+{
+public:
+    explicit FileDescriptorStream(const int fd)
+        : m_fd(fd)
+    {
+    }
+
+    FileDescriptorStream &write(const char *data, std::streamsize size)
+    {
+        while (size > 0 && m_good)
+        {
+            const ssize_t written = ::write(m_fd, data, static_cast<std::size_t>(size));
+            if (written < 0)
+            {
+                m_good = errno == EINTR;
+                continue;
+            }
+            data += written;
+            size -= written;
+            m_position += static_cast<std::uint64_t>(written);
+        }
+        return *this;
+    }
+    /// Overwrites earlier output, without moving the position
+    void writeAt(const std::uint64_t position, const void *data, const std::size_t size)
+    {
+        m_good = m_good && ::pwrite(m_fd, data, size, static_cast<off_t>(position)) == static_cast<ssize_t>(size);
+    }
+    std::uint64_t position() const
+    {
+        return m_position;
+    }
+    bool good() const
+    {
+        return m_good;
+    }
+
+private:
+    int m_fd;
+    std::uint64_t m_position = 0u;
+    bool m_good = true;
+};
+
+/// One logger registered with the CrashHandler, the logger is published last
+struct CrashSlot
+{
+    std::atomic<bool> claimed{false};
+    std::atomic<std::uint64_t (*)(void *, FileDescriptorStream &)> dump{nullptr};
+    bool calibrated = false;
+    Clocks::Calibration calibration{}; /// taken on registration, the handler only copies it
+    std::atomic<void *> logger{nullptr};
+};
+} // namespace Details
+
+/// Dumps the registered loggers from a handler for the fatal signals
+///
+/// Nothing happens until install() is called, and tracing costs the same either way. The
+/// handler only uses async-signal-safe calls: it neither allocates nor locks, and an alarm
+/// ends the process once the time budget is spent. Afterwards, the previous disposition of
+/// the signal takes over, e.g. to write a core dump. Another thread that crashes meanwhile
+/// waits for the dump, at most the budget, and then leaves its signal to the previous
+/// disposition as well.
+///
+/// \code
+/// Logger<20u> logger;
+/// const CrashHandler::Registration registration(logger);
+/// CrashHandler::install("crash.bin");
+/// \endcode
+class CrashHandler
+{
+public:
+    static constexpr std::array<int, 5> handledSignals{SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+    static constexpr std::size_t maxLoggers = 64u;
+
+    /// Handles the signals by writing the dump to path, the last call sets the path and budget
+    static void install(const std::string &path, const std::chrono::seconds budget = std::chrono::seconds(10))
+    {
+        if (path.size() >= s_path.size())
+        {
+            throw std::invalid_argument("Crash dump path too long: " + path);
+        }
+        std::copy(path.begin(), path.end(), s_path.begin());
+        s_path[path.size()] = '\0';
+        s_budget = static_cast<unsigned int>(budget.count());
+
+        // NOTE: dl_iterate_phdr is not async-signal-safe, so the header is prepared up front
+        s_header.magic = Details::CrashHeader::expectedMagic;
+        const std::span<const unsigned char> id = Details::buildId();
+        s_header.buildIdSize = std::min(id.size(), s_header.buildId.size());
+        std::copy_n(id.begin(), s_header.buildIdSize, s_header.buildId.begin());
+
+        if (s_installed.exchange(true))
+        {
+            return;
+        }
+        struct sigaction action{};
+        action.sa_sigaction = &handle;
+        // NOTE: on the alternate stack if the program has one, which a stack overflow needs
+        action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+        for (std::size_t i = 0u; i < handledSignals.size(); ++i)
+        {
+            if (::sigaction(handledSignals[i], &action, &s_previous[i]) != 0)
+            {
+                throw std::runtime_error(std::string("Cannot install the crash handler: ") + std::strerror(errno));
+            }
+        }
+    }
+
+    /// Includes a logger in the crash dump as long as the registration lives
+    class Registration
+    {
+    public:
+        template <std::size_t sizeLog2, typename Clock, typename Buffer, std::size_t maxPayloadSize>
+        explicit Registration(Logger<sizeLog2, Clock, Buffer, maxPayloadSize> &logger)
+        {
+            const auto slot = std::find_if(s_slots.begin(), s_slots.end(), [](Details::CrashSlot &candidate) { return !candidate.claimed.exchange(true); });
+            if (slot == s_slots.end())
+            {
+                throw std::runtime_error("More than " + std::to_string(maxLoggers) + " loggers registered for crash dumps");
+            }
+            m_slot = &*slot;
+            m_slot->dump.store(&dump<Logger<sizeLog2, Clock, Buffer, maxPayloadSize>>, std::memory_order_relaxed);
+            // NOTE: a calibration may sleep, which a signal handler must not
+            m_slot->calibrated = false;
+            if constexpr (requires { Clock::calibration(); })
+            {
+                m_slot->calibration = Clock::calibration();
+                m_slot->calibrated = true;
+            }
+            m_slot->logger.store(&logger, std::memory_order_release);
+        }
+        ~Registration()
+        {
+            m_slot->logger.store(nullptr, std::memory_order_release);
+            m_slot->claimed.store(false);
+        }
+        Registration(const Registration &) = delete;
+        Registration &operator=(const Registration &) = delete;
+
+    private:
+        template <typename Logger>
+        static std::uint64_t dump(void *logger, Details::FileDescriptorStream &s)
+        {
+            return static_cast<Logger *>(logger)->buffer().writeLiveTo(s);
+        }
+
+        Details::CrashSlot *m_slot = nullptr;
+    };
+
+private:
+    static void handle(const int signal, siginfo_t *info, void *)
+    {
+        // NOTE: a second thread that crashes must not end the process before the first one is done
+        if (s_dumping.exchange(true))
+        {
+            constexpr timespec interval{0, 1'000'000};
+            for (unsigned int waited = 0u; !s_dumped.load(std::memory_order_acquire) && waited < s_budget * 1000u; ++waited)
+            {
+                ::nanosleep(&interval, nullptr);
+            }
+            forward(signal, info);
+            return;
+        }
+        struct sigaction alarmAction{};
+        alarmAction.sa_handler = SIG_DFL;
+        sigemptyset(&alarmAction.sa_mask);
+        ::sigaction(SIGALRM, &alarmAction, nullptr);
+        ::alarm(s_budget);
+
+        if (const int fd = ::open(s_path.data(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644); fd >= 0)
+        {
+            Details::FileDescriptorStream s(fd);
+            Details::CrashHeader header = s_header;
+            header.signal = signal;
+            header.code = info->si_code;
+            header.faultAddress = reinterpret_cast<std::uintptr_t>(info->si_addr);
+            header.threadId = static_cast<std::uint64_t>(::gettid());
+            s.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            for (std::size_t id = 0u; id < s_slots.size() && s.good(); ++id)
+            {
+                void *logger = s_slots[id].logger.load(std::memory_order_acquire);
+                if (logger == nullptr)
+                {
+                    continue;
+                }
+                // NOTE: the size is only known afterwards, until then the section reaches the end of the file
+                Details::CrashSection section{id, Details::CrashSection::unfinished, 0u, s_slots[id].calibrated, s_slots[id].calibration};
+                const std::uint64_t sectionPosition = s.position();
+                s.write(reinterpret_cast<const char *>(&section), sizeof(section));
+                section.validFrom = s_slots[id].dump.load(std::memory_order_relaxed)(logger, s);
+                section.size = s.position() - sectionPosition - sizeof(section);
+                s.writeAt(sectionPosition, &section, sizeof(section));
+            }
+            ::close(fd);
+        }
+        s_dumped.store(true, std::memory_order_release);
+        forward(signal, info);
+    }
+    /// Hands the signal to its previous disposition
+    static void forward(const int signal, const siginfo_t *info)
+    {
+        // NOTE: a fault repeats once the handler returns, a signal that was sent is raised again
+        const std::size_t i = static_cast<std::size_t>(std::find(handledSignals.begin(), handledSignals.end(), signal) - handledSignals.begin());
+        ::sigaction(signal, &s_previous[i], nullptr);
+        if (info->si_code <= 0)
+        {
+            ::raise(signal);
+        }
+    }
+
+    static inline std::atomic<bool> s_installed{false};
+    static inline std::atomic<bool> s_dumping{false};
+    static inline std::atomic<bool> s_dumped{false};
+    static inline std::array<char, PATH_MAX> s_path{};
+    static inline unsigned int s_budget = 0u;
+    static inline Details::CrashHeader s_header{};
+    static inline std::array<struct sigaction, handledSignals.size()> s_previous{};
+    static inline std::array<Details::CrashSlot, maxLoggers> s_slots{};
+};
+
+#endif // CRASH_HANDLER_H
@@ -1,82 +1,1578 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <bit>
 #include <chrono>
+#include <cmath>
+#include <concepts>
 #include <cstring>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include <elf.h>
+#include <link.h>
+
+namespace Clocks
+{
+struct Calibration;
+} // namespace Clocks
+
+namespace Details
+{
+struct TimeAnchor; /// see CompactLogger.h
+
+/// Views whose elements a trace copies inline, see BoundedPayload
+template <typename T>
+struct View : std::false_type
+{
+};
+template <>
+struct View<std::string_view> : std::true_type
+{
+    using Element = char;
+};
+template <typename T, std::size_t extent>
+struct View<std::span<const T, extent>> : std::true_type
+{
+    using Element = T;
+};
+} // namespace Details
+
+template <typename T>
+concept TriviallyCopyable = std::is_trivially_copyable_v<T> && !std::is_pointer_v<T> && !Details::View<T>::value;
+
+/// std::string_view or std::span<const T>, copied inline up to a cap, see Logger::trace
 template <typename T>
-concept TriviallyCopyable = std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>;
+concept BoundedPayload = Details::View<T>::value && TriviallyCopyable<typename Details::View<T>::Element>;
+
+/// Severity of a trace<level> call
+enum class Level
+{
+    Debug,
+    Info,
+    Warning,
+    Error,
+};
+
+// NOTE: a build flag, e.g. DEFINES += MINIMAL_LOGGING_LEVEL=Warning
+#ifndef MINIMAL_LOGGING_LEVEL
+#define MINIMAL_LOGGING_LEVEL Debug
+#endif
+/// trace<level> calls below this level compile to nothing
+constexpr Level minimumLevel = Level::MINIMAL_LOGGING_LEVEL;
+
+namespace Details
+{
+/// Sequence count of one writing thread, odd while it copies a record into a CircularBuffer
+///
+/// Only the owning thread stores to its slot, so tracing gains two plain stores and no
+/// read-modify-write. A snapshot waits for the slots that are odd to move on, which
+/// guarantees that every record reserved before the snapshot started is complete. A thread
+/// that traces after its registration is gone, e.g. from the destructor of another
+/// thread_local, writes through an orphan slot that snapshots do not wait for.
+class alignas(64) WriterSlot
+{
+public:
+    static WriterSlot &current() __attribute__((always_inline))
+    {
+        if (s_current == nullptr) [[unlikely]]
+        {
+            registerThread();
+        }
+        return *s_current;
+    }
+
+    std::uint64_t begin() __attribute__((always_inline))
+    {
+        const std::uint64_t sequence = m_sequence.load(std::memory_order_relaxed) + 1u;
+        // NOTE: ordered before the reservation, which is a release operation
+        m_sequence.store(sequence, std::memory_order_relaxed);
+        return sequence;
+    }
+    void end(const std::uint64_t sequence) __attribute__((always_inline))
+    {
+        m_sequence.store(sequence + 1u, std::memory_order_release);
+    }
+    /// Dense among the threads that trace right now, noIndex for the orphan slot
+    std::size_t index() const __attribute__((always_inline))
+    {
+        return m_index;
+    }
+    static constexpr std::size_t noIndex = std::numeric_limits<std::size_t>::max();
+
+    /// Blocks until every record in flight at the time of the call is written
+    static void waitForWriters()
+    {
+        std::vector<std::pair<const WriterSlot *, std::uint64_t>> busy;
+        {
+            const std::lock_guard lock(s_mutex);
+            for (const auto &slot : s_slots)
+            {
+                if (const std::uint64_t sequence = slot->m_sequence.load(std::memory_order_acquire); sequence % 2u != 0u)
+                {
+                    busy.emplace_back(slot.get(), sequence);
+                }
+            }
+        }
+        // NOTE: slots are recycled but never freed, so this is safe outside of the lock
+        for (const auto &[slot, sequence] : busy)
+        {
+            while (slot->m_sequence.load(std::memory_order_acquire) == sequence)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    static void registerThread() __attribute__((noinline))
+    {
+        struct Registration
+        {
+            Registration()
+            {
+                const std::lock_guard lock(s_mutex);
+                const std::size_t index = static_cast<std::size_t>(std::find_if(s_slots.begin(), s_slots.end(), [](const auto &slot) { return !slot->m_inUse; }) - s_slots.begin());
+                if (index == s_slots.size())
+                {
+                    s_slots.push_back(std::make_unique<WriterSlot>());
+                }
+                s_current = s_slots[index].get();
+                s_current->m_inUse = true;
+                s_current->m_index = index;
+            }
+            ~Registration()
+            {
+                const std::lock_guard lock(s_mutex);
+                s_current->m_inUse = false;
+                // NOTE: trivially destructible, so it outlives every other thread_local of the thread
+                s_current = &s_orphan;
+            }
+        };
+        static thread_local Registration registration;
+    }
+
+    std::atomic<std::uint64_t> m_sequence{0u};
+    bool m_inUse = false; /// guarded by s_mutex
+    std::size_t m_index = noIndex; /// position in s_slots
+
+    static inline thread_local WriterSlot *s_current = nullptr;
+    static thread_local WriterSlot s_orphan;
+    static inline std::mutex s_mutex;
+    static inline std::vector<std::unique_ptr<WriterSlot>> s_slots;
+};
+inline thread_local constinit WriterSlot WriterSlot::s_orphan;
+
+/// Trailer of an indexed dump, such that a reader can start at a record boundary anywhere
+///
+/// Output: records, std::uint64_t entries, BlockIndex. Entry k is the position of the first
+/// record at or after firstBoundary + k * blockSize, all positions relative to the first record.
+struct __attribute__((packed)) BlockIndex
+{
+    std::uint64_t recordsSize;
+    std::uint64_t firstBoundary;
+    std::uint64_t blockSize;
+    std::uint64_t entryCount;
+};
+
+/// Sizes shared by a CircularBuffer and its storage
+template <std::size_t sizeLog2>
+struct RingLayout
+{
+    static constexpr std::size_t bufferSize = 1 << sizeLog2;
+    /// Granularity of the record boundaries kept next to the buffer, at most this much is lost
+    /// from the front of a wrapped buffer
+    static constexpr std::size_t blockSize = std::clamp<std::size_t>(bufferSize / 64u, 1u, 1024u);
+    static constexpr std::size_t blockCount = bufferSize / blockSize;
+    using BlockOffset = std::uint16_t;
+    static constexpr BlockOffset noRecord = std::numeric_limits<BlockOffset>::max();
+};
+
+/// Storage of a CircularBuffer as plain members
+template <std::size_t sizeLog2>
+class InMemoryStorage
+{
+public:
+    using Layout = RingLayout<sizeLog2>;
+
+    char *buffer() __attribute__((always_inline))
+    {
+        return m_buffer.data();
+    }
+    const char *buffer() const
+    {
+        return m_buffer.data();
+    }
+    std::atomic<std::size_t> &nonModTail() __attribute__((always_inline))
+    {
+        return m_nonModTail;
+    }
+    const std::atomic<std::size_t> &nonModTail() const
+    {
+        return m_nonModTail;
+    }
+    std::atomic<typename Layout::BlockOffset> *blockOffsets()
+    {
+        return m_blockOffsets.data();
+    }
+    const std::atomic<typename Layout::BlockOffset> *blockOffsets() const
+    {
+        return m_blockOffsets.data();
+    }
+
+private:
+    std::array<char, Layout::bufferSize> m_buffer{};
+    std::atomic<std::size_t> m_nonModTail{0u};
+    std::array<std::atomic<typename Layout::BlockOffset>, Layout::blockCount> m_blockOffsets{};
+};
+
+template <std::size_t sizeLog2, bool indexed = false, template <std::size_t> class Storage = InMemoryStorage>
+class CircularBuffer
+{
+public:
+    using Layout = RingLayout<sizeLog2>;
+    static constexpr std::size_t bufferSize = Layout::bufferSize;
+    static constexpr std::size_t blockSize = Layout::blockSize;
+    static constexpr std::size_t blockCount = Layout::blockCount;
+    using BlockOffset = typename Layout::BlockOffset;
+    static constexpr BlockOffset noRecord = Layout::noRecord;
+    /// Whether the storage maps the buffer twice in a row, such as Details::MirroredStorage
+    static constexpr bool mirrored = requires { requires Storage<sizeLog2>::mirrored; };
+
+    CircularBuffer() = default;
+    /// Forwards the arguments to the storage, e.g. the file of a MappedStorage
+    template <typename... Args>
+    explicit CircularBuffer(Args &&...args)
+        requires std::constructible_from<Storage<sizeLog2>, Args...>
+        : m_storage(std::forward<Args>(args)...)
+    {
+    }
+
+    /// Drops the records, also while other threads trace, the records in flight complete first
+    void clear()
+    {
+        // NOTE: an exchange, such that every writer that reserved before is seen in flight
+        m_storage.nonModTail().exchange(0u);
+        WriterSlot::waitForWriters();
+    }
+    /// Appends a record, followed by the bytes of the parts, in a single reservation
+    ///
+    /// Returns the non-modulo position of the record.
+    template <TriviallyCopyable T, std::same_as<std::span<const char>>... Parts>
+    std::size_t append(const T t, const Parts... parts)
+    {
+        WriterSlot &slot = WriterSlot::current();
+        const std::uint64_t sequence = slot.begin();
+        const std::size_t position = appendInSlot(slot, t, parts...);
+        slot.end(sequence);
+        return position;
+    }
+    /// Like append, for a writer that already began its slot, e.g. to pick the buffer after that
+    template <TriviallyCopyable T, std::same_as<std::span<const char>>... Parts>
+    std::size_t appendInSlot(const WriterSlot &slot, const T t, const Parts... parts) __attribute__((always_inline))
+    {
+        const std::uint64_t published = beginWrite(slot);
+        const std::size_t position = m_storage.nonModTail().fetch_add((sizeof(T) + ... + parts.size()));
+        write(position, t, parts...);
+        endWrite(slot, published);
+        return position;
+    }
+    /// Like append, unless the record would end beyond the non-modulo position limit
+    template <TriviallyCopyable T, std::same_as<std::span<const char>>... Parts>
+    bool tryAppend(const T t, const std::size_t limit, const Parts... parts)
+    {
+        WriterSlot &slot = WriterSlot::current();
+        const std::uint64_t sequence = slot.begin();
+        const std::uint64_t published = beginWrite(slot);
+        const std::size_t size = (sizeof(T) + ... + parts.size());
+        std::size_t nonModTail = m_storage.nonModTail().load(std::memory_order_relaxed);
+        do
+        {
+            if (nonModTail + size > limit)
+            {
+                endWrite(slot, published);
+                slot.end(sequence);
+                return false;
+            }
+        } while (!m_storage.nonModTail().compare_exchange_weak(nonModTail, nonModTail + size));
+        write(nonModTail, t, parts...);
+        endWrite(slot, published);
+        slot.end(sequence);
+        return true;
+    }
+
+    /// Bytes reserved so far, the non-modulo position of the next record
+    std::size_t reserved() const
+    {
+        return m_storage.nonModTail().load(std::memory_order_relaxed);
+    }
+    /// Non-modulo position up to which every record is complete
+    std::size_t committed() const
+    {
+        const std::size_t end = m_storage.nonModTail().load(std::memory_order_acquire);
+        WriterSlot::waitForWriters();
+        return end;
+    }
+    /// Copies the committed non-modulo range [begin, end)
+    ///
+    /// Returns begin if it is a record boundary, or else the first complete record after it
+    /// and after whatever got overwritten before or during the copy, end if there is none.
+    /// Only the bytes from there onwards are valid.
+    std::size_t copyTo(char *out, const std::size_t begin, const std::size_t end, const bool atRecord = true) const
+    {
+        const std::size_t modBegin = begin % bufferSize;
+        const std::size_t firstPart = std::min(end - begin, bufferSize - modBegin);
+        std::memcpy(out, &m_storage.buffer()[modBegin], firstPart);
+        std::memcpy(out + firstPart, m_storage.buffer(), end - begin - firstPart);
+        // NOTE: only the boundaries within the copy, read before the tail just like the records
+        const std::size_t firstBlock = begin / blockSize + 1u;
+        std::vector<BlockOffset> offsets;
+        for (std::size_t block = firstBlock; block * blockSize < end; ++block)
+        {
+            offsets.push_back(m_storage.blockOffsets()[block % blockCount].load(std::memory_order_relaxed));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const std::size_t overwritten = m_storage.nonModTail().load(std::memory_order_relaxed);
+        const std::size_t valid = std::max(overwritten, bufferSize) - bufferSize;
+        if (atRecord && valid <= begin)
+        {
+            return begin;
+        }
+        for (std::size_t block = std::max(firstBlock, valid / blockSize + 1u); block * blockSize < end; ++block)
+        {
+            if (const BlockOffset offset = offsets[block - firstBlock]; offset != noRecord)
+            {
+                return std::min(end, block * blockSize + offset);
+            }
+        }
+        return end;
+    }
+
+    /// Writes the buffer as is, only valid while no thread traces
+    ///
+    /// Once wrapped, the output starts at the first complete record.
+    void writeTo(std::ostream &s) const
+    {
+        const std::size_t end = m_storage.nonModTail().load(std::memory_order_acquire);
+        writeTo(s, m_storage.buffer(), blockOffsets(), std::max(end, bufferSize) - bufferSize, end, mirrored);
+    }
+    /// Writes the records complete at the time of the call, while other threads keep tracing
+    ///
+    /// The buffer is copied once. Records that got overwritten during the copy are dropped
+    /// from the front, records reserved after the call started are not part of the snapshot.
+    void snapshotTo(std::ostream &s) const
+    {
+        const std::size_t end = m_storage.nonModTail().load(std::memory_order_acquire);
+        WriterSlot::waitForWriters();
+        const auto copy = std::make_unique_for_overwrite<char[]>(bufferSize);
+        std::memcpy(copy.get(), m_storage.buffer(), bufferSize);
+        const std::vector<BlockOffset> offsets = blockOffsets();
+        // NOTE: a reservation seen here may have overwritten the copy, anything older is intact
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const std::size_t overwritten = m_storage.nonModTail().load(std::memory_order_relaxed);
+        writeTo(s, copy.get(), offsets, std::min(end, std::max(overwritten, bufferSize) - bufferSize), end, false);
+    }
+    /// Writes the records without allocating or locking, for a fatal signal handler
+    ///
+    /// Other threads may keep tracing, as the buffer is not copied first. Returns the offset
+    /// into the output of the first record that was certainly not overwritten before it got
+    /// written, the output size if there is none. Records in flight can be incomplete at the end.
+    template <typename Stream>
+    std::size_t writeLiveTo(Stream &s) const
+    {
+        const auto overwrittenBelow = [this] {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return std::max(m_storage.nonModTail().load(std::memory_order_relaxed), bufferSize) - bufferSize;
+        };
+        const std::size_t end = m_storage.nonModTail().load(std::memory_order_acquire);
+        std::size_t begin = std::max(end, bufferSize) - bufferSize;
+        std::size_t torn = begin;
+        if (begin > 0u)
+        {
+            begin = firstRecordAfter(m_storage.blockOffsets(), begin, end);
+            // NOTE: the offset of the first block is of a later lap once that block got reused
+            torn = overwrittenBelow() >= begin / blockSize * blockSize ? begin + 1u : begin;
+        }
+        // NOTE: in pieces, such that whatever got overwritten only costs the pieces before it
+        constexpr std::size_t pieceSize = std::min<std::size_t>(bufferSize, 64u * 1024u);
+        for (std::size_t position = begin; position < end;)
+        {
+            const std::size_t modPosition = position % bufferSize;
+            const std::size_t size = std::min({end - position, mirrored ? pieceSize : bufferSize - modPosition, pieceSize});
+            s.write(m_storage.buffer() + modPosition, static_cast<std::streamsize>(size));
+            position += size;
+            torn = std::max(torn, std::min(position, overwrittenBelow()));
+        }
+        if (torn == begin)
+        {
+            return 0u;
+        }
+        for (std::size_t block = (torn - 1u) / blockSize + 1u; block * blockSize < end; ++block)
+        {
+            const BlockOffset offset = m_storage.blockOffsets()[block % blockCount].load(std::memory_order_relaxed);
+            if (offset != noRecord && overwrittenBelow() < block * blockSize)
+            {
+                return std::min(end, block * blockSize + offset) - begin;
+            }
+        }
+        return end - begin;
+    }
+    template <TriviallyCopyable T>
+    static void writeRecordTo(std::ostream &s, const T t)
+    {
+        s.write(reinterpret_cast<const char *>(&t), sizeof(T));
+    }
+
+private:
+    /// Publishes the writer in flight to other processes, for storage that does so, see MappedStorage
+    std::uint64_t beginWrite(const WriterSlot &slot) __attribute__((always_inline))
+    {
+        if constexpr (requires { m_storage.beginWrite(slot); })
+        {
+            return m_storage.beginWrite(slot);
+        }
+        return 0u;
+    }
+    void endWrite(const WriterSlot &slot, const std::uint64_t published) __attribute__((always_inline))
+    {
+        if constexpr (requires { m_storage.endWrite(slot, published); })
+        {
+            m_storage.endWrite(slot, published);
+        }
+    }
+
+    template <TriviallyCopyable T, typename... Parts>
+    void write(const std::size_t nonModTail, const T t, const Parts... parts) __attribute__((always_inline))
+    {
+        // NOTE: compiler will replace module power-of-2 by non-branching AND
+        const std::size_t tail = nonModTail % bufferSize;
+        if constexpr (mirrored)
+        {
+            std::memcpy(&m_storage.buffer()[tail], &t, sizeof(T));
+        }
+        else if (tail < bufferSize - sizeof(T))
+        {
+            // This hot path will typically not create t as such, but prefer a
+            // direct copy from the input arguments
+            std::memcpy(&m_storage.buffer()[tail], &t, sizeof(T));
+        }
+        else
+        {
+            const std::size_t firstPart = bufferSize - tail;
+            const auto explicitT = t; // only here, the T will be constructed
+            std::memcpy(&m_storage.buffer()[tail], &explicitT, firstPart);
+            std::memcpy(&m_storage.buffer()[0], reinterpret_cast<const char *>(&explicitT) + firstPart, sizeof(T) - firstPart);
+        }
+        std::size_t next = nonModTail + sizeof(T);
+        (copyIn(next, parts), ...);
+        if (nonModTail / blockSize != next / blockSize) [[unlikely]]
+        {
+            markBlocks(nonModTail, next);
+        }
+    }
+    void copyIn(std::size_t &nonModPosition, const std::span<const char> part)
+    {
+        if (part.empty())
+        {
+            return;
+        }
+        const std::size_t position = nonModPosition % bufferSize;
+        if constexpr (mirrored)
+        {
+            std::memcpy(&m_storage.buffer()[position], part.data(), part.size());
+        }
+        else
+        {
+            const std::size_t firstPart = std::min(part.size(), bufferSize - position);
+            std::memcpy(&m_storage.buffer()[position], part.data(), firstPart);
+            std::memcpy(&m_storage.buffer()[0], part.data() + firstPart, part.size() - firstPart);
+        }
+        nonModPosition += part.size();
+    }
+    /// The record ending at next is followed by the first record of the block of next
+    void markBlocks(const std::size_t nonModTail, const std::size_t next)
+    {
+        for (std::size_t block = nonModTail / blockSize + 1u; block < next / blockSize; ++block)
+        {
+            m_storage.blockOffsets()[block % blockCount].store(noRecord, std::memory_order_release);
+        }
+        // NOTE: released, such that a reader that sees this offset also sees the reservation
+        m_storage.blockOffsets()[next / blockSize % blockCount].store(static_cast<BlockOffset>(next % blockSize), std::memory_order_release);
+    }
+    std::vector<BlockOffset> blockOffsets() const
+    {
+        std::vector<BlockOffset> offsets(blockCount);
+        std::transform(m_storage.blockOffsets(), m_storage.blockOffsets() + blockCount, offsets.begin(), [](const auto &offset) { return offset.load(std::memory_order_relaxed); });
+        return offsets;
+    }
+    /// Non-modulo position of the first record at or after the block boundary following begin
+    template <typename Offsets>
+    static std::size_t firstRecordAfter(const Offsets &offsets, const std::size_t begin, const std::size_t end)
+    {
+        // NOTE: the block of begin itself got its offset from the current lap already
+        for (std::size_t block = begin / blockSize + 1u; block * blockSize < end; ++block)
+        {
+            if (const BlockOffset offset = offsets[block % blockCount]; offset != noRecord)
+            {
+                return std::min(end, block * blockSize + offset);
+            }
+        }
+        return end;
+    }
+    /// A contiguous buffer continues beyond bufferSize, as the storage of a mirrored one does
+    static void writeTo(std::ostream &s, const char *buffer, const std::vector<BlockOffset> &offsets, std::size_t begin, const std::size_t end, const bool contiguous)
+    {
+        if (begin > 0u)
+        {
+            begin = firstRecordAfter(offsets, begin, end);
+        }
+        const std::size_t modBegin = begin % bufferSize;
+        const std::size_t firstPart = contiguous ? end - begin : std::min(end - begin, bufferSize - modBegin);
+        s.write(buffer + modBegin, static_cast<std::streamsize>(firstPart));
+        if (firstPart < end - begin)
+        {
+            s.write(buffer, static_cast<std::streamsize>(end - begin - firstPart));
+        }
+
+        if constexpr (indexed)
+        {
+            const std::size_t firstBoundary = (begin / blockSize + 1u) * blockSize;
+            BlockIndex index{end - begin, firstBoundary - begin, blockSize, 0u};
+            for (std::size_t boundary = firstBoundary; boundary < end; boundary += blockSize, ++index.entryCount)
+            {
+                const std::uint64_t entry = firstRecordAfter(offsets, boundary - 1u, end) - begin;
+                s.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+            }
+            s.write(reinterpret_cast<const char *>(&index), sizeof(index));
+        }
+    }
+
+    Storage<sizeLog2> m_storage;
+};
+
+/// String literal as a template argument, see Logger::trace<format>
+template <std::size_t N>
+struct FixedString
+{
+    constexpr FixedString(const char (&string)[N])
+    {
+        std::copy_n(string, N, m_data);
+    }
+    char m_data[N];
+};
+template <std::size_t N, std::size_t M>
+constexpr FixedString<N + M - 1u> operator+(const FixedString<N> &a, const FixedString<M> &b)
+{
+    char data[N + M - 1u]{};
+    std::copy_n(a.m_data, N - 1u, data);
+    std::copy_n(b.m_data, M, data + N - 1u);
+    return FixedString<N + M - 1u>(data);
+}
+
+/// First type of a formatted trace, the symbol of its tag spells the format for the decoder
+template <FixedString format>
+struct Format
+{
+};
+
+/// First type of a trace<level> call, ahead of a Format
+template <Level level>
+struct Severity
+{
+};
+
+/// Fixed part of a BoundedPayload argument, its elements follow the fixed part of the record
+/// in the order of the arguments
+template <TriviallyCopyable T>
+struct __attribute__((packed)) Payload
+{
+    std::uint16_t count; /// elements that follow
+    bool truncated; /// whether the cap cut off elements
+};
+
+/// What a trace argument contributes to the fixed part of its record
+template <typename T>
+struct Encoded
+{
+    using type = T;
+};
+template <BoundedPayload T>
+struct Encoded<T>
+{
+    using type = Payload<typename View<T>::Element>;
+};
+
+/// Argument types that a TypeLayout spells out, the decoder knows them in the same order
+using ArgumentTypes = std::tuple<bool, char, signed char, unsigned char, short, unsigned short, int, unsigned int, long, unsigned long, long long, unsigned long long, wchar_t, char8_t,
+                                 char16_t, char32_t, float, double, long double, Clocks::Calibration, TimeAnchor>;
+
+/// One plus the index of the type in ArgumentTypes, 0 if only the symbols tell
+template <typename T>
+constexpr std::uint8_t argumentCode()
+{
+    return []<typename... Types>(std::type_identity<std::tuple<Types...>>) {
+        std::uint8_t code = 0u;
+        std::uint8_t i = 0u;
+        ((++i, code = std::is_same_v<T, Types> ? i : code), ...);
+        return code;
+    }(std::type_identity<ArgumentTypes>());
+}
+
+/// Argument of a TypeLayout
+struct __attribute__((packed)) ArgumentLayout
+{
+    std::uint8_t code; /// see argumentCode
+    bool payload; /// a Payload, its elements of the code follow the fixed part
+};
+
+/// What the tag of a LoggerTraceTypeInfo stands for, such that a decoder needs no symbols
+struct TypeLayout
+{
+    static constexpr std::uint8_t noLevel = 0xFF;
+
+    std::string_view format; /// of a trace<format> call, empty otherwise
+    std::uint8_t level; /// of a trace<level> call, noLevel otherwise
+    bool sampled; /// the fixed part starts with a Suppressed
+    bool span; /// the fixed part starts with a SpanEnd
+    bool complete; /// whether every argument has a code, the symbols tell the others
+    std::span<const ArgumentLayout> arguments;
+};
+
+/// Contribution of one type of a LoggerTraceTypeInfo to its TypeLayout
+struct NoLayout
+{
+    static constexpr bool argument = false;
+    static constexpr ArgumentLayout layout{};
+    static constexpr std::string_view format{};
+    static constexpr std::uint8_t level = TypeLayout::noLevel;
+    static constexpr bool sampled = false;
+    static constexpr bool span = false;
+};
+template <typename T>
+struct LayoutOf : NoLayout
+{
+    static constexpr bool argument = true;
+    static constexpr ArgumentLayout layout{argumentCode<T>(), false};
+};
+template <typename T>
+struct LayoutOf<Payload<T>> : NoLayout
+{
+    static constexpr bool argument = true;
+    static constexpr ArgumentLayout layout{argumentCode<T>(), true};
+};
+template <FixedString text>
+struct LayoutOf<Format<text>> : NoLayout
+{
+    static constexpr std::string_view format{text.m_data, sizeof(text.m_data) - 1u};
+};
+template <Level severity>
+struct LayoutOf<Severity<severity>> : NoLayout
+{
+    static constexpr std::uint8_t level = static_cast<std::uint8_t>(severity);
+};
+
+// NOTE: hidden, such that the tag address is a link-time constant, also in position independent code
+template <typename... Ts>
+struct __attribute__((visibility("hidden"))) LoggerTraceTypeInfo
+{
+    static void tag(){}
+
+    static constexpr std::size_t argumentCount = (std::size_t{LayoutOf<Ts>::argument} + ... + 0u);
+    static constexpr std::array<ArgumentLayout, argumentCount> arguments = [] {
+        std::array<ArgumentLayout, argumentCount> result{};
+        std::size_t i = 0u;
+        ((LayoutOf<Ts>::argument ? void(result[i++] = LayoutOf<Ts>::layout) : void()), ...);
+        return result;
+    }();
+    static constexpr TypeLayout layout{
+        [] {
+            std::string_view format;
+            ((format = LayoutOf<Ts>::format.empty() ? format : LayoutOf<Ts>::format), ...);
+            return format;
+        }(),
+        std::min({TypeLayout::noLevel, LayoutOf<Ts>::level...}),
+        (LayoutOf<Ts>::sampled || ...),
+        (LayoutOf<Ts>::span || ...),
+        ((!LayoutOf<Ts>::argument || LayoutOf<Ts>::layout.code != 0u) && ...),
+        arguments,
+    };
+};
+
+/// Every call site of callSite() adds one entry to the minimal_logging_call_sites section
+struct CallSite
+{
+    uintptr_t m_traceCallSite; /// where is trace called from?
+    uintptr_t m_traceInnerInstance; /// what templated form?
+    bool m_enabled; /// whether the trace writes, see CallSites::setEnabled
+    bool m_watched; /// whether a buffer checks the arguments for a trigger, see TriggeredBuffer::triggerWhen
+    const TypeLayout *m_layout; /// what arguments?
+
+    bool enabled() __attribute__((always_inline))
+    {
+        return std::atomic_ref<bool>(m_enabled).load(std::memory_order_relaxed);
+    }
+    void setEnabled(const bool enabled)
+    {
+        std::atomic_ref<bool>(m_enabled).store(enabled, std::memory_order_relaxed);
+    }
+    bool watched() __attribute__((always_inline))
+    {
+        return std::atomic_ref<bool>(m_watched).load(std::memory_order_relaxed);
+    }
+    void setWatched(const bool watched)
+    {
+        std::atomic_ref<bool>(m_watched).store(watched, std::memory_order_relaxed);
+    }
+};
+// NOTE: an empty section in every translation unit, such that the linker always defines its bounds
+asm(".pushsection minimal_logging_call_sites, \"aw\"\n"
+    ".popsection");
+extern "C" CallSite __start_minimal_logging_call_sites[] __attribute__((visibility("hidden")));
+extern "C" CallSite __stop_minimal_logging_call_sites[] __attribute__((visibility("hidden")));
+
+/// All call sites in this binary, indexed by their dense id
+inline std::span<CallSite> callSites()
+{
+    return {__start_minimal_logging_call_sites, __stop_minimal_logging_call_sites};
+}
+
+/// The linker collects the entries, so the dense id is the position in the section
+///
+/// Entries start out enabled, the section is writable such that CallSites can switch them.
+/// The entries join the section group of the calling function, such that the linker drops
+/// them together with the copies of an inline function that it discards.
+template <typename TypeInfo>
+static inline CallSite *callSiteOf() __attribute__((always_inline))
+{
+    CallSite *callSite;
+#ifdef ARM
+    asm volatile(".pushsection minimal_logging_call_sites, \"aw?\"\n"
+                 ".balign 8\n"
+                 "1: .dc.a 2f, %c1\n"
+                 ".byte 1, 0\n"
+                 ".balign 8\n"
+                 ".dc.a %c2\n"
+                 ".popsection\n"
+                 "2: ADRP %0, 1b\n"
+                 "ADD %0, %0, :lo12:1b"
+                 : "=r"(callSite)
+                 : "i"(&TypeInfo::tag), "i"(&TypeInfo::layout));
+#elifdef X86
+    asm volatile(".pushsection minimal_logging_call_sites, \"aw?\"\n"
+                 ".balign 8\n"
+                 "1: .dc.a 2f, %c1\n"
+                 ".byte 1, 0\n"
+                 ".balign 8\n"
+                 ".dc.a %c2\n"
+                 ".popsection\n"
+                 "2: lea 1b(%%rip), %0"
+                 : "=r"(callSite)
+                 : "i"(&TypeInfo::tag), "i"(&TypeInfo::layout));
+#else
+    static_assert(false, "No implementation to register the call site");
+#endif
+    return callSite;
+}
+template <typename... Ts>
+static inline CallSite *callSite() __attribute__((always_inline))
+{
+    return callSiteOf<LoggerTraceTypeInfo<Ts...>>();
+}
+static inline std::size_t callSiteId(const CallSite *callSite) __attribute__((always_inline))
+{
+    return static_cast<std::size_t>(callSite - __start_minimal_logging_call_sites);
+}
+template <typename... Ts>
+static inline std::size_t callSiteId() __attribute__((always_inline))
+{
+    return callSiteId(callSite<Ts...>());
+}
+
+/// First argument of a sampled record, the traces that its call site dropped in between
+struct Suppressed
+{
+    std::uint64_t count;
+};
+template <>
+struct LayoutOf<Suppressed> : NoLayout
+{
+    static constexpr bool sampled = true;
+};
+
+/// What a Sampling policy keeps per call site and thread
+struct SamplingState
+{
+    std::uint64_t count = 0u; /// traces so far
+    std::uint64_t suppressed = 0u; /// since the last one that got through
+    std::int64_t tokens = 0; /// of a RateLimit, in nanoseconds
+    std::int64_t last = 0; /// steady clock of the last refill, in nanoseconds
+};
+
+/// State of the sampled call site in the calling thread
+///
+/// NOTE: thread-local, so sampling takes neither a lock nor a shared cache line. The
+/// states of all call sites are allocated at the first sampled trace of a thread.
+inline SamplingState &samplingState(const std::size_t callSiteId) __attribute__((always_inline))
+{
+    static thread_local std::vector<SamplingState> t_states;
+    if (callSiteId >= t_states.size()) [[unlikely]]
+    {
+        t_states.resize(callSites().size());
+    }
+    return t_states[callSiteId];
+}
+
+/// What Logger::fold keeps per call site and thread, the arguments of its previous record
+struct FoldState
+{
+    static constexpr std::size_t argumentsSize = 32u;
+    std::array<char, argumentsSize> arguments{}; /// packed, the rest zero
+    std::uint64_t repeats = 0u; /// identical traces since the record, not written yet
+    std::int64_t last = 0; /// time stamp of the last repeat, in the time unit of the clock
+    std::uint64_t owner = 0u; /// id of the logger of the record, see PendingOwners
+    bool active = false; /// whether arguments holds those of a record
+};
+
+/// Value of Logger::aggregate
+template <typename T>
+concept Numeric = std::is_arithmetic_v<T> && !std::is_same_v<T, bool>;
+
+/// What Logger::aggregate keeps per call site and thread, the values since its last summary
+///
+/// The histogram is log-linear: exact below 4, then 4 buckets per power of two, such that a
+/// bucket spans at most a quarter of its lower bound. Values count by their integer part,
+/// negative ones in the first bucket, the count, minimum, maximum and mean are exact.
+struct AggregateState
+{
+    static constexpr std::size_t bucketCount = 252u;
+
+    std::uint64_t count = 0u; /// values since the summary
+    double sum = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    std::int64_t first = 0; /// time stamp of the first value, in the time unit of the clock
+    std::int64_t last = 0; /// time stamp of the last value
+    std::uint64_t owner = 0u; /// id of the logger of the summary, see PendingOwners
+    std::array<std::uint32_t, bucketCount> buckets{};
+
+    template <Numeric T>
+    void add(const T value) __attribute__((always_inline))
+    {
+        const double v = static_cast<double>(value);
+        min = count == 0u || v < min ? v : min;
+        max = count == 0u || v > max ? v : max;
+        sum += v;
+        ++count;
+        ++buckets[bucketOf(magnitudeOf(value))];
+    }
+
+    template <Numeric T>
+    static std::uint64_t magnitudeOf(const T value) __attribute__((always_inline))
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            return !(value > T{0}) ? 0u : value >= T{18446744073709551616.0} ? std::numeric_limits<std::uint64_t>::max() : static_cast<std::uint64_t>(value);
+        }
+        else if constexpr (std::is_signed_v<T>)
+        {
+            return value < T{0} ? 0u : static_cast<std::uint64_t>(value);
+        }
+        else
+        {
+            return static_cast<std::uint64_t>(value);
+        }
+    }
+    static constexpr std::size_t bucketOf(const std::uint64_t value) __attribute__((always_inline))
+    {
+        if (value < 4u)
+        {
+            return static_cast<std::size_t>(value);
+        }
+        const std::size_t exponent = static_cast<std::size_t>(std::bit_width(value)) - 1u;
+        return 4u + (exponent - 2u) * 4u + static_cast<std::size_t>(value >> (exponent - 2u) & 3u);
+    }
+    /// Least value of the bucket, the next bucket starts right after its greatest
+    static constexpr std::uint64_t lowerBound(const std::size_t bucket)
+    {
+        return bucket < 4u ? bucket : (4u + (bucket - 4u) % 4u) << ((bucket - 4u) / 4u);
+    }
+    /// Greatest value of the bucket
+    static constexpr std::uint64_t upperBound(const std::size_t bucket)
+    {
+        return bucket + 1u < bucketCount ? lowerBound(bucket + 1u) - 1u : std::numeric_limits<std::uint64_t>::max();
+    }
+    /// Upper bound of the bucket of the quantile, within the minimum and maximum
+    double quantile(const double q) const
+    {
+        const std::uint64_t rank = std::max<std::uint64_t>(1u, static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(count))));
+        std::uint64_t below = 0u;
+        std::size_t bucket = 0u;
+        while (bucket + 1u < bucketCount && (below += buckets[bucket]) < rank)
+        {
+            ++bucket;
+        }
+        return std::clamp(static_cast<double>(upperBound(bucket)), min, max);
+    }
+};
+static_assert(AggregateState::bucketOf(std::numeric_limits<std::uint64_t>::max()) + 1u == AggregateState::bucketCount);
+
+/// Logger that threads keep pending records for, see Logger::fold and Logger::aggregate
+///
+/// Each writer is only set once the logger folds or aggregates, such that a logger that only
+/// folds does not instantiate the summary record.
+struct PendingOwner
+{
+    void *logger = nullptr;
+    void (*writeRepeats)(void *logger, CallSite &callSite, FoldState &state) = nullptr;
+    void (*writeAggregate)(void *logger, CallSite &callSite, AggregateState &state) = nullptr;
+};
+
+/// Loggers with pending records in some thread, by an id that is never reused
+///
+/// A thread writes its pending records to their logger only while it is registered, such
+/// that neither a destroyed logger nor a later one at the same address receives them.
+class PendingOwners
+{
+public:
+    static std::uint64_t nextId()
+    {
+        static std::atomic<std::uint64_t> s_nextId{1u};
+        return s_nextId.fetch_add(1u, std::memory_order_relaxed);
+    }
+    static void addFolds(const std::uint64_t id, void *const logger, decltype(PendingOwner::writeRepeats) writeRepeats)
+    {
+        const std::lock_guard lock(s_mutex);
+        PendingOwner &owner = s_owners[id];
+        owner.logger = logger;
+        owner.writeRepeats = writeRepeats;
+    }
+    static void addAggregates(const std::uint64_t id, void *const logger, decltype(PendingOwner::writeAggregate) writeAggregate)
+    {
+        const std::lock_guard lock(s_mutex);
+        PendingOwner &owner = s_owners[id];
+        owner.logger = logger;
+        owner.writeAggregate = writeAggregate;
+    }
+    static void remove(const std::uint64_t id)
+    {
+        const std::lock_guard lock(s_mutex);
+        s_owners.erase(id);
+    }
+    /// Calls f with the owner, if it is still registered, which it remains during the call
+    template <typename F>
+    static void with(const std::uint64_t id, F f)
+    {
+        const std::lock_guard lock(s_mutex);
+        if (const auto it = s_owners.find(id); it != s_owners.end())
+        {
+            f(it->second);
+        }
+    }
+
+private:
+    static inline std::mutex s_mutex;
+    static inline std::unordered_map<std::uint64_t, PendingOwner> s_owners;
+};
+
+/// Pending records of the calling thread, written to their loggers when the thread ends
+struct PendingStates
+{
+    std::vector<FoldState> folds; /// of all call sites, allocated at the first folded trace
+    std::vector<std::unique_ptr<AggregateState>> aggregates; /// each allocated at the first value of its call site
+
+    ~PendingStates()
+    {
+        for (std::size_t id = 0u; id < folds.size(); ++id)
+        {
+            if (folds[id].repeats > 0u)
+            {
+                PendingOwners::with(folds[id].owner, [&](const PendingOwner &owner) { owner.writeRepeats(owner.logger, callSites()[id], folds[id]); });
+            }
+        }
+        for (std::size_t id = 0u; id < aggregates.size(); ++id)
+        {
+            if (aggregates[id] && aggregates[id]->count > 0u)
+            {
+                PendingOwners::with(aggregates[id]->owner, [&](const PendingOwner &owner) { owner.writeAggregate(owner.logger, callSites()[id], *aggregates[id]); });
+            }
+        }
+        s_exited = true;
+    }
+
+    /// Null once the thread has ended, rather than building its destroyed states again
+    static PendingStates *current() __attribute__((always_inline))
+    {
+        static thread_local PendingStates t_states;
+        return s_exited ? nullptr : &t_states;
+    }
+
+    static inline thread_local bool s_exited = false;
+};
+
+/// State of the folded call site in the calling thread, null once the thread has ended
+inline FoldState *foldState(const std::size_t callSiteId) __attribute__((always_inline))
+{
+    PendingStates *const states = PendingStates::current();
+    if (states == nullptr) [[unlikely]]
+    {
+        return nullptr;
+    }
+    if (callSiteId >= states->folds.size()) [[unlikely]]
+    {
+        states->folds.resize(callSites().size());
+    }
+    return &states->folds[callSiteId];
+}
+
+/// State of the aggregated call site in the calling thread, null once the thread has ended
+inline AggregateState *aggregateState(const std::size_t callSiteId) __attribute__((always_inline))
+{
+    PendingStates *const states = PendingStates::current();
+    if (states == nullptr) [[unlikely]]
+    {
+        return nullptr;
+    }
+    if (callSiteId >= states->aggregates.size() || !states->aggregates[callSiteId]) [[unlikely]]
+    {
+        states->aggregates.resize(std::max(states->aggregates.size(), callSites().size()));
+        states->aggregates[callSiteId] = std::make_unique<AggregateState>();
+    }
+    return states->aggregates[callSiteId].get();
+}
+
+/// First argument of a span record, written when the scope of Logger::span ends
+struct __attribute__((packed)) SpanEnd
+{
+    std::int64_t duration; /// in the time unit of the clock, the record holds the start
+    std::uint16_t thread; /// see SpanThread
+    std::uint16_t depth; /// spans of the same thread that enclose this one
+};
+template <>
+struct LayoutOf<SpanEnd> : NoLayout
+{
+    static constexpr bool span = true;
+};
+
+/// What Logger::span keeps per thread
+struct SpanThread
+{
+    std::uint16_t id; /// dense, in the order of the first span of each thread
+    std::uint16_t depth = 0u; /// spans open right now
+};
+inline SpanThread &spanThread() __attribute__((always_inline))
+{
+    static std::atomic<std::uint16_t> s_threadCount{0u};
+    static thread_local SpanThread t_thread{s_threadCount.fetch_add(1u, std::memory_order_relaxed)};
+    return t_thread;
+}
+} // namespace Details
+
+namespace Clocks
+{
+/// Converts the ticks of a CycleCounter into wall clock time
+struct Calibration
+{
+    double ticksPerSecond;
+    std::int64_t anchorTicks;
+    std::int64_t anchorNanoseconds; /// since epoch
+};
+
+/// Nanoseconds since epoch, through clock_gettime
+struct HighResolution
+{
+    using Clock = std::chrono::high_resolution_clock;
+    using TimeUnit = std::chrono::nanoseconds;
+    static inline TimeUnit::rep now()
+    {
+        return std::chrono::duration_cast<TimeUnit>(Clock::now().time_since_epoch()).count();
+    }
+};
+
+/// Raw cycle counter, a Calibration record in the stream converts it afterwards
+struct CycleCounter
+{
+    struct TimeUnit /// ticks without a compile-time period
+    {
+        using rep = std::int64_t;
+    };
+    static inline TimeUnit::rep now() __attribute__((always_inline))
+    {
+#ifdef ARM
+        TimeUnit::rep ticks;
+        asm volatile("MRS %0, CNTVCT_EL0" : "=r"(ticks));
+        return ticks;
+#elifdef X86
+        std::uint32_t low, high;
+        asm volatile("rdtsc" : "=a"(low), "=d"(high));
+        return static_cast<TimeUnit::rep>((std::uint64_t{high} << 32) | low);
+#else
+        static_assert(false, "No implementation to retrieve the cycle counter");
+#endif
+    }
+
+    static Calibration calibration()
+    {
+        using namespace std::chrono;
+#ifdef ARM
+        std::uint64_t frequency;
+        asm volatile("MRS %0, CNTFRQ_EL0" : "=r"(frequency));
+        const double ticksPerSecond = static_cast<double>(frequency);
+#else
+        // NOTE: the longer the process runs, the more accurate the frequency estimate
+        std::this_thread::sleep_until(s_start.steady + milliseconds(10));
+        const Anchor end = anchor();
+        const double ticksPerSecond = static_cast<double>(end.ticks - s_start.ticks) / duration<double>(end.steady - s_start.steady).count();
+#endif
+        const auto wallClock = system_clock::now();
+        const TimeUnit::rep ticks = now();
+        return {ticksPerSecond, ticks, duration_cast<nanoseconds>(wallClock.time_since_epoch()).count()};
+    }
+
+private:
+    struct Anchor
+    {
+        TimeUnit::rep ticks;
+        std::chrono::steady_clock::time_point steady;
+    };
+    static Anchor anchor()
+    {
+        return {now(), std::chrono::steady_clock::now()};
+    }
+    static inline const Anchor s_start = anchor();
+};
+} // namespace Clocks
 
 namespace Details
 {
-template <std::size_t sizeLog2>
-class CircularBuffer
+/// NT_GNU_BUILD_ID note of the main executable, empty if it was linked without one
+inline std::span<const unsigned char> buildId()
 {
-public:
-    static constexpr std::size_t bufferSize = 1 << sizeLog2;
+    static const std::span<const unsigned char> s_buildId = [] {
+        std::span<const unsigned char> buildId;
+        ::dl_iterate_phdr(
+            [](dl_phdr_info *info, std::size_t, void *data) {
+                for (const ElfW(Phdr) &segment : std::span(info->dlpi_phdr, info->dlpi_phnum))
+                {
+                    if (segment.p_type != PT_NOTE)
+                    {
+                        continue;
+                    }
+                    const auto *note = reinterpret_cast<const unsigned char *>(info->dlpi_addr + segment.p_vaddr);
+                    for (std::size_t offset = 0u; offset + sizeof(ElfW(Nhdr)) <= segment.p_memsz;)
+                    {
+                        ElfW(Nhdr) header;
+                        std::memcpy(&header, note + offset, sizeof(header));
+                        const std::size_t name = offset + sizeof(header);
+                        const std::size_t description = name + (header.n_namesz + 3u) / 4u * 4u;
+                        if (header.n_type == NT_GNU_BUILD_ID && header.n_namesz == 4u && std::memcmp(note + name, "GNU", 4u) == 0)
+                        {
+                            *static_cast<std::span<const unsigned char> *>(data) = {note + description, header.n_descsz};
+                            return 1;
+                        }
+                        offset = description + (header.n_descsz + 3u) / 4u * 4u;
+                    }
+                }
+                return 1; // NOTE: the first object is the main executable
+            },
+            &buildId);
+        return buildId;
+    }();
+    return s_buildId;
+}
 
-    void clear()
-    {
-        m_nonModTail = 0u;
-        m_bufferFull = false;
-    }
-    template <TriviallyCopyable T>
-    void append(const T t)
+/// Start of a dump, ahead of the records, see Logger::writeTo
+///
+/// Makes the dump self-describing: the type table holds the TypeLayout of every call site
+/// in the executable, so the decoder reads the arguments without symbols. The symbols only
+/// name the call sites, the build id tells which symbol file does.
+struct __attribute__((packed)) DumpHeader
+{
+    static constexpr std::array<char, 8> expectedMagic{'M', 'i', 'n', 'L', 'o', 'g', 'D', '1'};
+
+    std::array<char, 8> magic;
+    std::uint64_t size; /// of the header, the type table and the padding, the records follow
+    std::uint64_t buildIdSize;
+    std::array<unsigned char, 32> buildId; /// NT_GNU_BUILD_ID of the executable that traced
+    std::uint64_t calibrated; /// whether calibration is set
+    Clocks::Calibration calibration;
+    std::uint64_t typeCount; /// entries of the type table
+};
+
+/// Entry of the type table of a DumpHeader, followed by its arguments and the characters of its format
+struct __attribute__((packed)) TypeTableEntry
+{
+    std::uint64_t tag; /// run-time address of LoggerTraceTypeInfo<Ts...>::tag, as in the records
+    std::uint8_t level; /// see TypeLayout
+    std::uint8_t sampled;
+    std::uint8_t span;
+    std::uint16_t argumentCount; /// ArgumentLayouts that follow
+    std::uint16_t formatSize;
+};
+
+/// DumpHeader with the type table of all call sites, zero padded to a multiple of alignment
+///
+/// Types with an argument that has no ArgumentCode are left out, the decoder resolves them
+/// through the symbols.
+inline std::string dumpHeader(const std::optional<Clocks::Calibration> &calibration, const std::size_t alignment = 1u)
+{
+    std::vector<std::pair<std::uintptr_t, const TypeLayout *>> types;
+    for (const CallSite &callSite : callSites())
     {
-        // NOTE: compiler will replace module power-of-2 by non-branching AND
-        const std::size_t tail = m_nonModTail.fetch_add(sizeof(T)) % bufferSize;
-        if (tail < bufferSize - sizeof(T))
-        {
-            // This hot path will typically not create t as such, but prefer a
-            // direct copy from the input arguments
-            std::memcpy(&m_buffer[tail], &t, sizeof(T));
-        }
-        else
+        if (callSite.m_layout->complete)
         {
-            m_bufferFull = true;
-            const std::size_t firstPart = bufferSize - tail;
-            const auto explicitT = t; // only here, the T will be constructed
-            std::memcpy(&m_buffer[tail], &explicitT, firstPart);
-            std::memcpy(&m_buffer[0], reinterpret_cast<const char *>(&explicitT) + firstPart, sizeof(T) - firstPart);
+            types.emplace_back(callSite.m_traceInnerInstance, callSite.m_layout);
         }
     }
+    std::ranges::sort(types);
+    const auto [end, last] = std::ranges::unique(types, {}, &std::pair<std::uintptr_t, const TypeLayout *>::first);
+    types.erase(end, last);
 
-    void writeTo(std::ostream &s) const
+    DumpHeader header{};
+    header.magic = DumpHeader::expectedMagic;
+    const std::span<const unsigned char> id = buildId();
+    header.buildIdSize = std::min(id.size(), header.buildId.size());
+    std::copy_n(id.begin(), header.buildIdSize, header.buildId.begin());
+    header.calibrated = calibration.has_value();
+    header.calibration = calibration.value_or(Clocks::Calibration{});
+    header.typeCount = types.size();
+
+    std::string result(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto &[tag, layout] : types)
+    {
+        const TypeTableEntry entry{tag, layout->level, layout->sampled, layout->span, static_cast<std::uint16_t>(layout->arguments.size()), static_cast<std::uint16_t>(layout->format.size())};
+        result.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        result.append(reinterpret_cast<const char *>(layout->arguments.data()), layout->arguments.size_bytes());
+        result.append(layout->format);
+    }
+    result.resize((result.size() + alignment - 1u) / alignment * alignment, '\0');
+    const std::uint64_t size = result.size();
+    std::memcpy(result.data() + offsetof(DumpHeader, size), &size, sizeof(size));
+    return result;
+}
+} // namespace Details
+
+/// Switches traces on and off at run time, e.g. to silence a noisy call site without a restart
+///
+/// A disabled trace costs one load of its flag and a branch, it neither reads the clock nor
+/// writes. See LogDecoder::setCallSitesEnabled to select the call sites by function name.
+namespace CallSites
+{
+/// Enables or disables the call sites at a run-time address in [begin, end), returns how many
+inline std::size_t setEnabled(const std::uintptr_t begin, const std::uintptr_t end, const bool enabled)
+{
+    std::size_t count = 0u;
+    for (Details::CallSite &callSite : Details::callSites())
     {
-        const std::size_t tail = m_nonModTail % bufferSize;
-        if (m_bufferFull)
+        if (callSite.m_traceCallSite >= begin && callSite.m_traceCallSite < end)
         {
-            s.write(&m_buffer[tail], static_cast<std::streamsize>(bufferSize - tail));
+            callSite.setEnabled(enabled);
+            ++count;
         }
-        s.write(m_buffer.data(), static_cast<std::streamsize>(tail));
     }
+    return count;
+}
+inline void setAllEnabled(const bool enabled)
+{
+    setEnabled(0u, std::numeric_limits<std::uintptr_t>::max(), enabled);
+}
+} // namespace CallSites
 
-private:
-    std::array<char, bufferSize> m_buffer{};
-    std::atomic<std::size_t> m_nonModTail{0u};
-    bool m_bufferFull = false;
+/// Policies of Logger::sample, which let some of the traces of a call site through
+///
+/// Each admits or drops a trace given the state of its call site in the calling thread.
+namespace Sampling
+{
+/// The first of every n traces
+template <std::uint64_t n>
+struct OneIn
+{
+    static_assert(n > 0u);
+    static bool admit(Details::SamplingState &state) __attribute__((always_inline))
+    {
+        return state.count++ % n == 0u;
+    }
 };
 
-template <typename... Ts>
-struct LoggerTraceTypeInfo
+/// The first k traces, then every nth
+template <std::uint64_t k, std::uint64_t n>
+struct FirstThenEvery
 {
-    static void tag(){}
+    static_assert(n > 0u);
+    static bool admit(Details::SamplingState &state) __attribute__((always_inline))
+    {
+        const std::uint64_t count = state.count++;
+        return count < k || (count - k + 1u) % n == 0u;
+    }
 };
-} // namespace Details
 
-template <std::size_t sizeLog2>
+/// Token bucket: on average perSecond traces, in bursts of at most burst
+///
+/// NOTE: reads the steady clock for every trace, unlike the counting policies
+template <std::uint64_t perSecond, std::uint64_t burst = perSecond>
+struct RateLimit
+{
+    static_assert(perSecond > 0u && perSecond <= 1'000'000'000u && burst > 0u);
+    static constexpr std::int64_t interval = 1'000'000'000 / static_cast<std::int64_t>(perSecond); // nanoseconds per token
+    static constexpr std::int64_t capacity = interval * static_cast<std::int64_t>(burst);
+
+    static bool admit(Details::SamplingState &state) __attribute__((always_inline))
+    {
+        const std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        // NOTE: a call site starts with a full bucket
+        state.tokens = state.count++ == 0u ? capacity : std::min(capacity, state.tokens + (now - state.last));
+        state.last = now;
+        if (state.tokens < interval)
+        {
+            return false;
+        }
+        state.tokens -= interval;
+        return true;
+    }
+};
+} // namespace Sampling
+
+/// maxPayloadSize caps the bytes that a BoundedPayload argument copies into the buffer
+template <std::size_t sizeLog2, typename Clock = Clocks::HighResolution, typename Buffer = Details::CircularBuffer<sizeLog2>, std::size_t maxPayloadSize = 256u>
 class Logger
 {
+    static_assert(maxPayloadSize <= std::numeric_limits<std::uint16_t>::max(), "Payload cap too large");
+
+public:
+    Logger() = default;
+    /// Forwards the arguments to the buffer, e.g. the file of a Details::StreamingBuffer or
+    /// Details::MappedStorage
+    template <typename... Args>
+    explicit Logger(Args &&...args)
+        : m_circularBuffer(makeBuffer(std::forward<Args>(args)...))
+    {
+        // NOTE: a buffer that writes files starts them with the header of a dump
+        if constexpr (requires(std::optional<Clocks::Calibration> calibration) { m_circularBuffer.writeHeader(calibration); })
+        {
+            m_circularBuffer.writeHeader(calibration());
+        }
+    }
+    /// Threads no longer write their pending records of fold and aggregate to this logger
+    ~Logger()
+    {
+        Details::PendingOwners::remove(m_id);
+    }
+
     // Logging
 public:
-    template <TriviallyCopyable... Ts>
+    /// Copies the arguments into the buffer, unless the call site is disabled, see CallSites
+    ///
+    /// std::string_view and std::span<const T> arguments are copied inline, each at most
+    /// maxPayloadSize bytes, the decoder tells whether it got truncated. The record and the
+    /// elements take a single reservation in the buffer.
+    template <typename... Ts>
+        requires((TriviallyCopyable<Ts> || BoundedPayload<Ts>) && ...)
+    void trace(const Ts... args) __attribute__((always_inline))
+    {
+        append<Details::LoggerTraceTypeInfo<typename Details::Encoded<Ts>::type...>>(args...);
+    }
+    /// Like trace, with a message such as trace<"cache miss at {}">(address)
+    ///
+    /// Only the tag differs, the format is interned in the symbol table and never copied
+    /// into the buffer. The decoder substitutes the arguments for the {} placeholders.
+    template <Details::FixedString format, typename... Ts>
+        requires((TriviallyCopyable<Ts> || BoundedPayload<Ts>) && ...)
+    void trace(const Ts... args) __attribute__((always_inline))
+    {
+        append<Details::LoggerTraceTypeInfo<Details::Format<format>, typename Details::Encoded<Ts>::type...>>(args...);
+    }
+    /// Like trace, with a severity such as trace<Level::Warning>(code), below minimumLevel nothing
+    template <Level level, typename... Ts>
+        requires((TriviallyCopyable<Ts> || BoundedPayload<Ts>) && ...)
+    void trace(const Ts... args) __attribute__((always_inline))
+    {
+        if constexpr (level >= minimumLevel)
+        {
+            append<Details::LoggerTraceTypeInfo<Details::Severity<level>, typename Details::Encoded<Ts>::type...>>(args...);
+        }
+    }
+    template <Level level, Details::FixedString format, typename... Ts>
+        requires((TriviallyCopyable<Ts> || BoundedPayload<Ts>) && ...)
     void trace(const Ts... args) __attribute__((always_inline))
     {
-        m_circularBuffer.append(RecordT<Ts...>{now(), instructionPointer(), reinterpret_cast<uintptr_t>(&Details::LoggerTraceTypeInfo<Ts...>::tag), args...});
+        if constexpr (level >= minimumLevel)
+        {
+            append<Details::LoggerTraceTypeInfo<Details::Severity<level>, Details::Format<format>, typename Details::Encoded<Ts>::type...>>(args...);
+        }
+    }
+
+    /// Like trace, where a Sampling policy decides which traces of the call site get through
+    ///
+    /// e.g. sample<Sampling::OneIn<64>>(i) in a tight loop that would overwrite the buffer
+    /// otherwise. The record starts with a Details::Suppressed, the number of traces that the
+    /// policy dropped since the previous one, which the decoder reports.
+    template <typename Policy, typename... Ts>
+        requires((TriviallyCopyable<Ts> || BoundedPayload<Ts>) && ...)
+    void sample(const Ts... args) __attribute__((always_inline))
+    {
+        appendSampled<Details::LoggerTraceTypeInfo<Details::Suppressed, typename Details::Encoded<Ts>::type...>, Policy>(args...);
+    }
+    template <typename Policy, Details::FixedString format, typename... Ts>
+        requires((TriviallyCopyable<Ts> || BoundedPayload<Ts>) && ...)
+    void sample(const Ts... args) __attribute__((always_inline))
+    {
+        appendSampled<Details::LoggerTraceTypeInfo<Details::Format<format>, Details::Suppressed, typename Details::Encoded<Ts>::type...>, Policy>(args...);
+    }
+
+    /// Like trace, where a run of identical traces of the call site in a thread takes one record
+    ///
+    /// e.g. fold(errorCode) in a retry loop, such that the loop does not evict the history
+    /// before it. A trace with the same arguments as the previous record of the call site in
+    /// the calling thread only counts a repeat and keeps its time stamp. The next trace with
+    /// other arguments first writes a "repeated {} more times" record at the call site, with
+    /// the time stamp of the last repeat, as does flushRepeats. The arguments take at most
+    /// Details::FoldState::argumentsSize bytes. As for sampling, the state is per call site
+    /// and thread. It belongs to one logger: a trace into another logger ends the run in the
+    /// previous one, and the repeats of a thread that ends are written to their logger.
+    template <TriviallyCopyable... Ts>
+    void fold(const Ts... args) __attribute__((always_inline))
+    {
+        appendFolded<Details::LoggerTraceTypeInfo<Ts...>>(args...);
+    }
+    template <Details::FixedString format, TriviallyCopyable... Ts>
+    void fold(const Ts... args) __attribute__((always_inline))
+    {
+        appendFolded<Details::LoggerTraceTypeInfo<Details::Format<format>, Ts...>>(args...);
+    }
+    /// Writes the repeats of the runs of fold that the calling thread left open, e.g. before a snapshot
+    ///
+    /// A thread that ends writes those of its runs itself.
+    void flushRepeats()
+    {
+        Details::PendingStates *const states = Details::PendingStates::current();
+        if (states == nullptr)
+        {
+            return;
+        }
+        for (std::size_t id = 0u; id < states->folds.size(); ++id)
+        {
+            if (states->folds[id].owner == m_id && states->folds[id].repeats > 0u)
+            {
+                writeRepeats(Details::callSites()[id], states->folds[id]);
+            }
+        }
+    }
+
+    /// Folds the value into a histogram of the call site, written as one summary record
+    ///
+    /// e.g. aggregate<"queue depth">(depth) at a hot call site whose values only matter as a
+    /// distribution. The record holds the count, minimum, maximum, mean, the upper bounds of
+    /// the median and the 99th percentile, and the log-linear buckets from the first non-empty
+    /// to the last one, see Details::AggregateState. It is written at the call site, with the
+    /// time stamp of the last value, once a value comes after the interval since the first one
+    /// of the summary, see setAggregationInterval, and by flushAggregates. A summary that comes
+    /// due also writes the due summaries of the other call sites of the thread, and a thread
+    /// that ends writes its open ones. As for fold, the state is per call site and thread and
+    /// belongs to one logger, a value into another logger ends the summary in the previous one.
+    /// Only for a buffer that appends a record with a payload, unlike Details::ShardedBuffer.
+    template <Details::Numeric T>
+        requires requires(Buffer buffer, std::span<const char> part) { buffer.append(std::uint64_t{}, part); }
+    void aggregate(const T value) __attribute__((always_inline))
+    {
+        appendAggregated<Details::LoggerTraceTypeInfo<Details::Format<s_aggregateFormat>, std::uint64_t, double, double, double, double, double, std::uint16_t, Details::Payload<std::uint32_t>>>(value);
+    }
+    template <Details::FixedString name, Details::Numeric T>
+        requires requires(Buffer buffer, std::span<const char> part) { buffer.append(std::uint64_t{}, part); }
+    void aggregate(const T value) __attribute__((always_inline))
+    {
+        appendAggregated<Details::LoggerTraceTypeInfo<Details::Format<name + Details::FixedString(": ") + s_aggregateFormat>, std::uint64_t, double, double, double, double, double, std::uint16_t,
+                                                      Details::Payload<std::uint32_t>>>(value);
+    }
+    /// Interval of aggregate, unlimited by default, also while other threads aggregate
+    void setAggregationInterval(const std::chrono::nanoseconds interval)
+    {
+        if constexpr (requires { Clock::calibration(); })
+        {
+            m_aggregationInterval.store(static_cast<typename TimeUnit::rep>(static_cast<double>(interval.count()) * Clock::calibration().ticksPerSecond / 1e9), std::memory_order_relaxed);
+        }
+        else
+        {
+            m_aggregationInterval.store(std::chrono::duration_cast<TimeUnit>(interval).count(), std::memory_order_relaxed);
+        }
+    }
+    /// Writes the summaries of aggregate that the calling thread left open, e.g. before a snapshot
+    void flushAggregates()
+    {
+        writeAggregates(std::numeric_limits<std::int64_t>::max());
+    }
+
+    /// Like trace, after which the buffer persists the records so far, see Details::TriggeredBuffer
+    ///
+    /// e.g. trigger<"timeout after {} ms">(elapsed) where an anomaly shows. The record is the
+    /// last one of the snapshot. Only the buffer switches, the thread does not wait for the file.
+    template <typename... Ts>
+        requires(((TriviallyCopyable<Ts> || BoundedPayload<Ts>) && ...) && requires(Buffer buffer) { buffer.trigger(); })
+    void trigger(const Ts... args) __attribute__((always_inline))
+    {
+        trace(args...);
+        m_circularBuffer.trigger();
+    }
+    template <Details::FixedString format, typename... Ts>
+        requires(((TriviallyCopyable<Ts> || BoundedPayload<Ts>) && ...) && requires(Buffer buffer) { buffer.trigger(); })
+    void trigger(const Ts... args) __attribute__((always_inline))
+    {
+        trace<format>(args...);
+        m_circularBuffer.trigger();
+    }
+
+    /// Writes the statistics of a Details::CountingBuffer as records, e.g. once a second
+    ///
+    /// One record with the LoggerStatistics, then one for each call site that traced since
+    /// the previous call, with its records and bytes since then. These carry the address of
+    /// the call site, such that the decoder names the noisy ones.
+    void traceStatistics()
+        requires requires(Buffer buffer) { buffer.statistics(); buffer.callSiteDeltas(); }
+    {
+        const auto statistics = m_circularBuffer.statistics();
+        trace<"logger: {} bytes reserved, {} wraps, {} bytes overwritten, {} bytes lost, {} snapshots of at most {} ns">(
+            statistics.reservedBytes, statistics.wrapCount, statistics.overwrittenBytes, statistics.lostBytes, statistics.snapshotCount, statistics.maxSnapshotDuration);
+        using TypeInfo = Details::LoggerTraceTypeInfo<Details::Format<"{} records, {} bytes">, std::uint64_t, std::uint64_t>;
+        if (!Details::callSiteOf<TypeInfo>()->enabled())
+        {
+            return;
+        }
+        for (const auto &count : m_circularBuffer.callSiteDeltas())
+        {
+            m_circularBuffer.append(RecordT<std::uint64_t, std::uint64_t>{now(), count.callSite->m_traceCallSite, reinterpret_cast<uintptr_t>(&TypeInfo::tag), count.records, count.bytes});
+        }
+    }
+
+    template <typename TypeInfo, TriviallyCopyable... Ts>
+    class Span;
+    /// Times the scope of the returned object, e.g. const auto span = logger.span(requestId);
+    ///
+    /// Writes a single record when the scope ends. Its time stamp is the start, followed by a
+    /// Details::SpanEnd with the duration and the depth among the open spans of the thread.
+    /// The decoder turns these into latency histograms and stacks, see LogDecoder::SpanStatistics.
+    template <TriviallyCopyable... Ts>
+    [[nodiscard]] auto span(const Ts... args) __attribute__((always_inline))
+    {
+        return Span<Details::LoggerTraceTypeInfo<Details::SpanEnd, Ts...>, Ts...>(*this, args...);
+    }
+    template <Details::FixedString format, TriviallyCopyable... Ts>
+    [[nodiscard]] auto span(const Ts... args) __attribute__((always_inline))
+    {
+        return Span<Details::LoggerTraceTypeInfo<Details::Format<format>, Details::SpanEnd, Ts...>, Ts...>(*this, args...);
     }
 
     static inline uintptr_t instructionPointer() __attribute__((always_inline))
@@ -92,17 +1588,16 @@ public:
         return ip;
     }
 
-    using Clock = std::chrono::high_resolution_clock;
-    using TimeUnit = std::chrono::nanoseconds;
-    static inline TimeUnit::rep now()
+    using TimeUnit = typename Clock::TimeUnit;
+    static inline typename TimeUnit::rep now() __attribute__((always_inline))
     {
-        return std::chrono::duration_cast<TimeUnit>(Clock::now().time_since_epoch()).count();
+        return Clock::now();
     }
 
 private:
     struct __attribute__((packed)) Record
     {
-        const TimeUnit::rep m_time;
+        const typename TimeUnit::rep m_time;
         const uintptr_t m_traceCallSite; /// where is trace called from?
         const uintptr_t m_traceInnerInstance; /// what templated form?
     };
@@ -118,7 +1613,7 @@ private:
     template <std::size_t... Is, TriviallyCopyable... Ts>
     struct __attribute__((packed)) RecordT<std::index_sequence<Is...>, Ts...> : Record, RecordArg<Is, Ts>...
     {
-        RecordT(const TimeUnit::rep time, uintptr_t callerLocation, uintptr_t traceLocation, const Ts... args)
+        RecordT(const typename TimeUnit::rep time, uintptr_t callerLocation, uintptr_t traceLocation, const Ts... args)
             : Record{time, callerLocation, traceLocation}, RecordArg<Is, Ts>{args}...
         {
         }
@@ -129,15 +1624,353 @@ private:
         using RecordT<std::make_index_sequence<sizeof...(Ts)>, Ts...>::RecordT;
     };
 
+    template <typename TypeInfo, typename... Ts>
+    void append(const Ts... args) __attribute__((always_inline))
+    {
+        Details::CallSite *const callSite = Details::callSiteOf<TypeInfo>();
+        // NOTE: one load of the flag, before the time stamp
+        if (!callSite->enabled()) [[unlikely]]
+        {
+            return;
+        }
+        write<TypeInfo>(args...);
+        count(callSite, args...);
+        // NOTE: the flag next to it, only for a buffer with triggers
+        if constexpr (requires { m_circularBuffer.template checkTriggers<TypeInfo>(args...); })
+        {
+            if (callSite->watched()) [[unlikely]]
+            {
+                m_circularBuffer.template checkTriggers<TypeInfo>(args...);
+            }
+        }
+    }
+    template <typename TypeInfo, typename Policy, typename... Ts>
+    void appendSampled(const Ts... args) __attribute__((always_inline))
+    {
+        Details::CallSite *const callSite = Details::callSiteOf<TypeInfo>();
+        if (!callSite->enabled()) [[unlikely]]
+        {
+            return;
+        }
+        Details::SamplingState &state = Details::samplingState(Details::callSiteId(callSite));
+        if (!Policy::admit(state))
+        {
+            ++state.suppressed;
+            return;
+        }
+        write<TypeInfo>(Details::Suppressed{std::exchange(state.suppressed, 0u)}, args...);
+        count(callSite, Details::Suppressed{}, args...);
+    }
+    template <typename TypeInfo, typename... Ts>
+    void appendFolded(const Ts... args) __attribute__((always_inline))
+    {
+        static_assert((0u + ... + sizeof(Ts)) <= Details::FoldState::argumentsSize, "Arguments too large to fold");
+        Details::CallSite *const callSite = Details::callSiteOf<TypeInfo>();
+        if (!callSite->enabled()) [[unlikely]]
+        {
+            return;
+        }
+        std::array<char, Details::FoldState::argumentsSize> arguments{};
+        std::size_t offset = 0u;
+        ((std::memcpy(arguments.data() + offset, &args, sizeof(Ts)), offset += sizeof(Ts)), ...);
+        Details::FoldState *const pending = Details::foldState(Details::callSiteId(callSite));
+        if (pending == nullptr) [[unlikely]]
+        {
+            write<TypeInfo>(args...);
+            count(callSite, args...);
+            return;
+        }
+        Details::FoldState &state = *pending;
+        if (state.owner != m_id) [[unlikely]]
+        {
+            adoptFold(*callSite, state);
+        }
+        if (state.active && state.arguments == arguments)
+        {
+            ++state.repeats;
+            state.last = static_cast<std::int64_t>(now());
+            return;
+        }
+        if (state.repeats > 0u) [[unlikely]]
+        {
+            writeRepeats(*callSite, state);
+        }
+        write<TypeInfo>(args...);
+        count(callSite, args...);
+        state.arguments = arguments;
+        state.active = true;
+    }
+    /// Ends the run of the call site in another logger, in that logger if it still exists
+    void adoptFold(Details::CallSite &callSite, Details::FoldState &state) __attribute__((noinline))
+    {
+        if (state.repeats > 0u)
+        {
+            Details::PendingOwners::with(state.owner, [&](const Details::PendingOwner &owner) { owner.writeRepeats(owner.logger, callSite, state); });
+        }
+        Details::PendingOwners::addFolds(m_id, this, [](void *logger, Details::CallSite &callSite, Details::FoldState &state) { static_cast<Logger *>(logger)->writeRepeats(callSite, state); });
+        state = {};
+        state.owner = m_id;
+    }
+    /// The record that ends a run of fold, at the address of its call site
+    void writeRepeats(Details::CallSite &callSite, Details::FoldState &state) __attribute__((noinline))
+    {
+        using TypeInfo = Details::LoggerTraceTypeInfo<Details::Format<"repeated {} more times">, std::uint64_t>;
+        Details::CallSite *const repeats = Details::callSiteOf<TypeInfo>();
+        if (repeats->enabled())
+        {
+            m_circularBuffer.append(RecordT<std::uint64_t>{static_cast<typename TimeUnit::rep>(state.last), callSite.m_traceCallSite, reinterpret_cast<uintptr_t>(&TypeInfo::tag), state.repeats});
+            count(repeats, state.repeats);
+        }
+        state.repeats = 0u;
+    }
+    template <typename TypeInfo, Details::Numeric T>
+    void appendAggregated(const T value) __attribute__((always_inline))
+    {
+        Details::CallSite *const callSite = Details::callSiteOf<TypeInfo>();
+        if (!callSite->enabled()) [[unlikely]]
+        {
+            return;
+        }
+        Details::AggregateState *const pending = Details::aggregateState(Details::callSiteId(callSite));
+        const std::int64_t time = static_cast<std::int64_t>(now());
+        if (pending == nullptr) [[unlikely]]
+        {
+            // NOTE: the thread has ended, a summary of the value alone
+            Details::AggregateState state;
+            state.first = time;
+            state.last = time;
+            state.add(value);
+            writeAggregate(*callSite, state);
+            return;
+        }
+        Details::AggregateState &state = *pending;
+        if (state.owner != m_id) [[unlikely]]
+        {
+            adoptAggregate(*callSite, state);
+        }
+        // NOTE: the summary also ends before a bucket could overflow
+        if (state.count > 0u && (time - state.first >= m_aggregationInterval.load(std::memory_order_relaxed) || state.count == std::numeric_limits<std::uint32_t>::max())) [[unlikely]]
+        {
+            writeAggregate(*callSite, state);
+            writeAggregates(time);
+        }
+        state.first = state.count == 0u ? time : state.first;
+        state.last = time;
+        state.add(value);
+    }
+    /// Ends the summary of the call site in another logger, in that logger if it still exists
+    void adoptAggregate(Details::CallSite &callSite, Details::AggregateState &state) __attribute__((noinline))
+    {
+        if (state.count > 0u)
+        {
+            Details::PendingOwners::with(state.owner, [&](const Details::PendingOwner &owner) { owner.writeAggregate(owner.logger, callSite, state); });
+        }
+        Details::PendingOwners::addAggregates(m_id, this, [](void *logger, Details::CallSite &callSite, Details::AggregateState &state) { static_cast<Logger *>(logger)->writeAggregate(callSite, state); });
+        state = {};
+        state.owner = m_id;
+    }
+    /// Writes the summaries of this logger in the calling thread whose interval ended before time
+    void writeAggregates(const std::int64_t time) __attribute__((noinline))
+    {
+        Details::PendingStates *const states = Details::PendingStates::current();
+        if (states == nullptr)
+        {
+            return;
+        }
+        const std::int64_t interval = time == std::numeric_limits<std::int64_t>::max() ? 0 : m_aggregationInterval.load(std::memory_order_relaxed);
+        for (std::size_t id = 0u; id < states->aggregates.size(); ++id)
+        {
+            Details::AggregateState *const state = states->aggregates[id].get();
+            if (state != nullptr && state->owner == m_id && state->count > 0u && (interval == 0 || time - state->first >= interval))
+            {
+                writeAggregate(Details::callSites()[id], *state);
+            }
+        }
+    }
+    /// The summary record of aggregate, at the address of its call site
+    void writeAggregate(Details::CallSite &callSite, Details::AggregateState &state) __attribute__((noinline))
+    {
+        using Summary = RecordT<std::uint64_t, double, double, double, double, double, std::uint16_t, Details::Payload<std::uint32_t>>;
+        static_assert(sizeof(Summary) + Details::AggregateState::bucketCount * sizeof(std::uint32_t) <= Buffer::bufferSize, "Summary does not fit in the buffer");
+        std::size_t first = 0u;
+        std::size_t end = state.buckets.size();
+        while (state.buckets[first] == 0u)
+        {
+            ++first;
+        }
+        while (state.buckets[end - 1u] == 0u)
+        {
+            --end;
+        }
+        // NOTE: all the non-empty buckets, the payload cap of trace does not apply
+        const std::span<const char> buckets(reinterpret_cast<const char *>(state.buckets.data() + first), (end - first) * sizeof(std::uint32_t));
+        m_circularBuffer.append(Summary{static_cast<typename TimeUnit::rep>(state.last), callSite.m_traceCallSite, callSite.m_traceInnerInstance, state.count, state.min, state.max,
+                                        state.sum / static_cast<double>(state.count), state.quantile(0.5), state.quantile(0.99), static_cast<std::uint16_t>(first),
+                                        Details::Payload<std::uint32_t>{static_cast<std::uint16_t>(end - first), false}},
+                                buckets);
+        if constexpr (requires { Buffer::countRecord(std::size_t{}, std::size_t{}); })
+        {
+            Buffer::countRecord(Details::callSiteId(&callSite), sizeof(Summary) + buckets.size());
+        }
+        state = {.owner = state.owner};
+    }
+    /// Counts the record in a buffer that keeps statistics, see Details::CountingBuffer
+    template <typename... Ts>
+    void count(const Details::CallSite *callSite, const Ts... args) __attribute__((always_inline))
+    {
+        if constexpr (requires { Buffer::countRecord(std::size_t{}, std::size_t{}); })
+        {
+            Buffer::countRecord(Details::callSiteId(callSite), (sizeof(RecordT<typename Details::Encoded<Ts>::type...>) + ... + bytesOf(args).size()));
+        }
+    }
+    template <typename TypeInfo, typename... Ts>
+    void write(const Ts... args) __attribute__((always_inline))
+    {
+        if constexpr ((BoundedPayload<Ts> || ...))
+        {
+            static_assert(sizeof(RecordT<typename Details::Encoded<Ts>::type...>) + sizeof...(Ts) * maxPayloadSize <= Buffer::bufferSize, "Record does not fit in the buffer");
+            m_circularBuffer.append(RecordT<typename Details::Encoded<Ts>::type...>{now(), instructionPointer(), reinterpret_cast<uintptr_t>(&TypeInfo::tag), encode(args)...}, bytesOf(args)...);
+        }
+        else
+        {
+            m_circularBuffer.append(RecordT<Ts...>{now(), instructionPointer(), reinterpret_cast<uintptr_t>(&TypeInfo::tag), args...});
+        }
+    }
+    /// A span record: the call site of the span, its start as the time stamp
+    template <typename TypeInfo, TriviallyCopyable... Ts>
+    void writeSpan(const typename TimeUnit::rep start, const uintptr_t callSite, const Details::CallSite *entry, const Ts... args) __attribute__((always_inline))
+    {
+        m_circularBuffer.append(RecordT<Ts...>{start, callSite, reinterpret_cast<uintptr_t>(&TypeInfo::tag), args...});
+        count(entry, args...);
+    }
+    template <typename T>
+    static auto encode(const T t) __attribute__((always_inline))
+    {
+        if constexpr (BoundedPayload<T>)
+        {
+            constexpr std::size_t maxCount = maxPayloadSize / sizeof(typename Details::View<T>::Element);
+            return typename Details::Encoded<T>::type{static_cast<std::uint16_t>(std::min(t.size(), maxCount)), t.size() > maxCount};
+        }
+        else
+        {
+            return t;
+        }
+    }
+    template <typename T>
+    static std::span<const char> bytesOf(const T t) __attribute__((always_inline))
+    {
+        if constexpr (BoundedPayload<T>)
+        {
+            using Element = typename Details::View<T>::Element;
+            return {reinterpret_cast<const char *>(t.data()), std::min(t.size(), maxPayloadSize / sizeof(Element)) * sizeof(Element)};
+        }
+        else
+        {
+            return {};
+        }
+    }
+
     // Buffer
 public:
+    /// Writes a Details::DumpHeader followed by the records
     void writeTo(std::ostream &s) const
     {
+        writeHeaderTo(s);
         m_circularBuffer.writeTo(s);
     }
+    /// Like writeTo, but consistent while other threads keep tracing
+    void snapshotTo(std::ostream &s) const
+    {
+        writeHeaderTo(s);
+        m_circularBuffer.snapshotTo(s);
+    }
+
+    Buffer &buffer()
+    {
+        return m_circularBuffer;
+    }
+
+private:
+    static std::optional<Clocks::Calibration> calibration()
+    {
+        if constexpr (requires { Clock::calibration(); })
+        {
+            return Clock::calibration();
+        }
+        return std::nullopt;
+    }
+    /// A buffer that outlives the process, such as one of a MappedStorage, keeps the calibration itself
+    template <typename... Args>
+    static Buffer makeBuffer(Args &&...args)
+    {
+        if constexpr (std::constructible_from<Buffer, Args..., std::optional<Clocks::Calibration>>)
+        {
+            return Buffer(std::forward<Args>(args)..., calibration());
+        }
+        else
+        {
+            return Buffer(std::forward<Args>(args)...);
+        }
+    }
+    void writeHeaderTo(std::ostream &s) const
+    {
+        const std::string header = Details::dumpHeader(calibration());
+        s.write(header.data(), static_cast<std::streamsize>(header.size()));
+    }
+
+    static constexpr Details::FixedString s_aggregateFormat = "{} values, min {}, max {}, mean {}, p50 <= {}, p99 <= {}, buckets from {}: {}";
+
+    Buffer m_circularBuffer;
+    const std::uint64_t m_id = Details::PendingOwners::nextId(); /// of the pending records of fold and aggregate in the threads
+    std::atomic<typename TimeUnit::rep> m_aggregationInterval{std::numeric_limits<typename TimeUnit::rep>::max()}; /// see setAggregationInterval
+};
+
+/// Scope of Logger::span, writes the record when it ends
+///
+/// NOTE: the call site and the enable flag are taken at the start, such that the call site is
+/// the same for every exit of the scope, and a disabled span does not count for the depth
+template <std::size_t sizeLog2, typename Clock, typename Buffer, std::size_t maxPayloadSize>
+template <typename TypeInfo, TriviallyCopyable... Ts>
+class [[nodiscard]] Logger<sizeLog2, Clock, Buffer, maxPayloadSize>::Span
+{
+public:
+    Span(Logger &logger, const Ts... args) __attribute__((always_inline))
+        : m_entry(Details::callSiteOf<TypeInfo>())
+        , m_logger(m_entry->enabled() ? &logger : nullptr)
+        , m_callSite(instructionPointer())
+        , m_args(args...)
+    {
+        if (m_logger != nullptr) [[likely]]
+        {
+            m_depth = Details::spanThread().depth++;
+            m_start = now();
+        }
+    }
+    ~Span() __attribute__((always_inline))
+    {
+        if (m_logger == nullptr) [[unlikely]]
+        {
+            return;
+        }
+        const auto end = now();
+        Details::SpanThread &thread = Details::spanThread();
+        --thread.depth;
+        std::apply([this, &end, &thread](const Ts... args) { m_logger->template writeSpan<TypeInfo>(m_start, m_callSite, m_entry, Details::SpanEnd{end - m_start, thread.id, m_depth}, args...); }, m_args);
+    }
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
 
 private:
-    Details::CircularBuffer<sizeLog2> m_circularBuffer;
+    Details::CallSite *const m_entry; /// of the call site section
+    Logger *const m_logger; /// null for a disabled call site
+    const uintptr_t m_callSite;
+    typename TimeUnit::rep m_start = 0;
+    std::uint16_t m_depth = 0u;
+    const std::tuple<Ts...> m_args;
 };
 
+/// Logger whose dump ends with a BlockIndex, for decoding from any offset and in parallel
+template <std::size_t sizeLog2, typename Clock = Clocks::HighResolution>
+using IndexedLogger = Logger<sizeLog2, Clock, Details::CircularBuffer<sizeLog2, true>>;
+
 #endif // LOGGER_H
@@ -0,0 +1,210 @@
+#ifndef MAPPED_LOGGER_H
+#define MAPPED_LOGGER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Logger.h"
+
+namespace Details
+{
+/// Sequence count of a writing thread in the file, odd while it copies a record, see WriterSlot
+struct alignas(64) MappedWriterSlot
+{
+    std::atomic<std::uint64_t> sequence;
+};
+
+/// Start of a file that backs a CircularBuffer, followed by the writer slots, the block offsets
+/// and the buffer
+///
+/// The file is a MAP_SHARED mapping, so after a crash the page cache still holds the latest
+/// records and LogDecoder::recover() reads them back. A LogDecoder::Collector reads the tail
+/// and then the writer slots, the records before the tail are complete once the odd slots and
+/// the writers without a slot moved on.
+struct MappedHeader
+{
+    static constexpr std::array<char, 8> expectedMagic{'M', 'i', 'n', 'L', 'o', 'g', 'R', '2'};
+    static constexpr std::size_t pageSize = 4096u;
+    static constexpr std::size_t maxWriterSlots = pageSize / sizeof(MappedWriterSlot);
+
+    std::array<char, 8> magic; /// written last, such that a half initialized file is not recognized
+    std::uint64_t writerSlotsOffset;
+    std::uint64_t writerSlotCount; /// slots of the threads with a WriterSlot::index below
+    std::uint64_t blockOffsetsOffset;
+    std::uint64_t bufferOffset;
+    std::uint64_t bufferSize;
+    std::uint64_t blockSize;
+    std::uint64_t buildIdSize;
+    std::array<unsigned char, 32> buildId; /// NT_GNU_BUILD_ID of the executable that traced
+    std::uint64_t calibrated; /// whether calibration is set
+    Clocks::Calibration calibration;
+    std::uint64_t pid; /// of the process that traced
+    alignas(64) std::atomic<std::size_t> nonModTail;
+    alignas(64) std::atomic<std::uint64_t> overflowWriters; /// in flight, of the threads without a slot
+};
+static_assert(sizeof(MappedHeader) <= MappedHeader::pageSize);
+static_assert(sizeof(std::size_t) == sizeof(std::uint64_t) && std::atomic<std::size_t>::is_always_lock_free, "The tail is shared through a file");
+
+/// Storage of a CircularBuffer in a MAP_SHARED mapping of a file
+///
+/// Tracing writes to the mapping exactly like to memory, the kernel writes the pages back
+/// whenever it sees fit. The file is recreated on construction and stays behind afterwards.
+/// It is set up under a temporary name and then renamed into place, such that a reader that
+/// still maps the previous file keeps it intact.
+template <std::size_t sizeLog2>
+class MappedStorage
+{
+public:
+    using Layout = RingLayout<sizeLog2>;
+    static constexpr std::size_t writerSlotsOffset = MappedHeader::pageSize;
+    static constexpr std::size_t blockOffsetsOffset = writerSlotsOffset + MappedHeader::pageSize;
+    static constexpr std::size_t bufferOffset = blockOffsetsOffset + (Layout::blockCount * sizeof(typename Layout::BlockOffset) + MappedHeader::pageSize - 1u) / MappedHeader::pageSize * MappedHeader::pageSize;
+    static constexpr std::size_t fileSize = bufferOffset + Layout::bufferSize;
+
+    /// The calibration of the clock goes into the header before the file appears under its path
+    explicit MappedStorage(const std::string &path, const std::optional<Clocks::Calibration> &calibration = std::nullopt)
+    {
+        // NOTE: hidden, such that a collector does not pick it up before it is complete
+        const std::size_t nameBegin = path.rfind('/') + 1u;
+        const std::string temporaryPath = path.substr(0u, nameBegin) + '.' + path.substr(nameBegin) + '.' + std::to_string(::getpid()) + ".tmp";
+        const int fd = ::open(temporaryPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open " + temporaryPath + ": " + std::strerror(errno));
+        }
+        if (::ftruncate(fd, static_cast<off_t>(fileSize)) != 0)
+        {
+            ::close(fd);
+            ::unlink(temporaryPath.c_str());
+            throw std::runtime_error("Cannot resize " + temporaryPath + ": " + std::strerror(errno));
+        }
+        // NOTE: populated up front, so tracing does not take the page faults
+        void *mapping = ::mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            ::unlink(temporaryPath.c_str());
+            throw std::runtime_error("Cannot map " + temporaryPath + ": " + std::strerror(errno));
+        }
+        m_mapping = static_cast<char *>(mapping);
+
+        m_header = new (m_mapping) MappedHeader{};
+        m_header->writerSlotsOffset = writerSlotsOffset;
+        m_header->writerSlotCount = MappedHeader::maxWriterSlots;
+        m_header->blockOffsetsOffset = blockOffsetsOffset;
+        m_header->bufferOffset = bufferOffset;
+        m_header->bufferSize = Layout::bufferSize;
+        m_header->blockSize = Layout::blockSize;
+        m_header->pid = static_cast<std::uint64_t>(::getpid());
+        const std::span<const unsigned char> id = buildId();
+        m_header->buildIdSize = std::min(id.size(), m_header->buildId.size());
+        std::copy_n(id.begin(), m_header->buildIdSize, m_header->buildId.begin());
+        if (calibration)
+        {
+            m_header->calibration = *calibration;
+            m_header->calibrated = 1u;
+        }
+        m_blockOffsets = reinterpret_cast<std::atomic<typename Layout::BlockOffset> *>(m_mapping + blockOffsetsOffset);
+        for (std::size_t block = 0u; block < Layout::blockCount; ++block)
+        {
+            new (&m_blockOffsets[block]) std::atomic<typename Layout::BlockOffset>{0u};
+        }
+        m_writerSlots = reinterpret_cast<MappedWriterSlot *>(m_mapping + writerSlotsOffset);
+        for (std::size_t slot = 0u; slot < MappedHeader::maxWriterSlots; ++slot)
+        {
+            new (&m_writerSlots[slot]) MappedWriterSlot{0u};
+        }
+        m_buffer = m_mapping + bufferOffset;
+        std::atomic_thread_fence(std::memory_order_release);
+        m_header->magic = MappedHeader::expectedMagic;
+        if (::rename(temporaryPath.c_str(), path.c_str()) != 0)
+        {
+            const int error = errno;
+            ::munmap(m_mapping, fileSize);
+            ::unlink(temporaryPath.c_str());
+            throw std::runtime_error("Cannot create " + path + ": " + std::strerror(error));
+        }
+    }
+    ~MappedStorage()
+    {
+        ::munmap(m_mapping, fileSize);
+    }
+    MappedStorage(const MappedStorage &) = delete;
+    MappedStorage &operator=(const MappedStorage &) = delete;
+
+    char *buffer() __attribute__((always_inline))
+    {
+        return m_buffer;
+    }
+    const char *buffer() const
+    {
+        return m_buffer;
+    }
+    std::atomic<std::size_t> &nonModTail() __attribute__((always_inline))
+    {
+        return m_header->nonModTail;
+    }
+    const std::atomic<std::size_t> &nonModTail() const
+    {
+        return m_header->nonModTail;
+    }
+    /// Marks the writer in flight in its slot of the file, or in the count of those without one
+    std::uint64_t beginWrite(const WriterSlot &slot) __attribute__((always_inline))
+    {
+        if (slot.index() < MappedHeader::maxWriterSlots) [[likely]]
+        {
+            std::atomic<std::uint64_t> &sequence = m_writerSlots[slot.index()].sequence;
+            const std::uint64_t next = sequence.load(std::memory_order_relaxed) + 1u;
+            // NOTE: ordered before the reservation, as WriterSlot::begin
+            sequence.store(next, std::memory_order_relaxed);
+            return next;
+        }
+        m_header->overflowWriters.fetch_add(1u, std::memory_order_relaxed);
+        return 0u;
+    }
+    void endWrite(const WriterSlot &slot, const std::uint64_t sequence) __attribute__((always_inline))
+    {
+        if (slot.index() < MappedHeader::maxWriterSlots) [[likely]]
+        {
+            m_writerSlots[slot.index()].sequence.store(sequence + 1u, std::memory_order_release);
+            return;
+        }
+        m_header->overflowWriters.fetch_sub(1u, std::memory_order_release);
+    }
+
+    std::atomic<typename Layout::BlockOffset> *blockOffsets()
+    {
+        return m_blockOffsets;
+    }
+    const std::atomic<typename Layout::BlockOffset> *blockOffsets() const
+    {
+        return m_blockOffsets;
+    }
+
+private:
+    char *m_mapping = nullptr;
+    MappedHeader *m_header = nullptr;
+    MappedWriterSlot *m_writerSlots = nullptr;
+    std::atomic<typename Layout::BlockOffset> *m_blockOffsets = nullptr;
+    char *m_buffer = nullptr;
+};
+} // namespace Details
+
+/// Logger whose buffer lives in a file, such that the latest records survive a crash
+template <std::size_t sizeLog2, typename Clock = Clocks::HighResolution>
+using MappedLogger = Logger<sizeLog2, Clock, Details::CircularBuffer<sizeLog2, false, Details::MappedStorage>>;
+
+#endif // MAPPED_LOGGER_H
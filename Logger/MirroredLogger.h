@@ -0,0 +1,112 @@
+#ifndef MIRRORED_LOGGER_H
+#define MIRRORED_LOGGER_H
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Logger.h"
+
+namespace Details
+{
+/// Storage of a CircularBuffer whose pages are mapped twice, back to back
+///
+/// A record that crosses the end of the buffer continues in the second mapping, which is
+/// the start of the buffer again. The CircularBuffer then copies every record at once and
+/// writes the buffer in one piece. The buffer must be a multiple of the page size.
+template <std::size_t sizeLog2>
+class MirroredStorage
+{
+public:
+    using Layout = RingLayout<sizeLog2>;
+    static constexpr bool mirrored = true;
+
+    MirroredStorage()
+    {
+        const long pageSize = ::sysconf(_SC_PAGESIZE);
+        if (pageSize <= 0 || Layout::bufferSize % static_cast<std::size_t>(pageSize) != 0u)
+        {
+            throw std::invalid_argument("Buffer of " + std::to_string(Layout::bufferSize) + " bytes is not a multiple of the page size");
+        }
+        const int fd = ::memfd_create("MirroredStorage", MFD_CLOEXEC);
+        if (fd < 0)
+        {
+            throw std::runtime_error(std::string("Cannot create the buffer: ") + std::strerror(errno));
+        }
+        if (::ftruncate(fd, static_cast<off_t>(Layout::bufferSize)) != 0)
+        {
+            const int error = errno;
+            ::close(fd);
+            throw std::runtime_error(std::string("Cannot resize the buffer: ") + std::strerror(error));
+        }
+        // NOTE: reserved as a whole first, such that no other mapping lands in between
+        void *reserved = ::mmap(nullptr, 2u * Layout::bufferSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved == MAP_FAILED)
+        {
+            const int error = errno;
+            ::close(fd);
+            throw std::runtime_error(std::string("Cannot reserve the buffer: ") + std::strerror(error));
+        }
+        m_buffer = static_cast<char *>(reserved);
+        for (const std::size_t offset : {std::size_t{0u}, Layout::bufferSize})
+        {
+            if (::mmap(m_buffer + offset, Layout::bufferSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED | MAP_POPULATE, fd, 0) == MAP_FAILED)
+            {
+                const int error = errno;
+                ::munmap(reserved, 2u * Layout::bufferSize);
+                ::close(fd);
+                throw std::runtime_error(std::string("Cannot map the buffer: ") + std::strerror(error));
+            }
+        }
+        ::close(fd);
+    }
+    ~MirroredStorage()
+    {
+        ::munmap(m_buffer, 2u * Layout::bufferSize);
+    }
+    MirroredStorage(const MirroredStorage &) = delete;
+    MirroredStorage &operator=(const MirroredStorage &) = delete;
+
+    char *buffer() __attribute__((always_inline))
+    {
+        return m_buffer;
+    }
+    const char *buffer() const
+    {
+        return m_buffer;
+    }
+    std::atomic<std::size_t> &nonModTail() __attribute__((always_inline))
+    {
+        return m_nonModTail;
+    }
+    const std::atomic<std::size_t> &nonModTail() const
+    {
+        return m_nonModTail;
+    }
+    std::atomic<typename Layout::BlockOffset> *blockOffsets()
+    {
+        return m_blockOffsets.data();
+    }
+    const std::atomic<typename Layout::BlockOffset> *blockOffsets() const
+    {
+        return m_blockOffsets.data();
+    }
+
+private:
+    char *m_buffer = nullptr;
+    std::atomic<std::size_t> m_nonModTail{0u};
+    std::array<std::atomic<typename Layout::BlockOffset>, Layout::blockCount> m_blockOffsets{};
+};
+} // namespace Details
+
+/// Logger that copies every record at once, also where it wraps around the end of the buffer
+template <std::size_t sizeLog2, typename Clock = Clocks::HighResolution>
+using MirroredLogger = Logger<sizeLog2, Clock, Details::CircularBuffer<sizeLog2, false, Details::MirroredStorage>>;
+
+#endif // MIRRORED_LOGGER_H
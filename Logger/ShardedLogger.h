@@ -0,0 +1,392 @@
+#ifndef SHARDED_LOGGER_H
+#define SHARDED_LOGGER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <queue>
+#include <vector>
+
+#include "Logger.h"
+
+namespace Details
+{
+/// Ring written by a single thread only, hence without any atomic read-modify-write
+///
+/// Every record is preceded by its size, such that the oldest complete record
+/// (head) can be tracked and the records can be merged by time afterwards.
+template <std::size_t sizeLog2>
+class alignas(64) ThreadBuffer
+{
+public:
+    static constexpr std::size_t bufferSize = 1 << sizeLog2;
+    using FrameSize = std::uint16_t;
+    using ThreadId = std::uint16_t;
+
+    explicit ThreadBuffer(const ThreadId threadId)
+        : m_threadId(threadId)
+    {
+    }
+
+    template <TriviallyCopyable T>
+    void append(const T t)
+    {
+        static_assert(sizeof(FrameSize) + sizeof(T) <= bufferSize, "Record does not fit in the buffer");
+        static_assert(sizeof(T) <= std::numeric_limits<FrameSize>::max(), "Record too large");
+
+        const std::size_t tail = m_nonModTail.load(std::memory_order_relaxed);
+        const std::size_t newTail = tail + sizeof(FrameSize) + sizeof(T);
+
+        // The records about to be overwritten are right behind the tail
+        const std::size_t oldHead = m_nonModHead.load(std::memory_order_relaxed);
+        std::size_t head = oldHead;
+        while (newTail - head > bufferSize)
+        {
+            head += sizeof(FrameSize) + frameSizeAt(head);
+        }
+        if (head != oldHead)
+        {
+            m_nonModHead.store(head, std::memory_order_relaxed);
+            // NOTE: a snapshot that copies the overwritten bytes must see the new head afterwards
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        struct __attribute__((packed)) Frame
+        {
+            FrameSize size;
+            T t;
+        };
+        const std::size_t modTail = tail % bufferSize;
+        if (modTail + sizeof(Frame) <= bufferSize)
+        {
+            const Frame frame{sizeof(T), t};
+            std::memcpy(&m_buffer[modTail], &frame, sizeof(Frame));
+        }
+        else
+        {
+            const Frame explicitFrame{sizeof(T), t};
+            copyIn(modTail, &explicitFrame, sizeof(Frame));
+        }
+        m_nonModTail.store(newTail, std::memory_order_release);
+    }
+
+    ThreadId threadId() const
+    {
+        return m_threadId;
+    }
+
+    /// Copy of the complete records, taken while the owning thread keeps tracing
+    struct Snapshot
+    {
+        std::unique_ptr<char[]> buffer;
+        std::size_t nonModHead;
+        std::size_t nonModTail;
+        ThreadId threadId;
+    };
+    Snapshot snapshot() const
+    {
+        const std::size_t tail = m_nonModTail.load(std::memory_order_acquire);
+        const std::size_t head = m_nonModHead.load(std::memory_order_relaxed);
+        Snapshot snapshot{std::make_unique_for_overwrite<char[]>(bufferSize), 0u, tail, m_threadId};
+        std::memcpy(snapshot.buffer.get(), m_buffer.data(), bufferSize);
+        // NOTE: the head moves before the oldest records get overwritten, so anything
+        // from the head seen after the copy onwards is intact
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const std::size_t overwritten = m_nonModHead.load(std::memory_order_relaxed);
+        snapshot.nonModHead = std::min(tail, std::max(head, overwritten));
+        return snapshot;
+    }
+
+    /// Walks the complete records in the order they were written
+    class Cursor
+    {
+    public:
+        /// Reads the buffer in place, only valid while the owning thread does not trace
+        explicit Cursor(const ThreadBuffer &buffer)
+            : m_buffer(buffer.m_buffer.data())
+            , m_position(buffer.m_nonModHead.load(std::memory_order_relaxed))
+            , m_end(buffer.m_nonModTail.load(std::memory_order_acquire))
+            , m_threadId(buffer.m_threadId)
+        {
+        }
+        explicit Cursor(const Snapshot &snapshot)
+            : m_buffer(snapshot.buffer.get())
+            , m_position(snapshot.nonModHead)
+            , m_end(snapshot.nonModTail)
+            , m_threadId(snapshot.threadId)
+        {
+        }
+
+        bool atEnd() const
+        {
+            return m_position == m_end;
+        }
+        std::int64_t time() const
+        {
+            // NOTE: every record starts with its time stamp
+            std::int64_t time;
+            copyOut(m_buffer, m_position + sizeof(FrameSize), &time, sizeof(time));
+            return time;
+        }
+        ThreadId threadId() const
+        {
+            return m_threadId;
+        }
+        void writeTo(std::ostream &s) const
+        {
+            s.write(reinterpret_cast<const char *>(&m_threadId), sizeof(m_threadId));
+            ThreadBuffer::writeTo(m_buffer, s, m_position + sizeof(FrameSize), frameSizeAt(m_buffer, m_position));
+        }
+        void next()
+        {
+            m_position += sizeof(FrameSize) + frameSizeAt(m_buffer, m_position);
+        }
+
+    private:
+        const char *m_buffer;
+        std::size_t m_position;
+        std::size_t m_end;
+        ThreadId m_threadId;
+    };
+
+private:
+    FrameSize frameSizeAt(const std::size_t nonModPosition) const
+    {
+        return frameSizeAt(m_buffer.data(), nonModPosition);
+    }
+    static FrameSize frameSizeAt(const char *buffer, const std::size_t nonModPosition)
+    {
+        FrameSize size;
+        copyOut(buffer, nonModPosition, &size, sizeof(size));
+        return size;
+    }
+    void copyIn(const std::size_t modPosition, const void *data, const std::size_t size)
+    {
+        const std::size_t firstPart = std::min(size, bufferSize - modPosition);
+        std::memcpy(&m_buffer[modPosition], data, firstPart);
+        std::memcpy(&m_buffer[0], static_cast<const char *>(data) + firstPart, size - firstPart);
+    }
+    static void copyOut(const char *buffer, const std::size_t nonModPosition, void *data, const std::size_t size)
+    {
+        const std::size_t modPosition = nonModPosition % bufferSize;
+        const std::size_t firstPart = std::min(size, bufferSize - modPosition);
+        std::memcpy(data, &buffer[modPosition], firstPart);
+        std::memcpy(static_cast<char *>(data) + firstPart, &buffer[0], size - firstPart);
+    }
+    static void writeTo(const char *buffer, std::ostream &s, const std::size_t nonModPosition, const std::size_t size)
+    {
+        const std::size_t modPosition = nonModPosition % bufferSize;
+        const std::size_t firstPart = std::min(size, bufferSize - modPosition);
+        s.write(&buffer[modPosition], static_cast<std::streamsize>(firstPart));
+        s.write(buffer, static_cast<std::streamsize>(size - firstPart));
+    }
+
+    std::atomic<std::size_t> m_nonModTail{0u};
+    std::atomic<std::size_t> m_nonModHead{0u};
+    const ThreadId m_threadId;
+    std::array<char, bufferSize> m_buffer{};
+};
+
+/// One ThreadBuffer per tracing thread, merged by time when written
+///
+/// Each record in the output is preceded by the ThreadId of the shard it was traced into. Every
+/// thread caches its shards of the last few buffers it traced into, so alternating between
+/// loggers stays on the fast path. A thread hands a shard back, records included, once it
+/// drops the shard from its cache or ends, and the next thread that registers takes it over.
+/// So there are never more shards than threads holding one at the same time, and a ThreadId
+/// names a shard rather than a thread. Records beyond the ThreadId range, or traced after
+/// the thread's registration is gone, are dropped and counted.
+template <std::size_t sizeLog2>
+class ShardedBuffer
+{
+public:
+    using Shard = ThreadBuffer<sizeLog2>;
+
+    ShardedBuffer() = default;
+    ShardedBuffer(const ShardedBuffer &) = delete;
+    ShardedBuffer &operator=(const ShardedBuffer &) = delete;
+
+    template <TriviallyCopyable T>
+    void append(const T t) __attribute__((always_inline))
+    {
+        Shard *shard = nullptr;
+        if (const auto entry = std::ranges::find(s_threadShards.entries, m_shards.get(), &ThreadShard::shards); entry != s_threadShards.entries.end()) [[likely]]
+        {
+            shard = entry->shard;
+        }
+        else
+        {
+            shard = registerThread();
+        }
+        if (shard != nullptr) [[likely]]
+        {
+            shard->append(t);
+        }
+        else
+        {
+            m_droppedCount.fetch_add(1u, std::memory_order_relaxed);
+        }
+    }
+
+    /// Records dropped because their thread did not get a shard
+    std::uint64_t droppedCount() const
+    {
+        return m_droppedCount.load(std::memory_order_relaxed);
+    }
+
+    /// Writes the shards in place, only valid while no thread traces
+    void writeTo(std::ostream &s) const
+    {
+        std::vector<Cursor> cursors;
+        {
+            const std::lock_guard lock(m_shards->mutex);
+            for (const auto &shard : m_shards->all)
+            {
+                cursors.emplace_back(*shard);
+            }
+        }
+        merge(s, std::move(cursors));
+    }
+    /// Writes a copy of every shard, consistent while other threads keep tracing
+    void snapshotTo(std::ostream &s) const
+    {
+        std::vector<typename Shard::Snapshot> snapshots;
+        {
+            const std::lock_guard lock(m_shards->mutex);
+            for (const auto &shard : m_shards->all)
+            {
+                snapshots.push_back(shard->snapshot());
+            }
+        }
+        merge(s, {snapshots.begin(), snapshots.end()});
+    }
+
+    /// Records written outside of any thread are tagged with noThread
+    static constexpr typename Shard::ThreadId noThread = std::numeric_limits<typename Shard::ThreadId>::max();
+    template <TriviallyCopyable T>
+    static void writeRecordTo(std::ostream &s, const T t)
+    {
+        s.write(reinterpret_cast<const char *>(&noThread), sizeof(noThread));
+        s.write(reinterpret_cast<const char *>(&t), sizeof(T));
+    }
+
+private:
+    using Cursor = typename Shard::Cursor;
+    static void merge(std::ostream &s, std::vector<Cursor> shards)
+    {
+        const auto later = [](const Cursor &lhs, const Cursor &rhs) {
+            const auto lhsTime = lhs.time();
+            const auto rhsTime = rhs.time();
+            return lhsTime != rhsTime ? lhsTime > rhsTime : lhs.threadId() > rhs.threadId();
+        };
+        std::erase_if(shards, [](const Cursor &cursor) { return cursor.atEnd(); });
+        std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> cursors(later, std::move(shards));
+        while (!cursors.empty())
+        {
+            Cursor cursor = cursors.top();
+            cursors.pop();
+            cursor.writeTo(s);
+            cursor.next();
+            if (!cursor.atEnd())
+            {
+                cursors.push(cursor);
+            }
+        }
+    }
+
+    /// Shards of one buffer, kept alive by the threads that hold one after the buffer is gone
+    struct Shards
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Shard>> all;
+        std::vector<Shard *> released; /// handed back by their thread, the latest is taken first
+    };
+
+    /// Shard of this thread, nullptr once every ThreadId is taken or the thread has ended
+    Shard *registerThread() __attribute__((noinline))
+    {
+        if (s_exited)
+        {
+            return nullptr;
+        }
+        static thread_local Registration registration;
+        Shard *shard = nullptr;
+        {
+            const std::lock_guard lock(m_shards->mutex);
+            if (!m_shards->released.empty())
+            {
+                shard = m_shards->released.back();
+                m_shards->released.pop_back();
+            }
+            else if (m_shards->all.size() < noThread)
+            {
+                const auto threadId = static_cast<typename Shard::ThreadId>(m_shards->all.size());
+                shard = m_shards->all.emplace_back(std::make_unique<Shard>(threadId)).get();
+            }
+        }
+        // NOTE: also caches the lack of a shard, such that dropping does not take the lock
+        const std::size_t next = s_threadShards.next;
+        registration.release(next);
+        s_threadShards.entries[next] = {m_shards.get(), shard};
+        registration.m_owners[next] = m_shards;
+        s_threadShards.next = (next + 1u) % cachedBuffers;
+        return shard;
+    }
+
+    /// Shard used by this thread, identified by the shards of its buffer, which its
+    /// Registration keeps alive such that their address is not reused
+    struct ThreadShard
+    {
+        const Shards *shards = nullptr;
+        Shard *shard = nullptr;
+    };
+    /// Buffers whose shard a thread keeps at hand, the oldest entry is replaced first
+    static constexpr std::size_t cachedBuffers = 4u;
+    struct ThreadShards
+    {
+        std::array<ThreadShard, cachedBuffers> entries{};
+        std::size_t next = 0u;
+    };
+    /// Hands the cached shards of a thread back when it ends
+    struct Registration
+    {
+        ~Registration()
+        {
+            for (std::size_t entry = 0u; entry < cachedBuffers; ++entry)
+            {
+                release(entry);
+            }
+            s_exited = true;
+        }
+        void release(const std::size_t entry)
+        {
+            if (Shard *const shard = s_threadShards.entries[entry].shard; shard != nullptr)
+            {
+                const std::lock_guard lock(m_owners[entry]->mutex);
+                m_owners[entry]->released.push_back(shard);
+            }
+            s_threadShards.entries[entry] = {};
+            m_owners[entry].reset();
+        }
+        std::array<std::shared_ptr<Shards>, cachedBuffers> m_owners; /// of s_threadShards.entries
+    };
+    // NOTE: trivially destructible, so it outlives the Registration and every other thread_local
+    static inline thread_local ThreadShards s_threadShards{};
+    static inline thread_local bool s_exited = false; /// whether the Registration is gone
+
+    const std::shared_ptr<Shards> m_shards = std::make_shared<Shards>();
+    std::atomic<std::uint64_t> m_droppedCount{0u};
+};
+} // namespace Details
+
+/// Logger without shared state on the trace path: every thread writes into its own ring
+template <std::size_t sizeLog2, typename Clock = Clocks::HighResolution>
+using ShardedLogger = Logger<sizeLog2, Clock, Details::ShardedBuffer<sizeLog2>>;
+
+#endif // SHARDED_LOGGER_H
@@ -0,0 +1,53 @@
+#ifndef SHARED_LOGGER_H
+#define SHARED_LOGGER_H
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "MappedLogger.h"
+
+namespace Details
+{
+/// Where the rings of SharedLoggers live, the POSIX shared memory of Linux
+constexpr std::string_view s_sharedRingDirectory = "/dev/shm";
+/// File name prefix of every shared ring, followed by the pid and the name of the logger
+constexpr std::string_view s_sharedRingPrefix = "MinimalLogging.";
+
+/// Storage of a CircularBuffer in POSIX shared memory, e.g. /dev/shm/MinimalLogging.1234.frontend
+///
+/// A MappedStorage whose pages never reach a disk. The file stays behind when the process
+/// exits, a LogDecoder::Collector removes it once it has collected the last records.
+template <std::size_t sizeLog2>
+class SharedStorage : public MappedStorage<sizeLog2>
+{
+public:
+    /// The name tells the loggers of a process apart
+    explicit SharedStorage(const std::string &name, const std::optional<Clocks::Calibration> &calibration = std::nullopt)
+        : MappedStorage<sizeLog2>(path(name), calibration)
+    {
+    }
+
+private:
+    static std::string path(const std::string &name)
+    {
+        if (name.empty() || name.find('/') != std::string::npos)
+        {
+            throw std::invalid_argument("Not a file name: " + name);
+        }
+        return std::string(s_sharedRingDirectory) + '/' + std::string(s_sharedRingPrefix) + std::to_string(::getpid()) + '.' + name;
+    }
+};
+} // namespace Details
+
+/// Logger whose buffer a collector on the same host reads while the process runs, see LogDecoder::Collector
+///
+/// Tracing costs the same as with Logger, the collector copies the records without a
+/// syscall or any other interaction with the process.
+template <std::size_t sizeLog2, typename Clock = Clocks::HighResolution>
+using SharedLogger = Logger<sizeLog2, Clock, Details::CircularBuffer<sizeLog2, false, Details::SharedStorage>>;
+
+#endif // SHARED_LOGGER_H
@@ -0,0 +1,245 @@
+#ifndef STREAMING_LOGGER_H
+#define STREAMING_LOGGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Logger.h"
+
+namespace Details
+{
+/// What a StreamingBuffer does when the flusher falls a full buffer behind
+enum class Overflow
+{
+    Overwrite, /// tracing never waits, the oldest records that were not flushed yet are lost
+    Drop, /// the records that do not fit anymore are lost, at the cost of a compare-and-swap
+};
+
+/// CircularBuffer that a background thread drains into a file
+///
+/// The flusher copies the complete records into an aligned staging area, as large as the
+/// buffer, and writes it out in large O_DIRECT writes, falling back to buffered writes on file systems without
+/// O_DIRECT. Tracing never blocks: when the flusher falls behind, records get lost according
+/// to the Overflow policy and lostBytes() counts them. The file starts with the header of a
+/// dump, padded to a whole block, as for writeTo, and the buffer keeps the latest records for writeTo.
+template <std::size_t sizeLog2, Overflow overflow = Overflow::Overwrite>
+class StreamingBuffer
+{
+public:
+    using Ring = CircularBuffer<sizeLog2>;
+    static constexpr std::size_t bufferSize = Ring::bufferSize;
+    /// Alignment of the writes, as required by O_DIRECT
+    static constexpr std::size_t alignment = 4096u;
+    /// Minimal size of a write, smaller amounts wait for the next round
+    static constexpr std::size_t writeSize = std::clamp<std::size_t>(bufferSize / 4u, alignment, 1u << 20);
+
+    explicit StreamingBuffer(const std::string &path, const std::chrono::microseconds interval = std::chrono::milliseconds(1))
+        : m_staging(static_cast<char *>(std::aligned_alloc(alignment, bufferSize + writeSize)), &std::free)
+        , m_interval(interval)
+    {
+        m_file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_DIRECT, 0644);
+        if (m_file < 0 && errno == EINVAL)
+        {
+            m_file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        }
+        if (m_file < 0)
+        {
+            throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+        }
+    }
+    ~StreamingBuffer()
+    {
+        stop();
+    }
+    StreamingBuffer(const StreamingBuffer &) = delete;
+    StreamingBuffer &operator=(const StreamingBuffer &) = delete;
+
+    template <TriviallyCopyable T, std::same_as<std::span<const char>>... Parts>
+    void append(const T t, const Parts... parts) __attribute__((always_inline))
+    {
+        if constexpr (overflow == Overflow::Overwrite)
+        {
+            m_ring.append(t, parts...);
+        }
+        else if (!m_ring.tryAppend(t, m_drained.load(std::memory_order_acquire) + bufferSize, parts...)) [[unlikely]]
+        {
+            m_lostBytes.fetch_add((sizeof(T) + ... + parts.size()), std::memory_order_relaxed);
+        }
+    }
+
+    /// Flushes the records traced so far and closes the file, later records only reach the
+    /// buffer (as far as the Overflow policy allows)
+    void stop()
+    {
+        if (m_file < 0)
+        {
+            return;
+        }
+        if (m_flusher.joinable())
+        {
+            m_flusher.request_stop();
+            m_flusher.join();
+        }
+        drain();
+
+        // NOTE: O_DIRECT only writes whole blocks, the padding is cut off again, as far as it
+        // made it into the file
+        const std::size_t paddedSize = (m_staged + alignment - 1u) / alignment * alignment;
+        std::memset(m_staging.get() + m_staged, 0, paddedSize - m_staged);
+        const std::uint64_t end = m_writtenBytes + m_staged;
+        write(m_staging.get(), paddedSize);
+        if (m_writtenBytes > end && ::ftruncate(m_file, static_cast<off_t>(end)) == 0)
+        {
+            m_writtenBytes = end;
+        }
+        ::close(m_file);
+        m_file = -1;
+    }
+
+    /// Starts the file with a Details::DumpHeader and then starts the flusher, Logger calls it
+    /// on construction
+    void writeHeader(const std::optional<Clocks::Calibration> &calibration)
+    {
+        if (m_flusher.joinable())
+        {
+            throw std::runtime_error("Header written after the first records");
+        }
+        const std::string header = dumpHeader(calibration, alignment);
+        const std::unique_ptr<char, decltype(&std::free)> aligned(static_cast<char *>(std::aligned_alloc(alignment, header.size())), &std::free);
+        std::memcpy(aligned.get(), header.data(), header.size());
+        write(aligned.get(), header.size());
+        m_flusher = std::jthread([this](const std::stop_token stop) {
+            while (!stop.stop_requested())
+            {
+                if (!drain())
+                {
+                    std::this_thread::sleep_for(m_interval);
+                }
+            }
+        });
+    }
+
+    /// Bytes of records that did not make it into the file
+    std::uint64_t lostBytes() const
+    {
+        return m_lostBytes.load(std::memory_order_relaxed);
+    }
+    /// Bytes in the file so far
+    std::uint64_t writtenBytes() const
+    {
+        return m_writtenBytes.load(std::memory_order_relaxed);
+    }
+    /// Bytes reserved in the ring so far
+    std::size_t reserved() const
+    {
+        return m_ring.reserved();
+    }
+
+    void writeTo(std::ostream &s) const
+    {
+        m_ring.writeTo(s);
+    }
+    void snapshotTo(std::ostream &s) const
+    {
+        m_ring.snapshotTo(s);
+    }
+    template <typename Stream>
+    std::size_t writeLiveTo(Stream &s) const
+    {
+        return m_ring.writeLiveTo(s);
+    }
+    template <TriviallyCopyable T>
+    static void writeRecordTo(std::ostream &s, const T t)
+    {
+        Ring::writeRecordTo(s, t);
+    }
+
+private:
+    /// Copies the complete records into the staging area and writes out the aligned part of it,
+    /// false if there was too little to write
+    ///
+    /// The staging area holds a whole buffer, such that the copy starts and ends at a record
+    /// and losing the oldest records never tears one in two.
+    bool drain()
+    {
+        const std::size_t end = m_ring.committed();
+        const std::size_t begin = m_drained.load(std::memory_order_relaxed);
+        if (begin == end)
+        {
+            return false;
+        }
+        // NOTE: every committed position is a record boundary, unless a whole buffer was lost
+        const std::size_t copyBegin = std::max(begin, end - std::min(end, bufferSize));
+        char *staging = m_staging.get() + m_staged;
+        const std::size_t valid = m_ring.copyTo(staging, copyBegin, end, copyBegin == begin);
+        if (valid != begin) [[unlikely]]
+        {
+            // Overwritten before it got here, continue at the first record still intact
+            m_lostBytes.fetch_add(valid - begin, std::memory_order_relaxed);
+            std::memmove(staging, staging + (valid - copyBegin), end - valid);
+        }
+        m_staged += end - valid;
+        m_drained.store(end, std::memory_order_release);
+
+        if (m_staged < writeSize)
+        {
+            return false;
+        }
+        const std::size_t alignedSize = m_staged / alignment * alignment;
+        write(m_staging.get(), alignedSize);
+        m_staged -= alignedSize;
+        std::memcpy(m_staging.get(), m_staging.get() + alignedSize, m_staged);
+        return true;
+    }
+    void write(const char *data, const std::size_t size)
+    {
+        for (std::size_t done = 0u; done < size;)
+        {
+            const ssize_t written = ::pwrite(m_file, data + done, size - done, static_cast<off_t>(m_writtenBytes));
+            if (written <= 0)
+            {
+                if (written < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                m_lostBytes.fetch_add(size - done, std::memory_order_relaxed);
+                return;
+            }
+            done += static_cast<std::size_t>(written);
+            m_writtenBytes += static_cast<std::size_t>(written);
+        }
+    }
+
+    Ring m_ring;
+    alignas(64) std::atomic<std::size_t> m_drained{0u}; /// non-modulo position up to which the flusher copied
+    std::atomic<std::uint64_t> m_lostBytes{0u};
+    std::unique_ptr<char, decltype(&std::free)> m_staging;
+    std::size_t m_staged = 0u;
+    std::atomic<std::uint64_t> m_writtenBytes{0u};
+    const std::chrono::microseconds m_interval; /// of the flusher, while idle
+    int m_file = -1;
+    std::jthread m_flusher; /// from writeHeader on
+};
+} // namespace Details
+
+/// Logger that also streams all records into a file, rather than only keeping the latest ones
+template <std::size_t sizeLog2, typename Clock = Clocks::HighResolution, Details::Overflow overflow = Details::Overflow::Overwrite>
+using StreamingLogger = Logger<sizeLog2, Clock, Details::StreamingBuffer<sizeLog2, overflow>>;
+
+#endif // STREAMING_LOGGER_H
@@ -0,0 +1,259 @@
+#ifndef TRIGGERED_LOGGER_H
+#define TRIGGERED_LOGGER_H
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "Logger.h"
+
+namespace Details
+{
+/// Distinct address for each argument pack of a TriggeredBuffer predicate
+template <typename... Ts>
+inline constexpr char s_triggerArguments = 0;
+
+/// Pair of CircularBuffers, of which a trigger freezes the active one for a background thread to persist
+///
+/// Writers trace into the active ring. A trigger, a Logger::trigger call or a trace that
+/// satisfies a predicate of triggerWhen, swaps the spare ring in and hands the frozen one to
+/// the persister, which writes it as a dump into <path>.<n> and then clears it to be the next
+/// spare. The active ring and whether the spare is frozen share one atomic word, so the swap is
+/// a single compare-and-swap on the triggering thread and tracing never waits. A writer picks
+/// the ring only after it began its WriterSlot, such that the persister either sees it in
+/// flight or the writer sees the swap. The barrier in between is asymmetric: writers only keep
+/// the compiler from reordering, and the persister makes every thread of the process execute
+/// a full barrier with membarrier(2), which thus must be supported. Triggers within minInterval of the previous one, or
+/// while the previous snapshot is still being written, are refused and counted. writeTo
+/// writes the active ring, the records since the last trigger.
+template <std::size_t sizeLog2>
+class TriggeredBuffer
+{
+public:
+    using Ring = CircularBuffer<sizeLog2>;
+    static constexpr std::size_t bufferSize = Ring::bufferSize;
+    /// Predicates that triggerWhen takes at most
+    static constexpr std::size_t maxTriggers = 16u;
+
+    explicit TriggeredBuffer(const std::string &path, const std::chrono::nanoseconds minInterval = std::chrono::seconds(1),
+                             const std::chrono::microseconds interval = std::chrono::milliseconds(1))
+        : m_path(path)
+        , m_minInterval(minInterval.count())
+    {
+        registerBarrier();
+        m_persister = std::jthread([this, interval](const std::stop_token stop) {
+            while (!stop.stop_requested())
+            {
+                if (!persist())
+                {
+                    std::this_thread::sleep_for(interval);
+                }
+            }
+            // NOTE: a trigger right before the destruction still gets written
+            persist();
+        });
+    }
+    TriggeredBuffer(const TriggeredBuffer &) = delete;
+    TriggeredBuffer &operator=(const TriggeredBuffer &) = delete;
+
+    template <TriviallyCopyable T, std::same_as<std::span<const char>>... Parts>
+    void append(const T t, const Parts... parts) __attribute__((always_inline))
+    {
+        WriterSlot &slot = WriterSlot::current();
+        const std::uint64_t sequence = slot.begin();
+        // NOTE: orders the slot before the load of the state for the compiler only, the membarrier
+        // in persist orders them for the processor
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        active(m_state.load(std::memory_order_relaxed)).appendInSlot(slot, t, parts...);
+        slot.end(sequence);
+    }
+
+    /// Freezes the records so far for the persister, false if refused
+    bool trigger()
+    {
+        const std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        std::uint8_t state = m_state.load(std::memory_order_relaxed);
+        // NOTE: a failed exchange means that another trigger or the persister came first
+        if (now - m_lastTrigger.load(std::memory_order_relaxed) < m_minInterval || (state & frozenBit) != 0 ||
+            !m_state.compare_exchange_strong(state, static_cast<std::uint8_t>((state ^ activeBit) | frozenBit)))
+        {
+            m_refusedCount.fetch_add(1u, std::memory_order_relaxed);
+            return false;
+        }
+        m_lastTrigger.store(now, std::memory_order_relaxed);
+        return true;
+    }
+    /// Triggers once a trace(Ts...) passes arguments that satisfy the predicate, e.g.
+    /// triggerWhen<int>([](int latency) { return latency > 1000; })
+    ///
+    /// Only the call sites of that type check the predicate, after writing their record,
+    /// all others keep the fast path. Predicates stay for the lifetime of the buffer.
+    template <typename... Ts, std::predicate<const Ts &...> Predicate>
+    void triggerWhen(Predicate predicate)
+    {
+        addTrigger<LoggerTraceTypeInfo<typename Encoded<Ts>::type...>, Ts...>(std::move(predicate));
+    }
+    /// Like triggerWhen, for trace<format>(Ts...)
+    template <FixedString format, typename... Ts, std::predicate<const Ts &...> Predicate>
+    void triggerWhen(Predicate predicate)
+    {
+        addTrigger<LoggerTraceTypeInfo<Format<format>, typename Encoded<Ts>::type...>, Ts...>(std::move(predicate));
+    }
+    /// Called by Logger for the call sites that triggerWhen watches
+    template <typename TypeInfo, typename... Ts>
+    void checkTriggers(const Ts... args)
+    {
+        const std::tuple<Ts...> arguments(args...);
+        const std::size_t count = m_triggerCount.load(std::memory_order_acquire);
+        for (std::size_t i = 0u; i < count; ++i)
+        {
+            const Trigger &trigger = m_triggers[i];
+            if (trigger.tag == reinterpret_cast<uintptr_t>(&TypeInfo::tag) && trigger.arguments == &s_triggerArguments<Ts...> && trigger.predicate(&arguments))
+            {
+                this->trigger();
+                return;
+            }
+        }
+    }
+
+    /// Keeps the header for the dump of every snapshot
+    void writeHeader(const std::optional<Clocks::Calibration> &calibration)
+    {
+        m_header = dumpHeader(calibration);
+    }
+
+    /// Snapshots in files so far, <path>.0 up to <path>.<persistedCount() - 1>
+    std::uint64_t persistedCount() const
+    {
+        return m_persistedCount.load(std::memory_order_acquire);
+    }
+    /// Triggers that were rate limited or came while a snapshot was still being written
+    std::uint64_t refusedCount() const
+    {
+        return m_refusedCount.load(std::memory_order_relaxed);
+    }
+    /// Snapshots that could not be written
+    std::uint64_t failedCount() const
+    {
+        return m_failedCount.load(std::memory_order_relaxed);
+    }
+
+    void writeTo(std::ostream &s) const
+    {
+        m_rings[m_state.load(std::memory_order_acquire) & activeBit].writeTo(s);
+    }
+    void snapshotTo(std::ostream &s) const
+    {
+        m_rings[m_state.load(std::memory_order_acquire) & activeBit].snapshotTo(s);
+    }
+
+private:
+    struct Trigger
+    {
+        uintptr_t tag; /// of the watched call sites
+        const char *arguments; /// s_triggerArguments of the argument types of the predicate
+        std::function<bool(const void *arguments)> predicate; /// of a std::tuple of the arguments
+    };
+
+    template <typename TypeInfo, typename... Ts, typename Predicate>
+    void addTrigger(Predicate predicate)
+    {
+        const std::lock_guard lock(m_triggerMutex);
+        const std::size_t count = m_triggerCount.load(std::memory_order_relaxed);
+        if (count == maxTriggers)
+        {
+            throw std::runtime_error("Too many triggers");
+        }
+        const auto tag = reinterpret_cast<uintptr_t>(&TypeInfo::tag);
+        m_triggers[count] = {tag, &s_triggerArguments<Ts...>, [predicate = std::move(predicate)](const void *arguments) {
+                                 return std::apply(predicate, *static_cast<const std::tuple<Ts...> *>(arguments));
+                             }};
+        m_triggerCount.store(count + 1u, std::memory_order_release);
+        for (CallSite &callSite : callSites())
+        {
+            if (callSite.m_traceInnerInstance == tag)
+            {
+                callSite.setWatched(true);
+            }
+        }
+    }
+    /// Allows the expedited membarrier of persist, once per process
+    static void registerBarrier()
+    {
+        static const int error = ::syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0 ? 0 : errno;
+        if (error != 0)
+        {
+            throw std::runtime_error(std::string("Cannot register membarrier: ") + std::strerror(error));
+        }
+    }
+    Ring &active(const std::uint8_t state) __attribute__((always_inline))
+    {
+        return m_rings[state & activeBit];
+    }
+    /// Writes the frozen ring once the writers moved on, false if there is none
+    bool persist()
+    {
+        const std::uint8_t state = m_state.load(std::memory_order_acquire);
+        if ((state & frozenBit) == 0)
+        {
+            return false;
+        }
+        // NOTE: a full barrier in every thread, after which every writer that may still pick the
+        // frozen ring is in flight, and snapshotTo and clear wait for those
+        ::syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+        Ring *const frozen = &m_rings[(state & activeBit) ^ activeBit];
+        const std::uint64_t index = m_persistedCount.load(std::memory_order_relaxed) + m_failedCount.load(std::memory_order_relaxed);
+        std::ofstream file(m_path + "." + std::to_string(index), std::ios::binary);
+        file.write(m_header.data(), static_cast<std::streamsize>(m_header.size()));
+        frozen->snapshotTo(file);
+        file.close();
+        (file ? m_persistedCount : m_failedCount).fetch_add(1u, std::memory_order_release);
+        frozen->clear();
+        // NOTE: triggers leave a frozen state alone, so only the persister clears the bit
+        m_state.store(static_cast<std::uint8_t>(state & activeBit), std::memory_order_release);
+        return true;
+    }
+
+    static constexpr std::uint8_t activeBit = 1u; /// index of the active ring
+    static constexpr std::uint8_t frozenBit = 2u; /// the other ring, until the persister cleared it
+
+    std::array<Ring, 2> m_rings;
+    alignas(64) std::atomic<std::uint8_t> m_state{0u};
+    std::atomic<std::int64_t> m_lastTrigger{std::numeric_limits<std::int64_t>::min() / 2}; /// steady clock nanoseconds
+    std::atomic<std::uint64_t> m_refusedCount{0u};
+    const std::string m_path;
+    const std::int64_t m_minInterval; /// nanoseconds
+    std::string m_header;
+    std::mutex m_triggerMutex;
+    std::array<Trigger, maxTriggers> m_triggers;
+    std::atomic<std::size_t> m_triggerCount{0u};
+    std::atomic<std::uint64_t> m_persistedCount{0u};
+    std::atomic<std::uint64_t> m_failedCount{0u};
+    std::jthread m_persister;
+};
+} // namespace Details
+
+/// Logger that persists the records so far in a file whenever a trigger fires, as a flight recorder
+template <std::size_t sizeLog2, typename Clock = Clocks::HighResolution>
+using TriggeredLogger = Logger<sizeLog2, Clock, Details::TriggeredBuffer<sizeLog2>>;
+
+#endif // TRIGGERED_LOGGER_H
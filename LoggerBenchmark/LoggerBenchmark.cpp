@@ -0,0 +1,743 @@
+#include "LoggerBenchmark.h"
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <QTest>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../LogDecoder/Collector.h"
+#include "../LogDecoder/Compression.h"
+#include "../LogDecoder/LogDecoder.h"
+#include "../LogDecoder/MappedFile.h"
+#include "../LogDecoder/Store.h"
+#include "../LogDecoder/SymbolIndex.h"
+#include "../Logger/CompactLogger.h"
+#include "../Logger/CountingLogger.h"
+#include "../Logger/Logger.h"
+#include "../Logger/ShardedLogger.h"
+#include "../Logger/SharedLogger.h"
+#include "../Logger/StreamingLogger.h"
+#include "../Logger/TriggeredLogger.h"
+
+namespace
+{
+constexpr int s_tracesPerThread = 1'000'000;
+
+template <typename Logger>
+void traceConcurrently(Logger &logger, const int threadCount)
+{
+    std::vector<std::jthread> threads;
+    threads.reserve(static_cast<std::size_t>(threadCount));
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&logger, t] {
+            for (int i = 0; i < s_tracesPerThread; ++i)
+            {
+                logger.trace(t, i);
+            }
+        });
+    }
+}
+
+/// Store of 2 GiB in segments of 64 MiB, from rounds of traces of which every 16th ends with a marker
+struct BenchmarkStore
+{
+    static constexpr int roundCount = 64;
+
+    BenchmarkStore()
+    {
+        std::filesystem::remove_all(directory);
+        LogDecoder::SymbolIndex symbols("/proc/self/exe");
+        std::unique_ptr<LogDecoder::StoreWriter> writer;
+        for (int round = 0; round < roundCount; ++round)
+        {
+            const auto logger = std::make_unique<Logger<26u>>();
+            traceConcurrently(*logger, 1);
+            if (round % 16 == 0)
+            {
+                logger->trace<"round {}">(round);
+            }
+            std::ostringstream stream;
+            logger->writeTo(stream);
+            const std::string data = stream.str();
+            LogDecoder::Decoder decoder(data, symbols);
+            if (!writer)
+            {
+                writer = std::make_unique<LogDecoder::StoreWriter>(directory.string(), decoder.header(), std::uint64_t{4u} << 30);
+            }
+            LogDecoder::Record record;
+            while (decoder.nextAny(record))
+            {
+                writer->write(record);
+                if (record.type->format == "round {}")
+                {
+                    marker = record.address;
+                }
+            }
+        }
+        writer->finish();
+        storedBytes = writer->storedBytes();
+    }
+    ~BenchmarkStore()
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "LoggerBenchmark.store";
+    std::uintptr_t marker = 0u;
+    std::uint64_t storedBytes = 0u;
+};
+} // namespace
+
+// NOTE: every thread traces the same amount, so perfect scaling means a constant time per row
+void LoggerBenchmark::threadScaling_data()
+{
+    QTest::addColumn<bool>("sharded");
+    QTest::addColumn<int>("threadCount");
+    const int maxThreadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (const bool sharded : {false, true})
+    {
+        for (int threadCount = 1; threadCount < maxThreadCount; threadCount *= 2)
+        {
+            QTest::addRow("%s, %d threads", sharded ? "sharded" : "single buffer", threadCount) << sharded << threadCount;
+        }
+        QTest::addRow("%s, %d threads", sharded ? "sharded" : "single buffer", maxThreadCount) << sharded << maxThreadCount;
+    }
+}
+
+void LoggerBenchmark::threadScaling()
+{
+    QFETCH(bool, sharded);
+    QFETCH(int, threadCount);
+    if (sharded)
+    {
+        const auto logger = std::make_unique<ShardedLogger<20u>>();
+        QBENCHMARK
+        {
+            traceConcurrently(*logger, threadCount);
+        }
+    }
+    else
+    {
+        const auto logger = std::make_unique<Logger<20u>>();
+        QBENCHMARK
+        {
+            traceConcurrently(*logger, threadCount);
+        }
+    }
+}
+
+void LoggerBenchmark::recordHeader_data()
+{
+    QTest::addColumn<bool>("compact");
+    QTest::newRow("24 byte header") << false;
+    QTest::newRow("6 byte header") << true;
+}
+
+void LoggerBenchmark::recordHeader()
+{
+    QFETCH(bool, compact);
+    if (compact)
+    {
+        const auto logger = std::make_unique<CompactLogger<20u>>();
+        QBENCHMARK
+        {
+            traceConcurrently(*logger, 1);
+        }
+    }
+    else
+    {
+        const auto logger = std::make_unique<Logger<20u>>();
+        QBENCHMARK
+        {
+            traceConcurrently(*logger, 1);
+        }
+    }
+}
+
+void LoggerBenchmark::decodeThroughput()
+{
+    const auto logger = std::make_unique<Logger<26u>>();
+    traceConcurrently(*logger, 1);
+    std::ostringstream stream;
+    logger->writeTo(stream);
+    const std::string data = stream.str();
+
+    LogDecoder::SymbolIndex symbols("/proc/self/exe");
+    std::size_t recordCount = 0u;
+    const auto start = std::chrono::steady_clock::now();
+    QBENCHMARK
+    {
+        LogDecoder::Decoder decoder(data, symbols);
+        LogDecoder::Record record;
+        while (decoder.next(record))
+        {
+            ++recordCount;
+        }
+    }
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    qDebug() << "Records/s:" << static_cast<double>(recordCount) / duration.count();
+}
+
+// NOTE: the ratio against the raw dump, then the decompression throughput in bytes of the raw dump
+void LoggerBenchmark::segmentCompression()
+{
+    const auto logger = std::make_unique<Logger<26u>>();
+    traceConcurrently(*logger, 1);
+    std::ostringstream stream;
+    logger->writeTo(stream);
+    const std::string data = stream.str();
+
+    LogDecoder::SymbolIndex symbols("/proc/self/exe");
+    std::ostringstream compressed;
+    LogDecoder::SegmentWriter segments(compressed);
+    const auto compressStart = std::chrono::steady_clock::now();
+    LogDecoder::Decoder decoder(data, symbols);
+    segments.writeDumpHeader(decoder.header());
+    LogDecoder::Record record;
+    while (decoder.nextAny(record))
+    {
+        segments.write(record);
+    }
+    segments.finish();
+    const std::chrono::duration<double> compressDuration = std::chrono::steady_clock::now() - compressStart;
+    qDebug() << "Raw bytes:" << segments.plainBytes() << "compressed bytes:" << segments.writtenBytes()
+             << "ratio:" << static_cast<double>(segments.plainBytes()) / static_cast<double>(segments.writtenBytes())
+             << "compression GB/s:" << static_cast<double>(segments.plainBytes()) / compressDuration.count() / 1e9;
+
+    const std::string segmentData = compressed.str();
+    std::string records;
+    records.reserve(data.size());
+    std::size_t decompressedBytes = 0u;
+    const auto start = std::chrono::steady_clock::now();
+    QBENCHMARK
+    {
+        records.clear();
+        LogDecoder::decompress(segmentData, records);
+        decompressedBytes += records.size();
+    }
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    QVERIFY(records == data);
+    qDebug() << "Decompression GB/s:" << static_cast<double>(decompressedBytes) / duration.count() / 1e9;
+}
+
+void LoggerBenchmark::streamingThroughput_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::newRow("in memory") << 0;
+    QTest::newRow("streaming, overwrite") << 1;
+    QTest::newRow("streaming, drop") << 2;
+}
+
+// NOTE: the throughput of the producers, the lost bytes tell whether the disk kept up
+void LoggerBenchmark::streamingThroughput()
+{
+    QFETCH(int, mode);
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "LoggerBenchmark.stream";
+    const auto measure = [](auto &logger) {
+        std::size_t traceCount = 0u;
+        const auto start = std::chrono::steady_clock::now();
+        QBENCHMARK
+        {
+            traceConcurrently(logger, 1);
+            traceCount += s_tracesPerThread;
+        }
+        const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+        constexpr std::size_t recordSize = sizeof(std::int64_t) + 2 * sizeof(uintptr_t) + 2 * sizeof(int);
+        qDebug() << "GB/s:" << static_cast<double>(traceCount * recordSize) / duration.count() / 1e9;
+    };
+    switch (mode)
+    {
+    case 0:
+    {
+        const auto logger = std::make_unique<Logger<24u>>();
+        measure(*logger);
+        break;
+    }
+    case 1:
+    {
+        const auto logger = std::make_unique<StreamingLogger<24u>>(path.string());
+        measure(*logger);
+        logger->buffer().stop();
+        qDebug() << "Written bytes:" << logger->buffer().writtenBytes() << "lost bytes:" << logger->buffer().lostBytes();
+        break;
+    }
+    case 2:
+    {
+        const auto logger = std::make_unique<StreamingLogger<24u, Clocks::HighResolution, Details::Overflow::Drop>>(path.string());
+        measure(*logger);
+        logger->buffer().stop();
+        qDebug() << "Written bytes:" << logger->buffer().writtenBytes() << "lost bytes:" << logger->buffer().lostBytes();
+        break;
+    }
+    }
+    std::filesystem::remove(path);
+}
+
+void LoggerBenchmark::payloadCost_data()
+{
+    QTest::addColumn<int>("payloadSize");
+    QTest::newRow("fixed size") << -1;
+    for (const int payloadSize : {0, 8, 32, 128, 256})
+    {
+        QTest::addRow("%d byte payload", payloadSize) << payloadSize;
+    }
+}
+
+// NOTE: the difference with the fixed size row divided by the payload size is the cost per byte
+void LoggerBenchmark::payloadCost()
+{
+    QFETCH(int, payloadSize);
+    const auto logger = std::make_unique<Logger<20u>>();
+    const std::string payload(static_cast<std::size_t>(std::max(payloadSize, 0)), 'x');
+    std::size_t traceCount = 0u;
+    const auto start = std::chrono::steady_clock::now();
+    QBENCHMARK
+    {
+        for (int i = 0; i < s_tracesPerThread; ++i)
+        {
+            if (payloadSize < 0)
+            {
+                logger->trace(i);
+            }
+            else
+            {
+                logger->trace(std::string_view(payload), i);
+            }
+        }
+        traceCount += s_tracesPerThread;
+    }
+    const std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+    qDebug() << "ns/trace:" << duration.count() / static_cast<double>(traceCount);
+}
+
+void LoggerBenchmark::samplingCost_data()
+{
+    QTest::addColumn<int>("policy");
+    QTest::newRow("trace") << 0;
+    QTest::newRow("OneIn<64>") << 1;
+    QTest::newRow("FirstThenEvery<16, 64>") << 2;
+    QTest::newRow("RateLimit<100000>") << 3;
+}
+
+// NOTE: the trace row is the unsampled fast path, which sampling leaves untouched
+void LoggerBenchmark::samplingCost()
+{
+    QFETCH(int, policy);
+    const auto logger = std::make_unique<Logger<20u>>();
+    std::size_t traceCount = 0u;
+    const auto start = std::chrono::steady_clock::now();
+    QBENCHMARK
+    {
+        for (int i = 0; i < s_tracesPerThread; ++i)
+        {
+            switch (policy)
+            {
+            case 0:
+                logger->trace(i);
+                break;
+            case 1:
+                logger->sample<Sampling::OneIn<64u>>(i);
+                break;
+            case 2:
+                logger->sample<Sampling::FirstThenEvery<16u, 64u>>(i);
+                break;
+            case 3:
+                logger->sample<Sampling::RateLimit<100'000u>>(i);
+                break;
+            }
+        }
+        traceCount += s_tracesPerThread;
+    }
+    const std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+    qDebug() << "ns/trace:" << duration.count() / static_cast<double>(traceCount);
+}
+
+void LoggerBenchmark::countingCost_data()
+{
+    QTest::addColumn<int>("threadCount");
+    QTest::addColumn<bool>("counting");
+    for (const int threadCount : {1, 4})
+    {
+        for (const bool counting : {false, true})
+        {
+            QTest::addRow("%s, %d threads", counting ? "CountingLogger" : "Logger", threadCount) << threadCount << counting;
+        }
+    }
+}
+
+// NOTE: the difference between the rows of the same thread count is the cost of the counters
+void LoggerBenchmark::countingCost()
+{
+    QFETCH(int, threadCount);
+    QFETCH(bool, counting);
+    const auto measure = [threadCount](auto &logger) {
+        std::size_t traceCount = 0u;
+        const auto start = std::chrono::steady_clock::now();
+        QBENCHMARK
+        {
+            traceConcurrently(logger, threadCount);
+            traceCount += static_cast<std::size_t>(threadCount) * s_tracesPerThread;
+        }
+        const std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+        qDebug() << "ns/trace:" << duration.count() / static_cast<double>(traceCount);
+    };
+    if (counting)
+    {
+        const auto logger = std::make_unique<CountingLogger<20u>>();
+        measure(*logger);
+        qDebug() << "Noisiest call site bytes:" << logger->buffer().callSiteCounts().front().bytes;
+    }
+    else
+    {
+        const auto logger = std::make_unique<Logger<20u>>();
+        measure(*logger);
+    }
+}
+
+void LoggerBenchmark::foldedHistory_data()
+{
+    QTest::addColumn<int>("workload");
+    QTest::addColumn<bool>("folded");
+    for (const bool folded : {false, true})
+    {
+        QTest::addRow("distinct, %s", folded ? "fold" : "trace") << 0 << folded;
+        QTest::addRow("retry loop, runs of 100, %s", folded ? "fold" : "trace") << 1 << folded;
+        QTest::addRow("two polled call sites, runs of 1000, %s", folded ? "fold" : "trace") << 2 << folded;
+    }
+}
+
+// NOTE: the traces that the buffer holds at the end, the repeats of the folded records included
+void LoggerBenchmark::foldedHistory()
+{
+    QFETCH(int, workload);
+    QFETCH(bool, folded);
+    const auto logger = std::make_unique<Logger<20u>>();
+    const auto trace = [&logger, folded](const int value) __attribute__((always_inline)) {
+        if (folded)
+        {
+            logger->fold(value);
+        }
+        else
+        {
+            logger->trace(value);
+        }
+    };
+    std::size_t traceCount = 0u;
+    const auto start = std::chrono::steady_clock::now();
+    QBENCHMARK
+    {
+        for (int i = 0; i < s_tracesPerThread; ++i)
+        {
+            switch (workload)
+            {
+            case 0:
+                trace(i);
+                break;
+            case 1:
+                trace(i / 100);
+                break;
+            case 2:
+                if (i % 2 == 0)
+                {
+                    trace(i / 2000);
+                }
+                else if (folded)
+                {
+                    logger->fold<"status {}">(i / 2000);
+                }
+                else
+                {
+                    logger->trace<"status {}">(i / 2000);
+                }
+                break;
+            }
+        }
+        traceCount += s_tracesPerThread;
+    }
+    const std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+    logger->flushRepeats();
+
+    std::ostringstream stream;
+    logger->writeTo(stream);
+    const std::string data = stream.str();
+    LogDecoder::SymbolIndex symbols("/proc/self/exe");
+    LogDecoder::Decoder decoder(data, symbols);
+    std::uint64_t recordCount = 0u;
+    std::uint64_t heldCount = 0u;
+    LogDecoder::Record record;
+    while (decoder.next(record))
+    {
+        ++recordCount;
+        heldCount += record.type->format == "repeated {} more times" ? record.argument<std::uint64_t>(0u) : 1u;
+    }
+    qDebug() << "ns/trace:" << duration.count() / static_cast<double>(traceCount) << "records:" << recordCount << "traces held:" << heldCount;
+}
+
+void LoggerBenchmark::aggregatedValues_data()
+{
+    QTest::addColumn<bool>("aggregated");
+    QTest::addColumn<int>("intervalMicroseconds");
+    QTest::addRow("trace") << false << 0;
+    QTest::addRow("aggregate, a summary per 100 us") << true << 100;
+    QTest::addRow("aggregate, a summary per 10 ms") << true << 10000;
+}
+
+// NOTE: the bytes that the values take in the buffer, the summaries of the aggregates included
+void LoggerBenchmark::aggregatedValues()
+{
+    QFETCH(bool, aggregated);
+    QFETCH(int, intervalMicroseconds);
+    const auto logger = std::make_unique<Logger<20u>>();
+    logger->setAggregationInterval(std::chrono::microseconds(intervalMicroseconds));
+    std::size_t valueCount = 0u;
+    const auto start = std::chrono::steady_clock::now();
+    QBENCHMARK
+    {
+        for (int i = 0; i < s_tracesPerThread; ++i)
+        {
+            if (aggregated)
+            {
+                logger->aggregate<"queue depth">(i % 1000);
+            }
+            else
+            {
+                logger->trace<"queue depth {}">(i % 1000);
+            }
+        }
+        valueCount += s_tracesPerThread;
+    }
+    const std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+    logger->flushAggregates();
+    const double bytes = static_cast<double>(logger->buffer().reserved());
+    qDebug() << "ns/trace:" << duration.count() / static_cast<double>(valueCount) << "bytes/value:" << bytes / static_cast<double>(valueCount);
+}
+
+void LoggerBenchmark::triggeredSnapshots_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::newRow("Logger") << 0;
+    QTest::newRow("TriggeredLogger") << 1;
+    QTest::newRow("TriggeredLogger, trigger every 64Ki traces") << 2;
+}
+
+// NOTE: the slowest trigger is the pause of the thread that hit it, persisting happens aside
+void LoggerBenchmark::triggeredSnapshots()
+{
+    QFETCH(int, mode);
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "LoggerBenchmark.trigger";
+    const auto measure = [mode](auto &logger) {
+        std::size_t traceCount = 0u;
+        std::chrono::nanoseconds slowestTrigger{0};
+        const auto start = std::chrono::steady_clock::now();
+        QBENCHMARK
+        {
+            for (int i = 0; i < s_tracesPerThread; ++i)
+            {
+                if constexpr (requires { logger.trigger(i); })
+                {
+                    if (mode == 2 && i % 65536 == 0)
+                    {
+                        const auto before = std::chrono::steady_clock::now();
+                        logger.trigger(i);
+                        slowestTrigger = std::max(slowestTrigger, std::chrono::steady_clock::now() - before);
+                        continue;
+                    }
+                }
+                logger.trace(i);
+            }
+            traceCount += s_tracesPerThread;
+        }
+        const std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+        qDebug() << "ns/trace:" << duration.count() / static_cast<double>(traceCount) << "slowest trigger ns:" << slowestTrigger.count();
+    };
+    if (mode == 0)
+    {
+        const auto logger = std::make_unique<Logger<20u>>();
+        measure(*logger);
+        return;
+    }
+    const auto logger = std::make_unique<TriggeredLogger<20u>>(path.string(), std::chrono::nanoseconds(0));
+    measure(*logger);
+    qDebug() << "Persisted:" << logger->buffer().persistedCount() << "refused:" << logger->buffer().refusedCount();
+    for (std::uint64_t i = 0u; i < logger->buffer().persistedCount(); ++i)
+    {
+        std::filesystem::remove(path.string() + "." + std::to_string(i));
+    }
+}
+
+void LoggerBenchmark::storeQuery_data()
+{
+    QTest::addColumn<bool>("indexed");
+    QTest::addColumn<bool>("callSite");
+    QTest::newRow("time range, index") << true << false;
+    QTest::newRow("time range, linear scan") << false << false;
+    QTest::newRow("call site, bloom filters") << true << true;
+    QTest::newRow("call site, linear scan") << false << true;
+}
+
+// NOTE: the time range is 1% of a segment in the middle of the store, the call site is the
+// marker in a few of the segments
+void LoggerBenchmark::storeQuery()
+{
+    QFETCH(bool, indexed);
+    QFETCH(bool, callSite);
+    static const BenchmarkStore store;
+    const LogDecoder::StoreReader reader(store.directory.string());
+    LogDecoder::SymbolIndex symbols("/proc/self/exe");
+    const LogDecoder::StoreSegment &middle = reader.segments().at(reader.segments().size() / 2u);
+    LogDecoder::StoreQuery query;
+    if (callSite)
+    {
+        query.address = store.marker;
+    }
+    else
+    {
+        query.from = middle.footer.firstTime + (middle.footer.lastTime - middle.footer.firstTime) / 2;
+        query.to = query.from + (middle.footer.lastTime - middle.footer.firstTime) / 100;
+    }
+    const auto scan = [&reader, &symbols, &query] {
+        std::uint64_t recordCount = 0u;
+        for (const LogDecoder::StoreSegment &segment : reader.segments())
+        {
+            const LogDecoder::MappedFile file(segment.path);
+            LogDecoder::Decoder decoder(file.data().first(segment.footer.recordsEnd), symbols);
+            LogDecoder::Record record;
+            while (decoder.next(record))
+            {
+                recordCount += record.time >= query.from && record.time <= query.to && (!query.address || record.address == *query.address) ? 1u : 0u;
+            }
+        }
+        return recordCount;
+    };
+
+    std::uint64_t recordCount = 0u;
+    std::size_t queryCount = 0u;
+    const auto start = std::chrono::steady_clock::now();
+    QBENCHMARK
+    {
+        recordCount = indexed ? reader.query(query, symbols, [](const LogDecoder::Record &) {}) : scan();
+        ++queryCount;
+    }
+    const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    QCOMPARE(recordCount, scan());
+    qDebug() << "Store bytes:" << store.storedBytes << "segments:" << reader.segments().size() << "records:" << recordCount
+             << "ms/query:" << duration.count() / static_cast<double>(queryCount);
+}
+
+void LoggerBenchmark::sharedProcesses_data()
+{
+    QTest::addColumn<bool>("collecting");
+    QTest::addColumn<int>("processCount");
+    for (const bool collecting : {false, true})
+    {
+        for (const int processCount : {1, 4, 16})
+        {
+            QTest::addRow("%d processes, %s", processCount, collecting ? "collected" : "not collected") << collecting << processCount;
+        }
+    }
+}
+
+// NOTE: every process traces the same amount, the difference between the collected and the
+// uncollected rows is the slowdown of the producers that the collector causes
+void LoggerBenchmark::sharedProcesses()
+{
+    QFETCH(bool, collecting);
+    QFETCH(int, processCount);
+    int results[2];
+    QVERIFY(::pipe(results) == 0);
+
+    LogDecoder::Collector collector;
+    std::uint64_t collectedBytes = 0u;
+    std::uint64_t lostBytes = 0u;
+    const LogDecoder::Collector::Sink sink = [&](const LogDecoder::SharedRing &, const std::span<const char> records, const std::uint64_t lost) {
+        collectedBytes += records.size();
+        lostBytes += lost;
+    };
+    int pollCount = 0;
+    double collectorSeconds = 0.0;
+    QBENCHMARK_ONCE
+    {
+        std::vector<pid_t> children;
+        for (int p = 0; p < processCount; ++p)
+        {
+            const pid_t child = ::fork();
+            if (child == 0)
+            {
+                double nanoseconds = 0.0;
+                {
+                    const auto logger = std::make_unique<SharedLogger<20u>>("LoggerBenchmark");
+                    const auto start = std::chrono::steady_clock::now();
+                    for (int i = 0; i < s_tracesPerThread; ++i)
+                    {
+                        logger->trace(p, i);
+                    }
+                    nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                }
+                const bool written = ::write(results[1], &nanoseconds, sizeof(nanoseconds)) == sizeof(nanoseconds);
+                // NOTE: skips the destructors of the parent's objects
+                ::_exit(written ? 0 : 1);
+            }
+            children.push_back(child);
+        }
+
+        // NOTE: started after forking, a child only inherits the forking thread
+        std::atomic<bool> tracing = true;
+        std::jthread poller;
+        if (collecting)
+        {
+            poller = std::jthread([&] {
+                while (tracing.load(std::memory_order_relaxed))
+                {
+                    collector.poll(sink);
+                    ++pollCount;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                timespec cpuTime;
+                ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime);
+                collectorSeconds = static_cast<double>(cpuTime.tv_sec) + static_cast<double>(cpuTime.tv_nsec) / 1e9;
+            });
+        }
+        for (const pid_t child : children)
+        {
+            int status = 0;
+            ::waitpid(child, &status, 0);
+        }
+        tracing = false;
+    }
+    ::close(results[1]);
+
+    double totalNanoseconds = 0.0;
+    int reportCount = 0;
+    double nanoseconds = 0.0;
+    while (::read(results[0], &nanoseconds, sizeof(nanoseconds)) == sizeof(nanoseconds))
+    {
+        totalNanoseconds += nanoseconds;
+        ++reportCount;
+    }
+    ::close(results[0]);
+    QCOMPARE(reportCount, processCount);
+    qDebug() << "ns/trace:" << totalNanoseconds / reportCount / s_tracesPerThread;
+
+    // NOTE: also collects what the producers left behind and removes their rings
+    collector.poll(sink);
+    QCOMPARE(collector.ringCount(), std::size_t(0u));
+    if (collecting)
+    {
+        qDebug() << "polls:" << pollCount << "collector CPU s:" << collectorSeconds << "collected bytes:" << collectedBytes << "lost bytes:" << lostBytes;
+    }
+}
+
+QTEST_APPLESS_MAIN(LoggerBenchmark)
@@ -0,0 +1,48 @@
+#ifndef LOGGER_BENCHMARK_H
+#define LOGGER_BENCHMARK_H
+
+#include <QObject>
+
+class LoggerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void threadScaling_data();
+    void threadScaling();
+
+    void recordHeader_data();
+    void recordHeader();
+
+    void decodeThroughput();
+    void segmentCompression();
+
+    void streamingThroughput_data();
+    void streamingThroughput();
+
+    void payloadCost_data();
+    void payloadCost();
+
+    void samplingCost_data();
+    void samplingCost();
+
+    void countingCost_data();
+    void countingCost();
+
+    void foldedHistory_data();
+    void foldedHistory();
+
+    void aggregatedValues_data();
+    void aggregatedValues();
+
+    void triggeredSnapshots_data();
+    void triggeredSnapshots();
+
+    void storeQuery_data();
+    void storeQuery();
+
+    void sharedProcesses_data();
+    void sharedProcesses();
+};
+
+#endif // LOGGER_BENCHMARK_H
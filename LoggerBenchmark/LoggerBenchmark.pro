@@ -0,0 +1,21 @@
+QT = core testlib
+
+include("../GlobalSettings.pri")
+
+HEADERS += LoggerBenchmark.h
+SOURCES += LoggerBenchmark.cpp
+
+CONFIG += release
+DEFINES += ARM
+HEADERS += ../Logger/CompactLogger.h
+HEADERS += ../Logger/CountingLogger.h
+HEADERS += ../Logger/CrashHandler.h
+HEADERS += ../Logger/Logger.h
+HEADERS += ../Logger/MappedLogger.h
+HEADERS += ../Logger/MirroredLogger.h
+HEADERS += ../Logger/ShardedLogger.h
+HEADERS += ../Logger/SharedLogger.h
+HEADERS += ../Logger/StreamingLogger.h
+HEADERS += ../Logger/TriggeredLogger.h
+
+include("../LogDecoder/LogDecoder.pri")
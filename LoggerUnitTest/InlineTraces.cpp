@@ -0,0 +1,11 @@
+#include "InlineTraces.h"
+
+void traceInlineElsewhere(const int value)
+{
+    traceInline(value);
+}
+
+void traceInlineCompactElsewhere(const int value)
+{
+    traceInlineCompact(value);
+}
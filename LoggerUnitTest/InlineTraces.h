@@ -0,0 +1,34 @@
+#ifndef INLINE_TRACES_H
+#define INLINE_TRACES_H
+
+#include "../Logger/CompactLogger.h"
+#include "../Logger/Logger.h"
+
+/// Header code that traces, of which every translation unit that calls it gets a copy
+///
+/// The linker keeps one copy only, and with it only the call site entries of that copy.
+inline Logger<10u> &inlineLogger()
+{
+    static Logger<10u> logger;
+    return logger;
+}
+inline void traceInline(const int value) __attribute__((noinline))
+{
+    inlineLogger().trace(value);
+}
+
+inline CompactLogger<10u> &inlineCompactLogger()
+{
+    static CompactLogger<10u> logger;
+    return logger;
+}
+inline void traceInlineCompact(const int value) __attribute__((noinline))
+{
+    inlineCompactLogger().trace(value);
+}
+
+/// Call traceInline and traceInlineCompact from another translation unit
+void traceInlineElsewhere(int value);
+void traceInlineCompactElsewhere(int value);
+
+#endif // INLINE_TRACES_H
@@ -1,13 +1,43 @@
 #include "LoggerUnitTest.h"
 
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
 #include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include <QTest>
 
-// NOTE: LogModel is out of scope and not included in this repository
-#include "../Private/LogModel.h"
+#include "../LogDecoder/CallSiteControl.h"
+#include "../LogDecoder/Collector.h"
+#include "../LogDecoder/Compression.h"
+#include "../LogDecoder/LogDecoder.h"
+#include "../LogDecoder/LogModel.h"
+#include "../LogDecoder/MappedFile.h"
+#include "../LogDecoder/Recovery.h"
+#include "../LogDecoder/SpanStatistics.h"
+#include "../LogDecoder/Store.h"
+#include "../LogDecoder/SymbolIndex.h"
+#include "../LogDecoder/TraceEvents.h"
 
+#include "../Logger/CompactLogger.h"
+#include "../Logger/CountingLogger.h"
+#include "../Logger/CrashHandler.h"
 #include "../Logger/Logger.h"
+#include "../Logger/MappedLogger.h"
+#include "../Logger/MirroredLogger.h"
+#include "../Logger/SharedLogger.h"
+#include "../Logger/ShardedLogger.h"
+#include "../Logger/StreamingLogger.h"
+#include "../Logger/TriggeredLogger.h"
+#include "InlineTraces.h"
 
 namespace QTest
 {
@@ -22,6 +52,8 @@ bool qCompare(const std::string &t1, const char *t2, const char *actual, const c
 
 } // namespace QTest
 
+using LogDecoder::LogModel;
+
 const std::string LoggerUnitTest::s_symbolFilePath{"LoggerUnitTest.syms"};
 
 namespace {
@@ -32,6 +64,13 @@ std::string serialize(const Logger &logger)
     logger.writeTo(stream);
     return stream.str();
 }
+/// Of the Details::DumpHeader that starts a dump, with its type table
+std::size_t dumpHeaderSize(const std::string &data)
+{
+    Details::DumpHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    return header.size;
+}
 }
 
 void unsupportedTestImpl(auto logger)
@@ -105,7 +144,7 @@ void resolveFunctionSingleImpl()
 
         // Serialize
         const std::string data = serialize(logger);
-        QCOMPARE(data.size(), sizeof(typename Logger::TimeUnit::rep) + sizeof(uintptr_t) + sizeof(uintptr_t));
+        QCOMPARE(data.size(), dumpHeaderSize(data) + sizeof(typename Logger::TimeUnit::rep) + sizeof(uintptr_t) + sizeof(uintptr_t));
 
         // Check output
         try
@@ -156,7 +195,7 @@ void resolveFunctionsNestedImpl()
 
         // Serialize
         const std::string data = serialize(test.logger);
-        QCOMPARE(data.size(), 3*(sizeof(typename Logger::TimeUnit::rep) + sizeof(uintptr_t) + sizeof(uintptr_t)));
+        QCOMPARE(data.size(), dumpHeaderSize(data) + 3*(sizeof(typename Logger::TimeUnit::rep) + sizeof(uintptr_t) + sizeof(uintptr_t)));
 
         // Check output
         try
@@ -450,4 +489,2138 @@ void LoggerUnitTest::traceMulti()
     traceMultiImpl<Logger<6u>>();
 }
 
+namespace
+{
+struct ShardedRecord
+{
+    std::uint16_t threadId;
+    std::int64_t time;
+};
+std::vector<ShardedRecord> shardedRecords(const std::string &data, const std::size_t recordSize)
+{
+    std::vector<ShardedRecord> records;
+    for (std::size_t offset = 0u; offset + recordSize <= data.size(); offset += recordSize)
+    {
+        ShardedRecord record;
+        std::memcpy(&record.threadId, &data[offset], sizeof(record.threadId));
+        std::memcpy(&record.time, &data[offset + sizeof(record.threadId)], sizeof(record.time));
+        records.push_back(record);
+    }
+    return records;
+}
+} // namespace
+
+template <typename Logger>
+void traceShardedImpl()
+{
+    if constexpr (requires(Logger l) { l.trace(); })
+    {
+        // Test
+        Logger logger;
+        logger.trace();
+        std::thread([&logger] {
+            logger.trace();
+            logger.trace();
+        }).join();
+        logger.trace();
+
+        // Serialize
+        const std::string dump = serialize(logger);
+        const std::string data = dump.substr(dumpHeaderSize(dump));
+        constexpr std::size_t recordSize = sizeof(std::uint16_t) + sizeof(typename Logger::TimeUnit::rep) + sizeof(uintptr_t) + sizeof(uintptr_t);
+        QCOMPARE(data.size(), 4 * recordSize);
+
+        // Check output: merged by time, tagged with the thread
+        const std::vector<ShardedRecord> records = shardedRecords(data, recordSize);
+        QCOMPARE(records.size(), 4u);
+        QCOMPARE(records.at(0).threadId, std::uint16_t{0u});
+        QCOMPARE(records.at(1).threadId, std::uint16_t{1u});
+        QCOMPARE(records.at(2).threadId, std::uint16_t{1u});
+        QCOMPARE(records.at(3).threadId, std::uint16_t{0u});
+        QVERIFY(std::ranges::is_sorted(records, {}, &ShardedRecord::time));
+
+        // Test: alternating with other loggers, each keeps its own shard of the thread
+        std::array<Logger, 5> others;
+        for (int i = 0; i < 2; ++i)
+        {
+            for (Logger &other : others)
+            {
+                other.trace();
+                logger.trace();
+            }
+        }
+
+        // Check output
+        for (Logger &other : others)
+        {
+            const std::string otherDump = serialize(other);
+            const std::vector<ShardedRecord> otherRecords = shardedRecords(otherDump.substr(dumpHeaderSize(otherDump)), recordSize);
+            QCOMPARE(otherRecords.size(), 2u);
+            QCOMPARE(otherRecords.at(0).threadId, std::uint16_t{0u});
+            QCOMPARE(otherRecords.at(1).threadId, std::uint16_t{0u});
+            QCOMPARE(other.buffer().droppedCount(), 0u);
+        }
+
+        // Test: a thread after the first one ended takes over its shard
+        std::thread([&logger] { logger.trace(); }).join();
+
+        // Check output
+        const std::string reusedDump = serialize(logger);
+        const std::vector<ShardedRecord> reusedRecords = shardedRecords(reusedDump.substr(dumpHeaderSize(reusedDump)), recordSize);
+        QVERIFY(std::ranges::all_of(reusedRecords, [](const ShardedRecord &record) { return record.threadId <= 1u; }));
+        QCOMPARE(reusedRecords.back().threadId, std::uint16_t{1u});
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::traceSharded()
+{
+    traceShardedImpl<ShardedLogger<8u>>();
+}
+
+template <typename Logger>
+void traceShardedWrappedImpl()
+{
+    if constexpr (requires(Logger l) { l.template trace<int>({}); })
+    {
+        // Test: only the last two complete records fit
+        Logger logger;
+        for (int i = 0; i < 7; ++i)
+        {
+            logger.trace(i);
+        }
+
+        // Serialize
+        const std::string dump = serialize(logger);
+        const std::string data = dump.substr(dumpHeaderSize(dump));
+        constexpr std::size_t recordSize = sizeof(std::uint16_t) + sizeof(typename Logger::TimeUnit::rep) + sizeof(uintptr_t) + sizeof(uintptr_t) + sizeof(int);
+        QCOMPARE(data.size(), 2 * recordSize);
+
+        // Check output
+        int first;
+        std::memcpy(&first, &data[recordSize - sizeof(int)], sizeof(int));
+        QCOMPARE(first, 5);
+        int second;
+        std::memcpy(&second, &data[2 * recordSize - sizeof(int)], sizeof(int));
+        QCOMPARE(second, 6);
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::traceShardedWrapped()
+{
+    traceShardedWrappedImpl<ShardedLogger<6u>>();
+}
+
+template <typename Logger>
+void cycleCounterCalibrationImpl()
+{
+    if constexpr (requires(Logger l) { l.trace(); })
+    {
+        // Test
+        Logger logger;
+        logger.trace();
+        QTest::qWait(100);
+        logger.trace();
+
+        // Serialize
+        const std::string data = serialize(logger);
+        constexpr std::size_t headerSize = sizeof(typename Logger::TimeUnit::rep) + sizeof(uintptr_t) + sizeof(uintptr_t);
+        QCOMPARE(data.size(), dumpHeaderSize(data) + 2 * headerSize);
+
+        // Check output: the dump header holds the calibration
+        Details::DumpHeader dumpHeader;
+        std::memcpy(&dumpHeader, data.data(), sizeof(dumpHeader));
+        QVERIFY(dumpHeader.calibrated);
+        const Clocks::Calibration calibration = dumpHeader.calibration;
+        QVERIFY(calibration.ticksPerSecond > 0.0);
+        typename Logger::TimeUnit::rep before;
+        std::memcpy(&before, &data[dumpHeader.size], sizeof(before));
+        typename Logger::TimeUnit::rep after;
+        std::memcpy(&after, &data[dumpHeader.size + headerSize], sizeof(after));
+        QVERIFY(before < after);
+        QVERIFY(after <= calibration.anchorTicks);
+
+        const double duration = static_cast<double>(after - before) / calibration.ticksPerSecond;
+        qDebug() << "Duration:" << duration;
+        QVERIFY(duration >= 0.1);
+        QVERIFY(duration < 1.0);
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::cycleCounterCalibration()
+{
+    cycleCounterCalibrationImpl<Logger<7u, Clocks::CycleCounter>>();
+}
+
+template <typename Logger>
+void compactHeaderImpl()
+{
+    if constexpr (requires(Logger l) { l.template trace<int>({}); })
+    {
+        // Test
+        Logger logger;
+        logger.trace();
+        logger.trace(42);
+
+        // Serialize
+        const std::string data = serialize(logger);
+
+        // Check output: call site table
+        std::uint64_t callSiteCount;
+        std::memcpy(&callSiteCount, data.data(), sizeof(callSiteCount));
+        QCOMPARE(callSiteCount, Details::callSites().size());
+        std::size_t offset = sizeof(callSiteCount) + callSiteCount * sizeof(Details::CallSite);
+
+        // Check output: anchor, two records of 6 byte header, anchor
+        constexpr std::size_t headerSize = sizeof(std::uint16_t) + sizeof(std::uint32_t);
+        QCOMPARE(data.size(), offset + (headerSize + sizeof(Details::TimeAnchor)) + headerSize + (headerSize + sizeof(int)) + (headerSize + sizeof(Details::TimeAnchor)));
+        const auto typeInfoAt = [&data, &offset] {
+            std::uint16_t callSiteId;
+            std::memcpy(&callSiteId, &data[offset], sizeof(callSiteId));
+            return Details::callSites()[callSiteId].m_traceInnerInstance;
+        };
+        QCOMPARE(typeInfoAt(), reinterpret_cast<uintptr_t>(&Details::LoggerTraceTypeInfo<Details::TimeAnchor>::tag));
+        offset += headerSize + sizeof(Details::TimeAnchor);
+        QCOMPARE(typeInfoAt(), reinterpret_cast<uintptr_t>(&Details::LoggerTraceTypeInfo<>::tag));
+        offset += headerSize;
+        QCOMPARE(typeInfoAt(), reinterpret_cast<uintptr_t>(&Details::LoggerTraceTypeInfo<int>::tag));
+        int arg;
+        std::memcpy(&arg, &data[offset + headerSize], sizeof(arg));
+        QCOMPARE(arg, 42);
+        offset += headerSize + sizeof(int);
+        QCOMPARE(typeInfoAt(), reinterpret_cast<uintptr_t>(&Details::LoggerTraceTypeInfo<Details::TimeAnchor>::tag));
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::compactHeader()
+{
+    compactHeaderImpl<CompactLogger<7u>>();
+}
+
+namespace
+{
+/// Clock that only moves when told to
+struct ManualClock
+{
+    using TimeUnit = std::chrono::nanoseconds;
+    static inline TimeUnit::rep s_now = 0;
+    static TimeUnit::rep now()
+    {
+        return s_now;
+    }
+};
+} // namespace
+
+template <typename Logger>
+void compactWrappedPeriodsImpl()
+{
+    if constexpr (requires(Logger l) { l.template trace<int>({}); })
+    {
+        // Test: wraps within one period, of which the anchor gets overwritten, then idles for
+        // several periods
+        constexpr std::int64_t period = std::int64_t{1} << 31;
+        const std::int64_t start = 10 * period + 5;
+        ManualClock::s_now = start;
+        Logger logger;
+        constexpr int traceCount = 1000;
+        for (int i = 0; i < traceCount; ++i)
+        {
+            logger.trace(i);
+        }
+        ManualClock::s_now = start + 5 * period;
+        logger.trace(traceCount);
+
+        // Serialize
+        const std::string data = serialize(logger);
+
+        // Check output: the records in front of the new period keep theirs
+        try
+        {
+            const LogModel model(std::istringstream{data}, LoggerUnitTest::s_symbolFilePath, LogDecoder::Format::Compact16);
+            const std::vector<LogModel::Record> &records = model.records();
+            QVERIFY(records.size() > 100u);
+            for (std::size_t i = 0u; i + 1u < records.size(); ++i)
+            {
+                QCOMPARE(std::any_cast<int>(records.at(i).args.at(0)), traceCount - static_cast<int>(records.size() - 1u - i));
+                QCOMPARE(records.at(i).time, start);
+            }
+            QCOMPARE(std::any_cast<int>(records.back().args.at(0)), traceCount);
+            QCOMPARE(records.back().time, start + 5 * period);
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::compactWrappedPeriods()
+{
+    compactWrappedPeriodsImpl<CompactLogger<11u, ManualClock>>();
+}
+
+template <typename Logger>
+void decodeFormatImpl(const LogDecoder::Format format)
+{
+    if constexpr (requires(Logger l) { l.template trace<bool, int, float>({}, {}, {}); })
+    {
+        // Test program
+        ResolveFunctionTestClass<Logger> test;
+        test.first();
+        std::thread([&test] { test.logger.trace(true, 42, 3.14159f); }).join();
+
+        // Serialize
+        const std::string data = serialize(test.logger);
+
+        // Check output
+        try
+        {
+            const LogModel model(std::istringstream{data}, LoggerUnitTest::s_symbolFilePath, format);
+            const std::vector<LogModel::Record> &records = model.records();
+            QCOMPARE(records.size(), 4u);
+            QCONTAINS(model.resolveFunction(records.at(0).address), "::first");
+            QCONTAINS(model.resolveFunction(records.at(1).address), "::second");
+            QCONTAINS(model.resolveFunction(records.at(2).address), "::first");
+            QCONTAINS(model.resolveFunction(records.at(3).address), "decodeFormatImpl");
+            QVERIFY(std::ranges::is_sorted(records, {}, &LogModel::Record::time));
+
+            const LogModel::Record last = records.at(3);
+            QCOMPARE(last.args.size(), 3u);
+            QCOMPARE(std::any_cast<bool>(last.args.at(0)), true);
+            QCOMPARE(std::any_cast<int>(last.args.at(1)), 42);
+            QCOMPARE(std::any_cast<float>(last.args.at(2)), 3.14159f);
+            if (format == LogDecoder::Format::Sharded)
+            {
+                QCOMPARE(records.at(0).threadId, std::uint16_t{0u});
+                QCOMPARE(last.threadId, std::uint16_t{1u});
+            }
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::decodeFormats_data()
+{
+    QTest::addColumn<int>("logger");
+    QTest::newRow("Logger") << 0;
+    QTest::newRow("Logger with CycleCounter") << 1;
+    QTest::newRow("ShardedLogger") << 2;
+    QTest::newRow("CompactLogger") << 3;
+    QTest::newRow("CompactLogger with 32-bit ids") << 4;
+}
+void LoggerUnitTest::decodeFormats()
+{
+    QFETCH(int, logger);
+    switch (logger)
+    {
+    case 0:
+        decodeFormatImpl<Logger<8u>>(LogDecoder::Format::Plain);
+        break;
+    case 1:
+        decodeFormatImpl<Logger<8u, Clocks::CycleCounter>>(LogDecoder::Format::Plain);
+        break;
+    case 2:
+        decodeFormatImpl<ShardedLogger<8u>>(LogDecoder::Format::Sharded);
+        break;
+    case 3:
+        decodeFormatImpl<CompactLogger<8u>>(LogDecoder::Format::Compact16);
+        break;
+    case 4:
+        decodeFormatImpl<CompactLogger<8u, Clocks::CycleCounter, std::uint32_t>>(LogDecoder::Format::Compact32);
+        break;
+    }
+}
+
+template <typename Logger>
+void traceFormattedImpl(const LogDecoder::Format format)
+{
+    if constexpr (requires(Logger l) { l.template trace<"{} of {}", int, int>({}, {}); })
+    {
+        // Test program
+        Logger logger;
+        logger.template trace<"cache miss">();
+        logger.template trace<"{} of {}, {{escaped}}">(3, 4u);
+        logger.template trace<"cache miss">();
+        logger.trace(5);
+
+        // Serialize
+        const std::string data = serialize(logger);
+
+        // Check output: same messages share their tag, unformatted traces are unaffected
+        try
+        {
+            const LogModel model(std::istringstream{data}, LoggerUnitTest::s_symbolFilePath, format);
+            const std::vector<LogModel::Record> &records = model.records();
+            QCOMPARE(records.size(), 4u);
+            QCOMPARE(records.at(0).message, "cache miss");
+            QVERIFY(records.at(0).args.empty());
+            QCOMPARE(records.at(1).message, "3 of 4, {escaped}");
+            QCOMPARE(std::any_cast<unsigned int>(records.at(1).args.at(1)), 4u);
+            QCOMPARE(records.at(2).message, "cache miss");
+            QCOMPARE(records.at(3).message, "");
+            QCOMPARE(std::any_cast<int>(records.at(3).args.at(0)), 5);
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::traceFormatted_data()
+{
+    QTest::addColumn<int>("logger");
+    QTest::newRow("Logger") << 0;
+    QTest::newRow("ShardedLogger") << 1;
+    QTest::newRow("CompactLogger") << 2;
+}
+void LoggerUnitTest::traceFormatted()
+{
+    QFETCH(int, logger);
+    switch (logger)
+    {
+    case 0:
+        traceFormattedImpl<Logger<8u>>(LogDecoder::Format::Plain);
+        break;
+    case 1:
+        traceFormattedImpl<ShardedLogger<8u>>(LogDecoder::Format::Sharded);
+        break;
+    case 2:
+        traceFormattedImpl<CompactLogger<8u>>(LogDecoder::Format::Compact16);
+        break;
+    }
+}
+
+template <typename Logger>
+void tracePayloadsImpl(const LogDecoder::Format format)
+{
+    if constexpr (requires(Logger l) { l.trace(std::string_view{}, std::span<const float>{}, 0); })
+    {
+        // Test program: payloads of all lengths wrap around the buffer many times
+        Logger logger;
+        const std::string characters = "0123456789abcdefghijklmnopqrstuvwxyz";
+        constexpr int traceCount = 200;
+        for (int i = 0; i < traceCount; ++i)
+        {
+            logger.trace(std::string_view(characters).substr(0u, static_cast<std::size_t>(i) % 20u), i);
+        }
+        const std::array<float, 3> samples{1.5f, 2.5f, 3.5f};
+        logger.trace(std::span<const float>(samples));
+        logger.template trace<"{} = {}">(std::string_view(characters), 7);
+
+        // Serialize
+        const std::string data = serialize(logger);
+
+        // Check output: complete records, the last ones capped at 16 bytes
+        try
+        {
+            const LogModel model(std::istringstream{data}, LoggerUnitTest::s_symbolFilePath, format);
+            const std::vector<LogModel::Record> &records = model.records();
+            QVERIFY(records.size() > 2u);
+            QVERIFY(records.size() < traceCount);
+            for (std::size_t r = 0u; r + 2u < records.size(); ++r)
+            {
+                const int i = std::any_cast<int>(records.at(r).args.at(1));
+                QCOMPARE(std::any_cast<std::string>(records.at(r).args.at(0)), characters.substr(0u, std::min(static_cast<std::size_t>(i) % 20u, std::size_t{16u})));
+                QCOMPARE(i, traceCount - static_cast<int>(records.size() - 2u - r));
+            }
+            QCOMPARE(std::any_cast<std::vector<float>>(records.at(records.size() - 2u).args.at(0)), std::vector<float>(samples.begin(), samples.end()));
+            QCOMPARE(records.back().message, "0123456789abcdef... = 7");
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::tracePayloads_data()
+{
+    QTest::addColumn<int>("logger");
+    QTest::newRow("Logger") << 0;
+    QTest::newRow("IndexedLogger") << 1;
+    QTest::newRow("MirroredLogger") << 2;
+}
+void LoggerUnitTest::tracePayloads()
+{
+    QFETCH(int, logger);
+    switch (logger)
+    {
+    case 0:
+        tracePayloadsImpl<Logger<10u, Clocks::HighResolution, Details::CircularBuffer<10u>, 16u>>(LogDecoder::Format::Plain);
+        break;
+    case 1:
+        tracePayloadsImpl<Logger<10u, Clocks::HighResolution, Details::CircularBuffer<10u, true>, 16u>>(LogDecoder::Format::Indexed);
+        break;
+    case 2:
+        tracePayloadsImpl<Logger<12u, Clocks::HighResolution, Details::CircularBuffer<12u, false, Details::MirroredStorage>, 16u>>(LogDecoder::Format::Plain);
+        break;
+    }
+}
+
+template <typename L>
+struct TraceFilteredTestClass
+{
+    L logger;
+    void noisy(const int i) __attribute__((noinline))
+    {
+        logger.template trace<Level::Debug>(i);
+    }
+    void quiet(const int i) __attribute__((noinline))
+    {
+        logger.template trace<Level::Warning, "quiet {}">(i);
+    }
+};
+template <typename Logger>
+void traceFilteredImpl(const LogDecoder::Format format)
+{
+    if constexpr (requires(Logger l) { l.template trace<Level::Warning, "{}">(0); })
+    {
+        // Test program: switch call sites by function name and by address
+        TraceFilteredTestClass<Logger> test;
+        test.noisy(1);
+        test.quiet(2);
+        QVERIFY(LogDecoder::setCallSitesEnabled("::noisy", false) > 0u);
+        test.noisy(3);
+        test.quiet(4);
+        CallSites::setAllEnabled(false);
+        test.noisy(5);
+        test.quiet(6);
+        CallSites::setAllEnabled(true);
+        test.noisy(7);
+        test.quiet(8);
+
+        // Serialize
+        const std::string data = serialize(test.logger);
+
+        // Check output: disabled call sites wrote nothing, levels survive
+        try
+        {
+            const LogModel model(std::istringstream{data}, LoggerUnitTest::s_symbolFilePath, format);
+            const std::vector<LogModel::Record> &records = model.records();
+            QCOMPARE(records.size(), 5u);
+            const std::array<int, 5> expected{1, 2, 4, 7, 8};
+            for (std::size_t r = 0u; r < records.size(); ++r)
+            {
+                QCOMPARE(std::any_cast<int>(records.at(r).args.at(0)), expected[r]);
+                QCOMPARE(records.at(r).level, std::optional<Level>(expected[r] % 2 == 0 ? Level::Warning : Level::Debug));
+            }
+            QCOMPARE(records.at(2).message, "quiet 4");
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::traceFiltered_data()
+{
+    QTest::addColumn<int>("logger");
+    QTest::newRow("Logger") << 0;
+    QTest::newRow("CompactLogger") << 1;
+}
+void LoggerUnitTest::traceFiltered()
+{
+    QFETCH(int, logger);
+    switch (logger)
+    {
+    case 0:
+        traceFilteredImpl<Logger<8u>>(LogDecoder::Format::Plain);
+        break;
+    case 1:
+        traceFilteredImpl<CompactLogger<8u>>(LogDecoder::Format::Compact16);
+        break;
+    }
+}
+
+template <typename Logger>
+void traceSampledImpl(const LogDecoder::Format format)
+{
+    if constexpr (requires(Logger l) { l.template sample<Sampling::OneIn<4u>, "{}">(0); })
+    {
+        // Test program: each loop is one call site with its own state
+        Logger logger;
+        for (int i = 0; i < 10; ++i)
+        {
+            logger.template sample<Sampling::OneIn<4u>>(i);
+        }
+        for (int i = 0; i < 10; ++i)
+        {
+            logger.template sample<Sampling::FirstThenEvery<2u, 3u>>(i);
+        }
+        for (int i = 0; i < 10; ++i)
+        {
+            logger.template sample<Sampling::RateLimit<1u, 2u>>(i);
+        }
+        logger.template sample<Sampling::OneIn<4u>, "sampled {}">(42);
+        logger.trace(5);
+
+        // Serialize
+        const std::string data = serialize(logger);
+
+        // Check output: the admitted traces, each with the number dropped right before
+        try
+        {
+            const LogModel model(std::istringstream{data}, LoggerUnitTest::s_symbolFilePath, format);
+            const std::vector<LogModel::Record> &records = model.records();
+            const std::vector<std::pair<int, std::uint64_t>> expected{{0, 0u}, {4, 3u}, {8, 3u}, {0, 0u}, {1, 0u}, {4, 2u}, {7, 2u}, {0, 0u}, {1, 0u}, {42, 0u}, {5, 0u}};
+            QCOMPARE(records.size(), expected.size());
+            for (std::size_t r = 0u; r < records.size(); ++r)
+            {
+                QCOMPARE(records.at(r).args.size(), 1u);
+                QCOMPARE(std::any_cast<int>(records.at(r).args.at(0)), expected[r].first);
+                QCOMPARE(records.at(r).suppressed, expected[r].second);
+            }
+            QCOMPARE(records.at(9).message, "sampled 42");
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::traceSampled_data()
+{
+    QTest::addColumn<int>("logger");
+    QTest::newRow("Logger") << 0;
+    QTest::newRow("CompactLogger") << 1;
+}
+void LoggerUnitTest::traceSampled()
+{
+    QFETCH(int, logger);
+    switch (logger)
+    {
+    case 0:
+        traceSampledImpl<Logger<10u>>(LogDecoder::Format::Plain);
+        break;
+    case 1:
+        traceSampledImpl<CompactLogger<10u>>(LogDecoder::Format::Compact16);
+        break;
+    }
+}
+template <typename Logger>
+void traceSpansImpl(const LogDecoder::Format format)
+{
+    if constexpr (requires(Logger l) { l.template span<"{}">(0); })
+    {
+        // Test program: a span that encloses two others
+        Logger logger;
+        {
+            const auto outer = logger.template span<"outer {}">(1);
+            {
+                const auto inner = logger.span(2);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            const auto second = logger.template span<"second">();
+        }
+        logger.trace(3);
+
+        // Serialize
+        const std::string data = serialize(logger);
+
+        // Check output: a record per span when it ends, at the time it started
+        try
+        {
+            const LogModel model(std::istringstream{data}, LoggerUnitTest::s_symbolFilePath, format);
+            const std::vector<LogModel::Record> &records = model.records();
+            QCOMPARE(records.size(), 4u);
+            const LogModel::Record &inner = records.at(0);
+            const LogModel::Record &second = records.at(1);
+            const LogModel::Record &outer = records.at(2);
+            QVERIFY(inner.span && second.span && outer.span && !records.at(3).span);
+            QCOMPARE(std::any_cast<int>(inner.args.at(0)), 2);
+            QCOMPARE(second.message, "second");
+            QCOMPARE(outer.message, "outer 1");
+            QCOMPARE(inner.span->depth, 1u);
+            QCOMPARE(second.span->depth, 1u);
+            QCOMPARE(outer.span->depth, 0u);
+            QCOMPARE(inner.span->thread, outer.span->thread);
+            QVERIFY(inner.span->duration >= 1'000'000);
+            QVERIFY(outer.time <= inner.time && inner.time + inner.span->duration <= second.time);
+            QVERIFY(second.time + second.span->duration <= outer.time + outer.span->duration);
+            QVERIFY(inner.address != outer.address && inner.address != second.address);
+
+            // Latencies per call site, stacks with the time of each span itself
+            LogDecoder::SymbolIndex symbols(LoggerUnitTest::s_symbolFilePath);
+            LogDecoder::Decoder decoder(data, symbols, format);
+            LogDecoder::SpanStatistics spans(symbols);
+            LogDecoder::Record record;
+            while (decoder.next(record))
+            {
+                spans.add(record);
+            }
+            QCOMPARE(spans.callSites().size(), 3u);
+            const LogDecoder::LatencyHistogram &latencies = spans.callSites().at(inner.address).latencies;
+            QCOMPARE(latencies.count(), 1u);
+            QCOMPARE(latencies.percentile(0.5), inner.span->duration);
+            std::ostringstream stacks;
+            spans.writeStacksTo(stacks);
+            const std::string &outerName = spans.callSites().at(outer.address).name;
+            QVERIFY(outerName.ends_with(" outer {}"));
+            const std::string expected = outerName + ' ' + std::to_string(outer.span->duration - inner.span->duration - second.span->duration) + '\n'
+                                         + outerName + ';' + spans.callSites().at(inner.address).name + ' ' + std::to_string(inner.span->duration) + '\n'
+                                         + outerName + ';' + spans.callSites().at(second.address).name + ' ' + std::to_string(second.span->duration) + '\n';
+            QCOMPARE(stacks.str(), expected);
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::traceSpans_data()
+{
+    QTest::addColumn<int>("logger");
+    QTest::newRow("Logger") << 0;
+    QTest::newRow("IndexedLogger") << 1;
+}
+void LoggerUnitTest::traceSpans()
+{
+    QFETCH(int, logger);
+    switch (logger)
+    {
+    case 0:
+        traceSpansImpl<Logger<10u>>(LogDecoder::Format::Plain);
+        break;
+    case 1:
+        traceSpansImpl<IndexedLogger<10u>>(LogDecoder::Format::Indexed);
+        break;
+    }
+}
+
+template <typename Logger>
+void exportTraceEventsImpl()
+{
+    if constexpr (requires(Logger l) { l.template span<"{}">(0); l.template trace<Level::Warning, "{}">(std::string_view{}); })
+    {
+        // Test program: a span around a trace that needs escaping
+        Logger logger;
+        {
+            const auto span = logger.template span<"request {}">(7);
+            logger.template trace<Level::Warning, "quote \"{}\"">(std::string_view("a\\b\n"));
+            logger.trace(1.5, true);
+        }
+
+        // Serialize
+        const std::string data = serialize(logger);
+
+        // Check output: one event per record, after the name of the thread
+        try
+        {
+            LogDecoder::SymbolIndex symbols(LoggerUnitTest::s_symbolFilePath);
+            LogDecoder::Decoder decoder(data, symbols);
+            std::ostringstream s;
+            LogDecoder::TraceEventWriter events(s, symbols);
+            LogDecoder::Record record;
+            while (decoder.next(record))
+            {
+                events.write(record);
+            }
+            events.finish();
+            const std::string json = s.str();
+            QVERIFY(json.starts_with("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"));
+            QVERIFY(json.ends_with("}}\n]}\n"));
+            QVERIFY(json.find(R"("cat":"Warning","ph":"i","s":"t",)") != std::string::npos);
+            QVERIFY(json.find(R"("args":{"message":"quote \"a\\b\n\"","arg0":"a\\b\n"}})") != std::string::npos);
+            QVERIFY(json.find(R"("args":{"arg0":1.5,"arg1":true}})") != std::string::npos);
+            QVERIFY(json.find(R"("cat":"trace","ph":"X","dur":)") != std::string::npos);
+            QVERIFY(json.find(R"("args":{"message":"request 7","arg0":7}})") != std::string::npos);
+            QCOMPARE(std::count(json.begin(), json.end(), '\n'), 6);
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::exportTraceEvents()
+{
+    exportTraceEventsImpl<Logger<10u>>();
+}
+
+template <typename Logger>
+void compressSegmentsImpl(const LogDecoder::Format format)
+{
+    if constexpr (requires(Logger l) { l.template trace<int, short, double>({}, {}, {}); })
+    {
+        // Test program: counters, a constant, a double and, where supported, a string payload
+        Logger logger;
+        for (int i = 0; i < 1000; ++i)
+        {
+            logger.trace(i, static_cast<short>(-i), 0.5);
+            if constexpr (requires { logger.trace(std::string_view{}); })
+            {
+                if (i % 100 == 0)
+                {
+                    logger.trace(std::string_view("key"), i);
+                }
+            }
+        }
+
+        // Serialize
+        const std::string data = serialize(logger);
+
+        // Check output: segments of 300 records decompress into the same records
+        try
+        {
+            LogDecoder::SymbolIndex symbols(LoggerUnitTest::s_symbolFilePath);
+            const auto print = [&symbols](const std::span<const char> dump, const LogDecoder::Format dumpFormat) {
+                LogDecoder::Decoder decoder(dump, symbols, dumpFormat);
+                std::ostringstream s;
+                LogDecoder::Record record;
+                while (decoder.next(record))
+                {
+                    s << record.time << ' ' << record.address << '(';
+                    for (std::size_t a = 0u; a < record.argumentCount(); ++a)
+                    {
+                        record.printArgument(s, a);
+                        s << ',';
+                    }
+                    s << ")\n";
+                }
+                return s.str();
+            };
+
+            std::ostringstream stream;
+            LogDecoder::SegmentWriter segments(stream, 300u);
+            LogDecoder::Decoder decoder(data, symbols, format);
+            segments.writeDumpHeader(decoder.header());
+            LogDecoder::Record record;
+            while (decoder.nextAny(record))
+            {
+                segments.write(record);
+            }
+            segments.finish();
+            QCOMPARE(segments.writtenBytes(), stream.str().size());
+            QVERIFY((segments.writtenBytes() - decoder.header().size()) * 3u < segments.plainBytes() - decoder.header().size());
+
+            std::string decompressed;
+            LogDecoder::decompress(stream.str(), decompressed);
+            QCOMPARE(decompressed.size(), segments.plainBytes());
+            if (format == LogDecoder::Format::Plain)
+            {
+                QVERIFY(decompressed == data);
+            }
+            QCOMPARE(print(decompressed, LogDecoder::Format::Plain), print(data, format));
+
+            // A corrupt segment is rejected
+            std::string corrupt = stream.str();
+            corrupt.resize(corrupt.size() - 1u);
+            bool rejected = false;
+            try
+            {
+                LogDecoder::decompress(corrupt, decompressed);
+            }
+            catch (const std::runtime_error &)
+            {
+                rejected = true;
+            }
+            QVERIFY(rejected);
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::compressSegments_data()
+{
+    QTest::addColumn<int>("logger");
+    QTest::newRow("Logger") << 0;
+    QTest::newRow("CompactLogger") << 1;
+}
+void LoggerUnitTest::compressSegments()
+{
+    QFETCH(int, logger);
+    switch (logger)
+    {
+    case 0:
+        compressSegmentsImpl<Logger<16u>>(LogDecoder::Format::Plain);
+        break;
+    case 1:
+        compressSegmentsImpl<CompactLogger<16u>>(LogDecoder::Format::Compact16);
+        break;
+    }
+}
+
+template <typename Logger>
+void decodeWithoutSymbolsImpl(const LogDecoder::Format format)
+{
+    if constexpr (requires(Logger l) { l.template span<"{}">(0); l.template sample<Sampling::OneIn<2u>>(short{}); })
+    {
+        // Test program: arguments, a payload, a format, a level, a sampled trace and a span
+        Logger logger;
+        logger.trace(true, 42, 1.5);
+        logger.template trace<Level::Warning, "{} of {}">(std::string_view("abc"), 7u);
+        logger.template sample<Sampling::OneIn<2u>>(short{3});
+        {
+            const auto span = logger.template span<"request {}">(9);
+        }
+
+        // Serialize
+        const std::string data = serialize(logger);
+
+        // Check output: the type table of the dump describes every record
+        try
+        {
+            LogDecoder::SymbolIndex symbols;
+            LogDecoder::Decoder decoder(data, symbols, format);
+            LogDecoder::Record record;
+            const auto message = [&record] {
+                std::ostringstream s;
+                record.printMessage(s);
+                return s.str();
+            };
+            QVERIFY(decoder.next(record));
+            QCOMPARE(record.argumentCount(), 3u);
+            QCOMPARE(record.argument<bool>(0u), true);
+            QCOMPARE(record.argument<int>(1u), 42);
+            QCOMPARE(record.argument<double>(2u), 1.5);
+            QVERIFY(decoder.next(record));
+            QCOMPARE(record.type->level, std::optional<Level>(Level::Warning));
+            QCOMPARE(message(), "abc of 7");
+            QVERIFY(decoder.next(record));
+            QVERIFY(record.type->sampled);
+            QCOMPARE(record.suppressed(), 0u);
+            QCOMPARE(record.argument<short>(0u), short{3});
+            QVERIFY(decoder.next(record));
+            QVERIFY(record.span);
+            QCOMPARE(message(), "request 9");
+            QVERIFY(!decoder.next(record));
+
+            // Check output: the build id picks the symbol file
+            const LogDecoder::SymbolIndex fileSymbols(LoggerUnitTest::s_symbolFilePath);
+            QVERIFY(!decoder.buildId().empty());
+            QVERIFY(std::ranges::equal(decoder.buildId(), fileSymbols.buildId()));
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::decodeWithoutSymbols_data()
+{
+    QTest::addColumn<int>("logger");
+    QTest::newRow("Logger") << 0;
+    QTest::newRow("IndexedLogger") << 1;
+}
+void LoggerUnitTest::decodeWithoutSymbols()
+{
+    QFETCH(int, logger);
+    switch (logger)
+    {
+    case 0:
+        decodeWithoutSymbolsImpl<Logger<10u>>(LogDecoder::Format::Plain);
+        break;
+    case 1:
+        decodeWithoutSymbolsImpl<IndexedLogger<10u>>(LogDecoder::Format::Indexed);
+        break;
+    }
+}
+
+template <typename Logger>
+void snapshotConcurrentImpl(const LogDecoder::Format format)
+{
+    if constexpr (requires(Logger l, std::ostream &s) { l.template trace<int, int>({}, {}); l.snapshotTo(s); })
+    {
+        // Test: snapshots while two threads keep tracing
+        Logger logger;
+        constexpr int tracesPerThread = 10000;
+        std::atomic<int> writing{2};
+        const auto write = [&logger, &writing] {
+            for (int i = 0; i < tracesPerThread; ++i)
+            {
+                logger.trace(i, ~i);
+                if (i % 64 == 0)
+                {
+                    std::this_thread::yield(); // interleave with the snapshots, also on a single core
+                }
+            }
+            --writing;
+        };
+        std::thread first(write);
+        std::thread second(write);
+        std::vector<std::string> snapshots;
+        do
+        {
+            std::ostringstream stream;
+            logger.snapshotTo(stream);
+            snapshots.push_back(stream.str());
+        } while (writing > 0);
+        first.join();
+        second.join();
+
+        // Check output: every record is complete
+        try
+        {
+            for (const std::string &data : snapshots)
+            {
+                const LogModel model(std::istringstream{data}, LoggerUnitTest::s_symbolFilePath, format);
+                for (const LogModel::Record &record : model.records())
+                {
+                    QCOMPARE(record.args.size(), 2u);
+                    QCOMPARE(std::any_cast<int>(record.args.at(1)), ~std::any_cast<int>(record.args.at(0)));
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::snapshotConcurrent_data()
+{
+    QTest::addColumn<int>("logger");
+    QTest::newRow("Logger") << 0;
+    QTest::newRow("ShardedLogger, wrapping") << 1;
+    QTest::newRow("CompactLogger") << 2;
+}
+void LoggerUnitTest::snapshotConcurrent()
+{
+    QFETCH(int, logger);
+    switch (logger)
+    {
+    case 0:
+        // NOTE: large enough not to wrap, such that the snapshot starts at a record
+        snapshotConcurrentImpl<Logger<20u>>(LogDecoder::Format::Plain);
+        break;
+    case 1:
+        snapshotConcurrentImpl<ShardedLogger<12u>>(LogDecoder::Format::Sharded);
+        break;
+    case 2:
+        snapshotConcurrentImpl<CompactLogger<20u>>(LogDecoder::Format::Compact16);
+        break;
+    }
+}
+
+template <typename Logger>
+void traceWrappedImpl(const LogDecoder::Format format, const std::size_t bufferSize)
+{
+    if constexpr (requires(Logger l) { l.template trace<int>({}); })
+    {
+        // Test: wraps several times, in the middle of a record
+        Logger logger;
+        constexpr int traceCount = 1000;
+        for (int i = 0; i < traceCount; ++i)
+        {
+            logger.trace(i);
+        }
+
+        // Serialize
+        const std::string data = serialize(logger);
+
+        // Check output: starts at a complete record, at most a block is lost
+        try
+        {
+            const LogModel model(std::istringstream{data}, LoggerUnitTest::s_symbolFilePath, format);
+            const std::vector<LogModel::Record> &records = model.records();
+            QVERIFY(records.size() >= bufferSize * 7 / 8 / (sizeof(std::int64_t) + 2 * sizeof(uintptr_t) + sizeof(int)));
+            for (std::size_t i = 0u; i < records.size(); ++i)
+            {
+                QCOMPARE(std::any_cast<int>(records.at(i).args.at(0)), traceCount - static_cast<int>(records.size() - i));
+            }
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::traceWrapped_data()
+{
+    QTest::addColumn<int>("logger");
+    QTest::newRow("Logger") << 0;
+    QTest::newRow("CompactLogger") << 1;
+    QTest::newRow("IndexedLogger") << 2;
+    QTest::newRow("MirroredLogger") << 3;
+}
+void LoggerUnitTest::traceWrapped()
+{
+    QFETCH(int, logger);
+    switch (logger)
+    {
+    case 0:
+        traceWrappedImpl<Logger<11u>>(LogDecoder::Format::Plain, 1u << 11u);
+        break;
+    case 1:
+        traceWrappedImpl<CompactLogger<11u>>(LogDecoder::Format::Compact16, 1u << 11u);
+        break;
+    case 2:
+        traceWrappedImpl<IndexedLogger<11u>>(LogDecoder::Format::Indexed, 1u << 11u);
+        break;
+    case 3:
+        // NOTE: the smallest buffer that is a multiple of the page size
+        traceWrappedImpl<MirroredLogger<12u>>(LogDecoder::Format::Plain, 1u << 12u);
+        break;
+    }
+}
+
+template <typename Logger>
+void seekIndexedImpl()
+{
+    if constexpr (requires(Logger l) { l.template trace<int>({}); })
+    {
+        // Test
+        Logger logger;
+        for (int i = 0; i < 1000; ++i)
+        {
+            logger.trace(i);
+        }
+
+        // Serialize
+        const std::string data = serialize(logger);
+
+        // Check output: chunks from every offset decode into the same records
+        try
+        {
+            LogDecoder::SymbolIndex symbols(LoggerUnitTest::s_symbolFilePath);
+            LogDecoder::Decoder decoder(data, symbols, LogDecoder::Format::Indexed);
+            std::vector<int> all;
+            LogDecoder::Record record;
+            while (decoder.next(record))
+            {
+                all.push_back(record.argument<int>(0u));
+            }
+            QVERIFY(!all.empty());
+            QCOMPARE(all.back(), 999);
+
+            for (std::size_t chunkCount : {2u, 3u, 7u, 64u})
+            {
+                std::vector<int> chunked;
+                const std::size_t chunkSize = decoder.size() / chunkCount + 1u;
+                for (std::size_t chunk = 0u; chunk < chunkCount; ++chunk)
+                {
+                    LogDecoder::Decoder part(data, symbols, LogDecoder::Format::Indexed);
+                    part.seek(chunk * chunkSize);
+                    const std::size_t end = part.boundaryAt((chunk + 1u) * chunkSize);
+                    QVERIFY(end - part.offset() <= chunkSize + 1024u); // at most a block further
+                    while (part.offset() < end && part.next(record))
+                    {
+                        chunked.push_back(record.argument<int>(0u));
+                    }
+                }
+                QVERIFY(chunked == all);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::seekIndexed()
+{
+    seekIndexedImpl<IndexedLogger<14u>>();
+}
+
+template <typename Logger>
+void streamToFileImpl()
+{
+    if constexpr (requires(Logger l) { l.template trace<int>({}); l.buffer().lostBytes(); })
+    {
+        // Test: many times the buffer, faster than the flusher can keep up with at times
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "LoggerUnitTest.stream";
+        constexpr int traceCount = 200000;
+        std::uint64_t lostBytes = 0u;
+        {
+            Logger logger(path.string());
+            for (int i = 0; i < traceCount; ++i)
+            {
+                logger.trace(i);
+            }
+            logger.buffer().stop();
+            lostBytes = logger.buffer().lostBytes();
+            QCOMPARE(std::filesystem::file_size(path), logger.buffer().writtenBytes());
+        }
+
+        // Check output: complete records in order, every byte either written or lost
+        try
+        {
+            const LogModel model(std::ifstream(path, std::ios::binary), LoggerUnitTest::s_symbolFilePath);
+            const std::vector<LogModel::Record> &records = model.records();
+            constexpr std::size_t recordSize = sizeof(std::int64_t) + 2 * sizeof(uintptr_t) + sizeof(int);
+            QCOMPARE(records.size() * recordSize + lostBytes, traceCount * recordSize);
+            for (std::size_t i = 1u; i < records.size(); ++i)
+            {
+                QVERIFY(std::any_cast<int>(records.at(i - 1u).args.at(0)) < std::any_cast<int>(records.at(i).args.at(0)));
+            }
+            qDebug() << "Lost records:" << lostBytes / recordSize;
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+        std::filesystem::remove(path);
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::streamToFile_data()
+{
+    QTest::addColumn<bool>("drop");
+    QTest::newRow("Overwrite") << false;
+    QTest::newRow("Drop") << true;
+}
+void LoggerUnitTest::streamToFile()
+{
+    QFETCH(bool, drop);
+    if (drop)
+    {
+        streamToFileImpl<StreamingLogger<16u, Clocks::HighResolution, Details::Overflow::Drop>>();
+    }
+    else
+    {
+        streamToFileImpl<StreamingLogger<16u>>();
+    }
+}
+
+template <typename Logger>
+void triggerSnapshotsImpl()
+{
+    if constexpr (requires(Logger l) { l.template trigger<"{}">(0); l.buffer().template triggerWhen<int>([](int) { return true; }); })
+    {
+        const std::filesystem::path marked = std::filesystem::temp_directory_path() / "LoggerUnitTest.marked";
+        const std::filesystem::path watched = std::filesystem::temp_directory_path() / "LoggerUnitTest.watched";
+        const auto persisted = [](const auto &buffer) {
+            for (int i = 0; i < 1000 && buffer.persistedCount() == 0u; ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return buffer.persistedCount();
+        };
+        const auto read = [](const std::filesystem::path &path) { return LogModel(std::ifstream(path, std::ios::binary), LoggerUnitTest::s_symbolFilePath).records(); };
+
+        // Test program: a marked call site, the second trigger within the interval is refused
+        Logger markedLogger(marked.string(), std::chrono::hours(1));
+        for (int i = 0; i < 100; ++i)
+        {
+            markedLogger.trace(i);
+        }
+        markedLogger.template trigger<"timeout {}">(100);
+        markedLogger.template trigger<"timeout {}">(101);
+        markedLogger.trace(102);
+        QCOMPARE(persisted(markedLogger.buffer()), 1u);
+        QCOMPARE(markedLogger.buffer().refusedCount(), 1u);
+
+        // Test program: a predicate on the arguments of trace(int)
+        Logger watchedLogger(watched.string(), std::chrono::nanoseconds(0));
+        watchedLogger.buffer().template triggerWhen<int>([](const int value) { return value == 7; });
+        for (int i = 0; i < 10; ++i)
+        {
+            watchedLogger.trace(i);
+            watchedLogger.trace(static_cast<unsigned>(i) + 7u);
+        }
+        QCOMPARE(persisted(watchedLogger.buffer()), 1u);
+
+        // Check output: each snapshot ends with the trigger, the writers went on in the spare buffer
+        try
+        {
+            const std::vector<LogModel::Record> markedRecords = read(marked.string() + ".0");
+            QCOMPARE(markedRecords.size(), 101u);
+            for (int i = 0; i < 100; ++i)
+            {
+                QCOMPARE(std::any_cast<int>(markedRecords.at(static_cast<std::size_t>(i)).args.at(0)), i);
+            }
+            QCOMPARE(markedRecords.back().message, "timeout 100");
+            const LogModel markedRest(std::istringstream{serialize(markedLogger)}, LoggerUnitTest::s_symbolFilePath);
+            QCOMPARE(markedRest.records().size(), 2u);
+            QCOMPARE(markedRest.records().at(0).message, "timeout 101");
+
+            const std::vector<LogModel::Record> watchedRecords = read(watched.string() + ".0");
+            QCOMPARE(watchedRecords.size(), 15u);
+            QCOMPARE(std::any_cast<int>(watchedRecords.back().args.at(0)), 7);
+            const LogModel watchedRest(std::istringstream{serialize(watchedLogger)}, LoggerUnitTest::s_symbolFilePath);
+            QCOMPARE(watchedRest.records().size(), 5u);
+            QCOMPARE(std::any_cast<unsigned>(watchedRest.records().at(0).args.at(0)), 14u);
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+        std::filesystem::remove(marked.string() + ".0");
+        std::filesystem::remove(watched.string() + ".0");
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::triggerSnapshots()
+{
+    triggerSnapshotsImpl<TriggeredLogger<12u>>();
+}
+
+template <typename Logger>
+void foldRepeatsImpl()
+{
+    if constexpr (requires(Logger l) { l.fold(0); l.template fold<"poll {}">(0); l.flushRepeats(); })
+    {
+        // Test program: a retry loop, then two call sites that alternate, left open until the flush
+        Logger logger;
+        for (int i = 0; i < 1001; ++i)
+        {
+            logger.fold(i < 1000 ? 7 : 8, 0.5);
+        }
+        for (int i = 0; i < 100; ++i)
+        {
+            logger.template fold<"poll {}">(1);
+            logger.template fold<"status {}">(2u);
+        }
+        logger.flushRepeats();
+        logger.flushRepeats();
+
+        // Check output: each run takes its first record and one with the repeats, at the time of the last one
+        try
+        {
+            const LogModel model(std::istringstream{serialize(logger)}, LoggerUnitTest::s_symbolFilePath);
+            const std::vector<LogModel::Record> &records = model.records();
+            QCOMPARE(records.size(), 7u);
+            QCOMPARE(std::any_cast<int>(records[0].args.at(0)), 7);
+            QCOMPARE(records[1].message, "repeated 999 more times");
+            QVERIFY(records[1].time >= records[0].time);
+            QCOMPARE(std::any_cast<int>(records[2].args.at(0)), 8);
+            QVERIFY(records[2].time >= records[1].time);
+            QCOMPARE(records[3].message, "poll 1");
+            QCOMPARE(records[4].message, "status 2");
+            QCOMPARE(records[5].message, "repeated 99 more times");
+            QCOMPARE(records[6].message, "repeated 99 more times");
+            QVERIFY(records[5].address != records[6].address);
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+
+        // Test program: one call site in a logger that is gone, in two loggers, and in a thread that ends in a run
+        const auto retry = [](Logger &logger, const int value) __attribute__((noinline)) { logger.fold(value); };
+        {
+            Logger gone;
+            retry(gone, 1);
+            retry(gone, 1);
+        }
+        Logger second;
+        Logger third;
+        retry(second, 1);
+        retry(second, 1);
+        retry(third, 1);
+        std::thread([&retry, &third] {
+            retry(third, 2);
+            retry(third, 2);
+        }).join();
+
+        // Check output: each logger starts its own run, the repeats go to the logger of the run
+        try
+        {
+            const LogModel secondModel(std::istringstream{serialize(second)}, LoggerUnitTest::s_symbolFilePath);
+            QCOMPARE(secondModel.records().size(), 2u);
+            QCOMPARE(std::any_cast<int>(secondModel.records()[0].args.at(0)), 1);
+            QCOMPARE(secondModel.records()[1].message, "repeated 1 more times");
+            const LogModel thirdModel(std::istringstream{serialize(third)}, LoggerUnitTest::s_symbolFilePath);
+            QCOMPARE(thirdModel.records().size(), 3u);
+            QCOMPARE(std::any_cast<int>(thirdModel.records()[0].args.at(0)), 1);
+            QCOMPARE(std::any_cast<int>(thirdModel.records()[1].args.at(0)), 2);
+            QCOMPARE(thirdModel.records()[2].message, "repeated 1 more times");
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::foldRepeats()
+{
+    foldRepeatsImpl<Logger<16u>>();
+    // NOTE: fold needs neither the room for a summary of aggregate nor a buffer that takes a payload
+    Logger<10u>{}.fold(1);
+    ShardedLogger<12u>{}.fold(1);
+}
+
+template <typename Logger>
+constexpr bool aggregates = requires(Logger l) { l.aggregate(0); };
+
+template <typename Logger>
+void aggregateValuesImpl()
+{
+    if constexpr (requires(Logger l) { l.aggregate(0); l.template aggregate<"queue depth">(0.0); l.setAggregationInterval(std::chrono::seconds(1)); l.flushAggregates(); })
+    {
+        // Test program: values of two call sites, one of them with a summary per value
+        Logger logger;
+        for (int i = 0; i < 1000; ++i)
+        {
+            logger.template aggregate<"queue depth">(i);
+        }
+        logger.flushAggregates();
+        logger.flushAggregates();
+        logger.setAggregationInterval(std::chrono::nanoseconds(0));
+        for (const double value : {-1.5, 2.5, 1e30})
+        {
+            logger.aggregate(value);
+        }
+        logger.flushAggregates();
+
+        // Check output: a summary of the first call site, one per value of the second
+        try
+        {
+            const LogModel model(std::istringstream{serialize(logger)}, LoggerUnitTest::s_symbolFilePath);
+            const std::vector<LogModel::Record> &records = model.records();
+            QCOMPARE(records.size(), 4u);
+            QVERIFY(records[0].message.starts_with("queue depth: 1000 values, min 0, max 999, mean 499.5, p50 <= 511, p99 <= 999, buckets from 0: [1, 1, 1, 1, 1, 1, 1, 1, 2, 2,"));
+            const auto buckets = std::any_cast<std::vector<std::uint32_t>>(records[0].args.at(7));
+            QCOMPARE(buckets.size(), Details::AggregateState::bucketOf(999u) + 1u);
+            QCOMPARE(std::accumulate(buckets.begin(), buckets.end(), 0u), 1000u);
+            for (std::size_t bucket = 0u; bucket < buckets.size(); ++bucket)
+            {
+                QCOMPARE(buckets[bucket], std::min<std::uint64_t>(Details::AggregateState::upperBound(bucket), 999u) - Details::AggregateState::lowerBound(bucket) + 1u);
+            }
+            QCOMPARE(records[1].message, "1 values, min -1.5, max -1.5, mean -1.5, p50 <= -1.5, p99 <= -1.5, buckets from 0: [1]");
+            QCOMPARE(records[2].message, "1 values, min 2.5, max 2.5, mean 2.5, p50 <= 2.5, p99 <= 2.5, buckets from 2: [1]");
+            QCOMPARE(std::any_cast<std::uint16_t>(records[3].args.at(6)), Details::AggregateState::bucketCount - 1u);
+            QVERIFY(records[1].address == records[3].address && records[0].address != records[1].address);
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+
+        // Test program: one call site in a logger that is gone, in two loggers, in a thread that ends, and next to an idle one
+        const auto depth = [](Logger &logger, const int value) __attribute__((noinline)) { logger.template aggregate<"depth">(value); };
+        const auto size = [](Logger &logger, const int value) __attribute__((noinline)) { logger.template aggregate<"size">(value); };
+        {
+            Logger gone;
+            depth(gone, 100);
+        }
+        Logger second;
+        Logger third;
+        depth(second, 1);
+        depth(second, 2);
+        depth(third, 3);
+        std::thread([&depth, &third] { depth(third, 4); }).join();
+        Logger fourth;
+        fourth.setAggregationInterval(std::chrono::milliseconds(1));
+        size(fourth, 5);
+        depth(fourth, 6);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        depth(fourth, 7);
+        fourth.flushAggregates();
+
+        // Check output: each logger only summarizes its own values, a due summary also writes the idle one
+        try
+        {
+            const LogModel secondModel(std::istringstream{serialize(second)}, LoggerUnitTest::s_symbolFilePath);
+            QCOMPARE(secondModel.records().size(), 1u);
+            QVERIFY(secondModel.records()[0].message.starts_with("depth: 2 values, min 1, max 2,"));
+            const LogModel thirdModel(std::istringstream{serialize(third)}, LoggerUnitTest::s_symbolFilePath);
+            QCOMPARE(thirdModel.records().size(), 2u);
+            QVERIFY(thirdModel.records()[0].message.starts_with("depth: 1 values, min 4,"));
+            QVERIFY(thirdModel.records()[1].message.starts_with("depth: 1 values, min 3,"));
+            const LogModel fourthModel(std::istringstream{serialize(fourth)}, LoggerUnitTest::s_symbolFilePath);
+            QCOMPARE(fourthModel.records().size(), 3u);
+            QVERIFY(fourthModel.records()[0].message.starts_with("depth: 1 values, min 6,"));
+            QVERIFY(fourthModel.records()[1].message.starts_with("size: 1 values, min 5,"));
+            QVERIFY(fourthModel.records()[2].message.starts_with("depth: 1 values, min 7,"));
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::aggregateValues()
+{
+    aggregateValuesImpl<Logger<16u>>();
+    static_assert(!aggregates<ShardedLogger<12u>>);
+}
+
+template <typename Logger>
+void traceAtThreadExitImpl()
+{
+    if constexpr (requires(Logger l) { l.template trace<int>({}); })
+    {
+        // Test program: the destructor of a thread_local traces after those of the logger are gone
+        struct LateTrace
+        {
+            ~LateTrace()
+            {
+                if (m_logger != nullptr)
+                {
+                    m_logger->trace(2);
+                }
+            }
+            Logger *m_logger = nullptr;
+        };
+        Logger logger;
+        std::thread([&logger] {
+            static thread_local LateTrace late;
+            late.m_logger = &logger;
+            logger.trace(1);
+        }).join();
+        std::ostringstream snapshot;
+        logger.snapshotTo(snapshot);
+
+        // Check output: both records
+        try
+        {
+            const LogModel model(std::istringstream{snapshot.str()}, LoggerUnitTest::s_symbolFilePath);
+            const std::vector<LogModel::Record> &records = model.records();
+            QCOMPARE(records.size(), 2u);
+            QCOMPARE(std::any_cast<int>(records[0].args.at(0)), 1);
+            QCOMPARE(std::any_cast<int>(records[1].args.at(0)), 2);
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::traceAtThreadExit_data()
+{
+    QTest::addColumn<int>("logger");
+    QTest::newRow("Logger") << 0;
+    QTest::newRow("CountingLogger") << 1;
+}
+void LoggerUnitTest::traceAtThreadExit()
+{
+    QFETCH(int, logger);
+    switch (logger)
+    {
+    case 0:
+        traceAtThreadExitImpl<Logger<16u>>();
+        break;
+    case 1:
+        traceAtThreadExitImpl<CountingLogger<16u>>();
+        break;
+    }
+}
+
+template <typename Logger>
+void countCallSitesImpl()
+{
+    if constexpr (requires(Logger l) { l.traceStatistics(); l.buffer().callSiteCounts(); })
+    {
+        // Test program: a noisy call site in four threads, a payload and a span
+        Logger logger;
+        {
+            std::vector<std::jthread> threads;
+            for (int t = 0; t < 4; ++t)
+            {
+                threads.emplace_back([&logger] {
+                    for (int i = 0; i < 1000; ++i)
+                    {
+                        logger.trace(i);
+                    }
+                });
+            }
+        }
+        for (int i = 0; i < 10; ++i)
+        {
+            logger.template trace<"key {}">(std::string_view("abcd"));
+        }
+        {
+            const auto span = logger.span(1);
+        }
+        std::ostringstream snapshot;
+        logger.snapshotTo(snapshot);
+
+        // Check output: the counts of each call site, the noisy one first, add up to the bytes of the buffer
+        const std::vector<CallSiteCount> counts = logger.buffer().callSiteCounts();
+        QCOMPARE(counts.size(), 3u);
+        QCOMPARE(counts[0].records, 4000u);
+        QCOMPARE(counts[0].bytes, 4000u * (sizeof(std::int64_t) + 2 * sizeof(uintptr_t) + sizeof(int)));
+        QCOMPARE(counts[1].records + counts[2].records, 11u);
+        const LoggerStatistics statistics = logger.buffer().statistics();
+        QCOMPARE(statistics.reservedBytes, counts[0].bytes + counts[1].bytes + counts[2].bytes);
+        constexpr std::size_t bufferSize = std::remove_reference_t<decltype(logger.buffer())>::bufferSize;
+        QCOMPARE(statistics.wrapCount, statistics.reservedBytes / bufferSize);
+        QCOMPARE(statistics.overwrittenBytes, statistics.reservedBytes - bufferSize);
+        QCOMPARE(statistics.snapshotCount, 1u);
+        QVERIFY(statistics.maxSnapshotDuration > 0);
+
+        // Check output: the records of traceStatistics carry the address of each call site
+        logger.traceStatistics();
+        logger.traceStatistics();
+        try
+        {
+            const LogModel model(std::istringstream{serialize(logger)}, LoggerUnitTest::s_symbolFilePath);
+            std::vector<LogModel::Record> summaries;
+            std::ranges::copy_if(model.records(), std::back_inserter(summaries), [](const LogModel::Record &record) { return record.message.ends_with(" bytes") && !record.message.starts_with("logger:"); });
+            QCOMPARE(summaries.size(), 5u);
+            const auto noisy = std::ranges::find(summaries, counts[0].callSite->m_traceCallSite, &LogModel::Record::address);
+            QVERIFY(noisy != summaries.end());
+            QCOMPARE(noisy->message, "4000 records, " + std::to_string(counts[0].bytes) + " bytes");
+            const auto logged = std::ranges::count_if(model.records(), [](const LogModel::Record &record) { return record.message.starts_with("logger: "); });
+            QCOMPARE(logged, 2);
+            QVERIFY(summaries[4].message.starts_with("1 records, "));
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::countCallSites()
+{
+    countCallSitesImpl<CountingLogger<12u>>();
+}
+
+template <typename Logger>
+void traceInlineFunctionImpl(void (*const traceInline)(int), void (*const traceElsewhere)(int), Logger &logger, const LogDecoder::Format format)
+{
+    // Test program: the inline function of the header is called from both translation units,
+    // the linker keeps one of its copies
+    traceInline(1);
+    traceElsewhere(2);
+
+    // Serialize
+    const std::string data = serialize(logger);
+
+    // Check output: both traces come from the copy that was kept
+    try
+    {
+        const LogModel model(std::istringstream{data}, LoggerUnitTest::s_symbolFilePath, format);
+        const std::vector<LogModel::Record> &records = model.records();
+        QCOMPARE(records.size(), 2u);
+        QCOMPARE(std::any_cast<int>(records.at(0).args.at(0)), 1);
+        QCOMPARE(std::any_cast<int>(records.at(1).args.at(0)), 2);
+        QCOMPARE(records.at(0).address, records.at(1).address);
+        QCONTAINS(model.resolveFunction(records.at(0).address), "traceInline");
+    }
+    catch (const std::exception &e)
+    {
+        QFAIL(e.what());
+    }
+}
+void LoggerUnitTest::traceInlineFunction_data()
+{
+    QTest::addColumn<int>("logger");
+    QTest::newRow("Logger") << 0;
+    QTest::newRow("CompactLogger") << 1;
+}
+void LoggerUnitTest::traceInlineFunction()
+{
+    QFETCH(int, logger);
+    switch (logger)
+    {
+    case 0:
+        traceInlineFunctionImpl(&traceInline, &traceInlineElsewhere, inlineLogger(), LogDecoder::Format::Plain);
+        break;
+    case 1:
+        traceInlineFunctionImpl(&traceInlineCompact, &traceInlineCompactElsewhere, inlineCompactLogger(), LogDecoder::Format::Compact16);
+        break;
+    }
+}
+
+template <typename Logger>
+void queryStoreImpl()
+{
+    if constexpr (requires(Logger l) { l.template trace<"marker {}">(0); })
+    {
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / "LoggerUnitTest.store";
+        std::filesystem::remove_all(directory);
+
+        // Test program: a counter, with a marker every 100 records from another call site
+        Logger logger;
+        for (int i = 0; i < 2000; ++i)
+        {
+            logger.trace(i);
+            if (i % 100 == 0)
+            {
+                logger.template trace<"marker {}">(i);
+            }
+        }
+
+        // Serialize
+        const std::string data = serialize(logger);
+
+        // Check output: the budget keeps the latest segments, the queries find the same records as a scan
+        try
+        {
+            struct Traced
+            {
+                std::int64_t time;
+                std::uintptr_t address;
+                int value;
+                bool operator==(const Traced &) const = default;
+            };
+            LogDecoder::SymbolIndex symbols(LoggerUnitTest::s_symbolFilePath);
+            std::vector<Traced> traced;
+            {
+                LogDecoder::Decoder decoder(data, symbols);
+                LogDecoder::StoreWriter writer(directory.string(), decoder.header(), 40u << 10, 16u << 10, 1u << 10);
+                LogDecoder::Record record;
+                while (decoder.nextAny(record))
+                {
+                    writer.write(record);
+                    if (record.type->special == LogDecoder::TraceType::Special::None)
+                    {
+                        traced.push_back({record.time, record.address, record.argument<int>(0u)});
+                    }
+                }
+                writer.finish();
+                QVERIFY(writer.removedCount() > 0u);
+                QVERIFY(writer.storedBytes() <= 40u << 10);
+            }
+
+            const LogDecoder::StoreReader store(directory.string());
+            QVERIFY(store.segments().size() >= 2u);
+            const auto query = [&store, &symbols](const LogDecoder::StoreQuery &storeQuery) {
+                std::vector<Traced> found;
+                const std::uint64_t count = store.query(storeQuery, symbols, [&found](const LogDecoder::Record &record) {
+                    found.push_back({record.time, record.address, record.argument<int>(0u)});
+                });
+                return count == found.size() ? found : std::vector<Traced>{};
+            };
+            const std::vector<Traced> kept = query({});
+            QVERIFY(!kept.empty() && kept.size() < traced.size());
+            QVERIFY(std::ranges::equal(kept, std::span(traced).last(kept.size())));
+            QCOMPARE(kept.back().value, 1999);
+
+            const std::int64_t from = kept[kept.size() / 4u].time;
+            const std::int64_t to = kept[kept.size() / 2u].time;
+            std::vector<Traced> expected;
+            std::ranges::copy_if(kept, std::back_inserter(expected), [from, to](const Traced &t) { return t.time >= from && t.time <= to; });
+            QCOMPARE(query({from, to, std::nullopt}), expected);
+
+            const std::uintptr_t marker = std::ranges::find_if(kept, [](const Traced &t) { return t.value % 100 == 0; })->address;
+            expected.clear();
+            std::ranges::copy_if(kept, std::back_inserter(expected), [marker](const Traced &t) { return t.address == marker; });
+            QVERIFY(expected.size() >= 2u);
+            QCOMPARE(query({.address = marker}), expected);
+            QVERIFY(query({kept.back().time + 1, std::numeric_limits<std::int64_t>::max(), std::nullopt}).empty());
+
+            // Writing again continues the sequence after the kept segments, which the budget removes
+            LogDecoder::Decoder decoder(data, symbols);
+            LogDecoder::StoreWriter writer(directory.string(), decoder.header(), 40u << 10, 16u << 10, 1u << 10);
+            LogDecoder::Record record;
+            while (decoder.nextAny(record))
+            {
+                writer.write(record);
+            }
+            writer.finish();
+            const LogDecoder::StoreReader again(directory.string());
+            QVERIFY(again.segments().front().sequence > store.segments().back().sequence);
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+        std::filesystem::remove_all(directory);
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::queryStore()
+{
+    queryStoreImpl<Logger<16u>>();
+}
+
+template <typename Logger>
+void recoverMappedImpl(const bool calibrated)
+{
+    if constexpr (requires(Logger l) { l.template trace<int>({}); })
+    {
+        // Test program: dies without any chance to dump the buffer
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "LoggerUnitTest.ring";
+        constexpr int traceCount = 1000;
+        const pid_t child = fork();
+        QVERIFY(child >= 0);
+        if (child == 0)
+        {
+            Logger logger(path.string());
+            for (int i = 0; i < traceCount; ++i)
+            {
+                logger.trace(i);
+            }
+            kill(getpid(), SIGKILL);
+        }
+        int status = 0;
+        QCOMPARE(waitpid(child, &status, 0), child);
+        QVERIFY(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL);
+
+        // Check output: the newest records survived, in order
+        try
+        {
+            const LogDecoder::MappedFile file(path.string());
+            const LogDecoder::RecoveredRing ring = LogDecoder::recover(file.data());
+            QVERIFY(std::ranges::equal(ring.buildId, Details::buildId()));
+            QCOMPARE(ring.calibration.has_value(), calibrated);
+
+            LogDecoder::SymbolIndex symbols(LoggerUnitTest::s_symbolFilePath);
+            LogDecoder::Decoder decoder(ring.records, symbols);
+            if (ring.calibration)
+            {
+                decoder.setCalibration(*ring.calibration);
+            }
+            std::vector<int> values;
+            for (LogDecoder::Record record; decoder.next(record);)
+            {
+                values.push_back(record.argument<int>(0u));
+            }
+            QVERIFY(values.size() > 1u);
+            QVERIFY(values.size() < traceCount);
+            QCOMPARE(values.back(), traceCount - 1);
+            for (std::size_t i = 1u; i < values.size(); ++i)
+            {
+                QCOMPARE(values.at(i), values.at(i - 1u) + 1);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+        std::filesystem::remove(path);
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::recoverMapped_data()
+{
+    QTest::addColumn<bool>("cycleCounter");
+    QTest::newRow("HighResolution") << false;
+    QTest::newRow("CycleCounter") << true;
+}
+void LoggerUnitTest::recoverMapped()
+{
+    QFETCH(bool, cycleCounter);
+    if (cycleCounter)
+    {
+        recoverMappedImpl<MappedLogger<12u, Clocks::CycleCounter>>(true);
+    }
+    else
+    {
+        recoverMappedImpl<MappedLogger<12u>>(false);
+    }
+}
+
+void LoggerUnitTest::collectShared()
+{
+    if constexpr (requires(SharedLogger<12u> l) { l.template trace<int>({}); })
+    {
+        // Test program: traces, waits until the collector got the first records, traces and exits
+        const std::string name = "LoggerUnitTest";
+        int toParent[2];
+        int toChild[2];
+        QVERIFY(pipe(toParent) == 0 && pipe(toChild) == 0);
+        char token = 0;
+        const pid_t child = fork();
+        QVERIFY(child >= 0);
+        if (child == 0)
+        {
+            SharedLogger<12u, Clocks::CycleCounter> logger(name);
+            for (int i = 0; i < 100; ++i)
+            {
+                logger.trace(i);
+            }
+            if (write(toParent[1], &token, 1u) != 1 || read(toChild[0], &token, 1u) != 1)
+            {
+                _exit(1);
+            }
+            for (int i = 100; i < 200; ++i)
+            {
+                logger.trace(i);
+            }
+            _exit(0);
+        }
+        QCOMPARE(read(toParent[0], &token, 1u), 1);
+
+        // Collect while the child lives, and after it exited
+        std::string records;
+        std::optional<LogDecoder::SharedRing> ring;
+        std::uint64_t lostBytes = 0u;
+        const LogDecoder::Collector::Sink sink = [&](const LogDecoder::SharedRing &shared, const std::span<const char> collected, const std::uint64_t lost) {
+            if (shared.header.pid == static_cast<std::uint64_t>(child))
+            {
+                ring = shared;
+                records.append(collected.data(), collected.size());
+                lostBytes += lost;
+            }
+        };
+        LogDecoder::Collector collector;
+        collector.poll(sink);
+        QCOMPARE(records.size(), 100u * (sizeof(std::int64_t) + 2 * sizeof(uintptr_t) + sizeof(int)));
+        QCOMPARE(write(toChild[1], &token, 1u), 1);
+        int status = 0;
+        QCOMPARE(waitpid(child, &status, 0), child);
+        QVERIFY(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        collector.poll(sink);
+        for (const int fd : {toParent[0], toParent[1], toChild[0], toChild[1]})
+        {
+            close(fd);
+        }
+
+        // Check output: every record once, the ring removed
+        try
+        {
+            QVERIFY(ring.has_value());
+            QCOMPARE(ring->name, name);
+            QVERIFY(std::ranges::equal(ring->header.buildId, Details::buildId()));
+            QVERIFY(ring->header.calibration.has_value());
+            QVERIFY(!std::filesystem::exists(ring->path));
+            QCOMPARE(lostBytes, 0u);
+
+            LogDecoder::SymbolIndex symbols(LoggerUnitTest::s_symbolFilePath);
+            LogDecoder::Decoder decoder(records, symbols);
+            decoder.setCalibration(*ring->header.calibration);
+            int expected = 0;
+            for (LogDecoder::Record record; decoder.next(record); ++expected)
+            {
+                QCOMPARE(record.argument<int>(0u), expected);
+            }
+            QCOMPARE(expected, 200);
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+
+void LoggerUnitTest::collectInFlight()
+{
+    if constexpr (requires(SharedLogger<12u> l) { l.template trace<int>({}); })
+    {
+        // Test program: a writer stays in flight in the last slot of the ring, then the logger is created again
+        const std::string name = "LoggerUnitTest.inFlight";
+        std::uint64_t recordCount = 0u;
+        const LogDecoder::Collector::Sink sink = [&](const LogDecoder::SharedRing &shared, const std::span<const char> collected, std::uint64_t) {
+            if (shared.header.pid == static_cast<std::uint64_t>(getpid()) && shared.name == name)
+            {
+                recordCount += collected.size() / (sizeof(std::int64_t) + 2 * sizeof(uintptr_t) + sizeof(int));
+            }
+        };
+        const auto setLastSlot = [](const std::string &path, const std::uint64_t sequence) {
+            const int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+            const off_t offset = static_cast<off_t>(Details::MappedStorage<12u>::writerSlotsOffset + (Details::MappedHeader::maxWriterSlots - 1u) * sizeof(Details::MappedWriterSlot));
+            const bool written = fd >= 0 && pwrite(fd, &sequence, sizeof(sequence), offset) == sizeof(sequence);
+            close(fd);
+            return written;
+        };
+        LogDecoder::Collector collector;
+        std::string path;
+        {
+            SharedLogger<12u> logger(name);
+            path = std::string(Details::s_sharedRingDirectory) + '/' + std::string(Details::s_sharedRingPrefix) + std::to_string(getpid()) + '.' + name;
+            QVERIFY(setLastSlot(path, 1u));
+            for (int i = 0; i < 10; ++i)
+            {
+                logger.trace(i);
+            }
+
+            // Check output: nothing while the writer is in flight, then the records before and after
+            collector.poll(sink);
+            QCOMPARE(recordCount, 0u);
+            for (int i = 10; i < 20; ++i)
+            {
+                logger.trace(i);
+            }
+            collector.poll(sink);
+            QCOMPARE(recordCount, 0u);
+            QVERIFY(setLastSlot(path, 2u));
+            collector.poll(sink);
+            QCOMPARE(recordCount, 20u);
+        }
+        SharedLogger<12u> logger(name);
+        for (int i = 0; i < 5; ++i)
+        {
+            logger.trace(i);
+        }
+
+        // Check output: the records of the logger of the same name
+        collector.poll(sink);
+        collector.poll(sink);
+        QCOMPARE(recordCount, 25u);
+        std::filesystem::remove(path);
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+
+void crashDumpImpl(const int signal)
+{
+    if constexpr (requires(Logger<12u> l, Details::FileDescriptorStream s) { l.buffer().writeLiveTo(s); })
+    {
+        // Test program: two loggers, one calibrated, then a fatal signal
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "LoggerUnitTest.crash";
+        constexpr int traceCount = 1000;
+        constexpr std::uintptr_t faultAddress = 16u;
+        const pid_t child = fork();
+        QVERIFY(child >= 0);
+        if (child == 0)
+        {
+            const rlimit noCore{0u, 0u};
+            setrlimit(RLIMIT_CORE, &noCore);
+            Logger<12u> logger;
+            Logger<10u, Clocks::CycleCounter> calibratedLogger;
+            const CrashHandler::Registration registration(logger);
+            const CrashHandler::Registration calibratedRegistration(calibratedLogger);
+            CrashHandler::install(path.string());
+            for (int i = 0; i < traceCount; ++i)
+            {
+                logger.trace(i);
+                calibratedLogger.trace(i);
+            }
+            if (signal == SIGSEGV)
+            {
+                volatile std::uintptr_t address = faultAddress;
+                *reinterpret_cast<volatile int *>(address) = 0;
+            }
+            std::abort();
+        }
+        int status = 0;
+        QCOMPARE(waitpid(child, &status, 0), child);
+        QVERIFY(WIFSIGNALED(status));
+        QCOMPARE(WTERMSIG(status), signal);
+
+        // Check output: the newest records of both loggers, in order
+        try
+        {
+            const LogDecoder::MappedFile file(path.string());
+            const LogDecoder::CrashDump dump = LogDecoder::readCrashDump(file.data());
+            QCOMPARE(dump.signal, signal);
+            if (signal == SIGSEGV)
+            {
+                QCOMPARE(dump.faultAddress, faultAddress);
+            }
+            QCOMPARE(dump.threadId, static_cast<std::uint64_t>(child));
+            QCOMPARE(dump.loggers.size(), std::size_t{2u});
+            QVERIFY(!dump.loggers.at(0).calibration.has_value());
+            QVERIFY(dump.loggers.at(1).calibration.has_value());
+
+            LogDecoder::SymbolIndex symbols(LoggerUnitTest::s_symbolFilePath);
+            for (const LogDecoder::RecoveredRing &ring : dump.loggers)
+            {
+                QVERIFY(std::ranges::equal(ring.buildId, Details::buildId()));
+                QCOMPARE(ring.lostBytes, std::uint64_t{0u});
+                LogDecoder::Decoder decoder(ring.records, symbols);
+                if (ring.calibration)
+                {
+                    decoder.setCalibration(*ring.calibration);
+                }
+                std::vector<int> values;
+                for (LogDecoder::Record record; decoder.next(record);)
+                {
+                    values.push_back(record.argument<int>(0u));
+                }
+                QVERIFY(values.size() > 1u);
+                QCOMPARE(values.back(), traceCount - 1);
+                for (std::size_t i = 1u; i < values.size(); ++i)
+                {
+                    QCOMPARE(values.at(i), values.at(i - 1u) + 1);
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            QFAIL(e.what());
+        }
+        std::filesystem::remove(path);
+    }
+    else
+    {
+        QFAIL("Does not compile");
+    }
+}
+void LoggerUnitTest::crashDump_data()
+{
+    QTest::addColumn<int>("signal");
+    QTest::newRow("SIGSEGV") << SIGSEGV;
+    QTest::newRow("SIGABRT") << SIGABRT;
+}
+void LoggerUnitTest::crashDump()
+{
+    QFETCH(int, signal);
+    crashDumpImpl(signal);
+}
+
 QTEST_APPLESS_MAIN(LoggerUnitTest)
@@ -26,6 +26,73 @@ private slots:
 
     void traceMulti();
 
+    void traceSharded();
+    void traceShardedWrapped();
+
+    void cycleCounterCalibration();
+
+    void compactHeader();
+    void compactWrappedPeriods();
+
+    void decodeFormats_data();
+    void decodeFormats();
+
+    void traceFormatted_data();
+    void traceFormatted();
+
+    void tracePayloads_data();
+    void tracePayloads();
+
+    void traceFiltered_data();
+    void traceFiltered();
+
+    void traceSampled_data();
+    void traceSampled();
+
+    void traceSpans_data();
+    void traceSpans();
+
+    void exportTraceEvents();
+
+    void compressSegments_data();
+    void compressSegments();
+
+    void decodeWithoutSymbols_data();
+    void decodeWithoutSymbols();
+
+    void snapshotConcurrent_data();
+    void snapshotConcurrent();
+
+    void traceWrapped_data();
+    void traceWrapped();
+    void seekIndexed();
+
+    void streamToFile_data();
+    void streamToFile();
+
+    void triggerSnapshots();
+
+    void queryStore();
+
+    void countCallSites();
+    void traceInlineFunction_data();
+    void traceInlineFunction();
+
+    void foldRepeats();
+    void aggregateValues();
+
+    void traceAtThreadExit_data();
+    void traceAtThreadExit();
+
+    void recoverMapped_data();
+    void recoverMapped();
+
+    void collectShared();
+    void collectInFlight();
+
+    void crashDump_data();
+    void crashDump();
+
 public:
     static const std::string s_symbolFilePath;
 };
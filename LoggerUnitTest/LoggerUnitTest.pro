@@ -2,10 +2,24 @@ QT = core testlib
 
 include("../GlobalSettings.pri")
 
+HEADERS += InlineTraces.h
 HEADERS += LoggerUnitTest.h
+SOURCES += InlineTraces.cpp
 SOURCES += LoggerUnitTest.cpp
 
 DEFINES += ARM
+HEADERS += ../Logger/CompactLogger.h
+HEADERS += ../Logger/CountingLogger.h
+HEADERS += ../Logger/CrashHandler.h
 HEADERS += ../Logger/Logger.h
+HEADERS += ../Logger/MappedLogger.h
+HEADERS += ../Logger/MirroredLogger.h
+HEADERS += ../Logger/ShardedLogger.h
+HEADERS += ../Logger/SharedLogger.h
+HEADERS += ../Logger/StreamingLogger.h
+HEADERS += ../Logger/TriggeredLogger.h
 
-include("../Private/Private.pri")
+include("../LogDecoder/LogDecoder.pri")
+
+# Symbols to decode the traces with, see LoggerUnitTest::s_symbolFilePath
+QMAKE_POST_LINK += objcopy --only-keep-debug $${TARGETFILEPATH} $${TARGETFILEPATH}.syms
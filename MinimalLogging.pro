@@ -1,6 +1,15 @@
-TEMPLATE = subdirs
-
-SUBDIRS += ExistingApproaches
-SUBDIRS += LoggerUnitTest
-
-OTHER_FILES += GlobalSettings.pri
+TEMPLATE = subdirs
+
+SUBDIRS += ComparisonBenchmark
+SUBDIRS += ExistingApproaches
+SUBDIRS += LogDecoder
+SUBDIRS += LogDecoderTool
+SUBDIRS += LoggerUnitTest
+SUBDIRS += LoggerBenchmark
+
+LogDecoderTool.depends = LogDecoder
+LoggerUnitTest.depends = LogDecoder
+LoggerBenchmark.depends = LogDecoder
+ComparisonBenchmark.depends = LogDecoder
+
+OTHER_FILES += GlobalSettings.pri